@@ -1,5 +1,6 @@
 #include <iostream>
 #include <time.h>
+#include <vector>
 
 #include <src/autodiff/autodiff.hpp>
 #include <src/scalar/functions.hpp>
@@ -11,6 +12,7 @@ using namespace nomad;
 double elapsed_secs(const clock_t& start);
 void validate_funnel();
 void time_funnel();
+void time_large_funnel();
 void validate_matrix();
 void time_matrix();
 void validate_dot();
@@ -41,6 +43,33 @@ public:
   }
 };
 
+template <typename T>
+class large_funnel_func: public base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    
+    eigen_idx_t N = x.size() - 1;
+    
+    T v = x[0];
+    
+    std::vector<T> y(N);
+    for (eigen_idx_t n = 0; n < N; ++n)
+      y[n] = x[n + 1];
+    
+    T sum_x2 = 0.0;
+    
+    for (eigen_idx_t n = 0; n < N; ++n)
+      sum_x2 += square(y[n]);
+    
+    T p1 = 0.5 * N * v;
+    T p2 = 0.5 * sum_x2 * exp(-v);
+    T p3 = 0.5 * square(v) / 9.0;
+    
+    return p1 + p2 + p3;
+    
+  }
+};
+
 template <typename T, int N>
 class debug_func: public base_functor<T> {
 public:
@@ -162,6 +191,53 @@ void time_funnel() {
   
 }
 
+// Times gradients of the funnel with 10^5 to 10^6 inputs, with the stacks
+// backed by regular and by huge pages
+void time_large_funnel() {
+  
+  clock_t start;
+  double deltaT;
+  
+  large_funnel_func<var1> first_order_funnel;
+  
+  const bool huge_pages_setting = stack_huge_pages_;
+  
+  for (eigen_idx_t N = 100000; N <= 1000000; N *= 10) {
+    
+    int n_calls = static_cast<int>(10000000 / N);
+    
+    Eigen::VectorXd x = Eigen::VectorXd::Ones(N + 1);
+    
+    double f;
+    Eigen::VectorXd grad(x.size());
+    
+    for (int huge_pages = 0; huge_pages < 2; ++huge_pages) {
+      
+      stack_huge_pages_ = huge_pages;
+      
+      // Fresh stacks, reserved with the current page setting
+      autodiff_context context;
+      autodiff_context::scope bound(context);
+      
+      gradient(first_order_funnel, x, f, grad);
+      
+      start = clock();
+      for (int n = 0; n < n_calls; ++n)
+        gradient(first_order_funnel, x, f, grad);
+      deltaT = elapsed_secs(start);
+      
+      std::cout << n_calls << " gradients with " << N << " inputs and "
+                << (huge_pages ? "huge" : "regular") << " pages took "
+                << deltaT << " seconds" << std::endl;
+      
+    }
+    
+  }
+  
+  stack_huge_pages_ = huge_pages_setting;
+  
+}
+
 void validate_funnel() {
   
   Eigen::VectorXd x = Eigen::VectorXd::Ones(6);
@@ -386,6 +462,7 @@ int main(int argc, const char * argv[]) {
   
   //validate_funnel();
   time_funnel();
+  //time_large_funnel();
   
   //validate_matrix();
   //time_matrix();
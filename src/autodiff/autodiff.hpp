@@ -3,9 +3,22 @@
 
 #include <src/autodiff/autodiff_stack.hpp>
 #include <src/autodiff/base_functor.hpp>
+#include <src/autodiff/batch.hpp>
+#include <src/autodiff/compact.hpp>
+#include <src/autodiff/edge_pushing.hpp>
 #include <src/autodiff/exceptions.hpp>
 #include <src/autodiff/first_order.hpp>
+#include <src/autodiff/hessian_sparsity.hpp>
+#include <src/autodiff/level_schedule.hpp>
+#include <src/autodiff/parallel.hpp>
+#include <src/autodiff/parallel_sum.hpp>
+#include <src/autodiff/pipeline.hpp>
+#include <src/autodiff/preaccumulate.hpp>
+#include <src/autodiff/recorded_point.hpp>
 #include <src/autodiff/second_order.hpp>
+#include <src/autodiff/sparse_hessian.hpp>
+#include <src/autodiff/stack_capacity.hpp>
+#include <src/autodiff/tape.hpp>
 #include <src/autodiff/third_order.hpp>
 #include <src/autodiff/typedefs.hpp>
 #include <src/autodiff/validation.hpp>
@@ -9,55 +9,227 @@
 #define unlikely(x) (x)
 #endif
 
+#include <atomic>
+#include <string>
+#include <utility>
 #include <vector>
 #include <type_traits>
 
-#include <src/autodiff/typedefs.hpp>
 #include <src/autodiff/exceptions.hpp>
+#include <src/autodiff/stack_arena.hpp>
+#include <src/autodiff/typedefs.hpp>
 
 namespace nomad {
   
   void reset();
   void expand_var_nodes();
-  template<short AutodiffOrder> void expand_dual_numbers();
+  nomad_idx_t expand_dual_numbers(std::size_t min_nodes, std::size_t target_nodes);
   void expand_partials();
   void expand_inputs();
 
   class var_node_base;
   
   nomad_idx_t base_node_size_ = 100000;
+  nomad_idx_t base_partials_size_ = 100000;
+  nomad_idx_t base_inputs_size_ = 100000;
   
-  var_node_base* var_nodes_;
-  nomad_idx_t next_node_idx_ = 1;
-  nomad_idx_t max_node_idx = 0;
+  // Nodes store their number of inputs in 24 bits
+  const nomad_idx_t max_node_inputs = (1U << 24) - 1;
   
-  double* dual_numbers_;
-  nomad_idx_t next_dual_number_idx_ = 1;
-  nomad_idx_t max_dual_number_idx = 0;
+  // While track_high_water_mark_ is set, reset() records the largest stacks
+  // seen on any thread, and stacks grow straight to that size when first used
+  std::atomic<bool> track_high_water_mark_(false);
+  std::atomic<nomad_idx_t> high_water_node_idx_(0);
+  std::atomic<nomad_idx_t> high_water_partials_idx_(0);
+  std::atomic<nomad_idx_t> high_water_inputs_idx_(0);
   
-  nomad_idx_t base_partials_size_ = 100000;
+  // The stacks below hold the current expression graph of the calling thread.
+  // Every node constructor, push_* method, and sweep operates on them, so
+  // independent threads record and sweep their own graphs without locking.
+  // Each stack lives in its own reserved address range, see stack_arena.hpp,
+  // with max_*_idx marking the committed size and reserved_*_idx the size
+  // of the reservation.
   
-  double* partials_;
-  nomad_idx_t next_partials_idx_ = 1;
-  nomad_idx_t next_partials_delta = 0;
-  nomad_idx_t max_partials_idx = 0;
+  thread_local var_node_base* var_nodes_ = 0;
+  thread_local nomad_idx_t next_node_idx_ = 1;
+  thread_local nomad_idx_t max_node_idx = 0;
+  thread_local nomad_idx_t reserved_node_idx = 0;
   
-  nomad_idx_t base_inputs_size_ = 100000;
+  thread_local double* dual_numbers_ = 0;
+  thread_local nomad_idx_t next_dual_number_idx_ = 1;
+  thread_local nomad_idx_t max_dual_number_idx = 0;
+  thread_local nomad_idx_t reserved_dual_number_idx = 0;
+  thread_local nomad_idx_t dual_lane_stride_ = 0;
+  
+  thread_local double* partials_ = 0;
+  thread_local nomad_idx_t next_partials_idx_ = 1;
+  thread_local nomad_idx_t next_partials_delta = 0;
+  thread_local nomad_idx_t max_partials_idx = 0;
+  thread_local nomad_idx_t reserved_partials_idx = 0;
+  
+  thread_local nomad_idx_t* inputs_ = 0;
+  thread_local nomad_idx_t next_inputs_idx_ = 1;
+  thread_local nomad_idx_t next_inputs_delta = 0;
+  thread_local nomad_idx_t max_inputs_idx = 0;
+  thread_local nomad_idx_t reserved_inputs_idx = 0;
+  
+  // Scratch tangents of the multi-direction sweeps, see direction_numbers.hpp
+  thread_local double* direction_numbers_ = 0;
+  thread_local nomad_idx_t max_direction_number_idx = 0;
+  thread_local nomad_idx_t reserved_direction_number_idx = 0;
+  
+  void release_stacks();
+  
+  // Frees the stacks of a thread when that thread exits
+  class thread_stacks_guard {
+  public:
+    inline void touch() {}
+    ~thread_stacks_guard() { release_stacks(); }
+  };
+  
+  thread_local thread_stacks_guard thread_stacks_guard_;
+  
+  // An independent expression graph that can be bound to the calling thread,
+  // either to keep a recorded graph alive while another is constructed or
+  // to record a graph on one thread and sweep it on another.
+  class autodiff_context {
+  public:
+    
+    autodiff_context():
+    var_nodes_(0), next_node_idx_(1), max_node_idx(0), reserved_node_idx(0),
+    dual_numbers_(0), next_dual_number_idx_(1), max_dual_number_idx(0),
+    reserved_dual_number_idx(0), dual_lane_stride_(0),
+    partials_(0), next_partials_idx_(1), next_partials_delta(0), max_partials_idx(0),
+    reserved_partials_idx(0),
+    inputs_(0), next_inputs_idx_(1), next_inputs_delta(0), max_inputs_idx(0),
+    reserved_inputs_idx(0),
+    direction_numbers_(0), max_direction_number_idx(0), reserved_direction_number_idx(0),
+    committed_stack_bytes_(0) {}
+    
+    ~autodiff_context() {
+      swap();
+      release_stacks();
+      swap();
+    }
+    
+    autodiff_context(const autodiff_context&) = delete;
+    autodiff_context& operator=(const autodiff_context&) = delete;
+    
+    // Binds the context to the calling thread for the lifetime of the scope,
+    // restoring the previously bound expression graph on exit
+    class scope {
+    public:
+      explicit scope(autodiff_context& context): context_(context) { context_.swap(); }
+      ~scope() { context_.swap(); }
+      
+      scope(const scope&) = delete;
+      scope& operator=(const scope&) = delete;
+    private:
+      autodiff_context& context_;
+    };
+    
+  private:
+    
+    // Exchanges the stacks held by the context with those of the calling thread
+    void swap() {
+      std::swap(var_nodes_, nomad::var_nodes_);
+      std::swap(next_node_idx_, nomad::next_node_idx_);
+      std::swap(max_node_idx, nomad::max_node_idx);
+      std::swap(reserved_node_idx, nomad::reserved_node_idx);
+      
+      std::swap(dual_numbers_, nomad::dual_numbers_);
+      std::swap(next_dual_number_idx_, nomad::next_dual_number_idx_);
+      std::swap(max_dual_number_idx, nomad::max_dual_number_idx);
+      std::swap(reserved_dual_number_idx, nomad::reserved_dual_number_idx);
+      std::swap(dual_lane_stride_, nomad::dual_lane_stride_);
+      
+      std::swap(partials_, nomad::partials_);
+      std::swap(next_partials_idx_, nomad::next_partials_idx_);
+      std::swap(next_partials_delta, nomad::next_partials_delta);
+      std::swap(max_partials_idx, nomad::max_partials_idx);
+      std::swap(reserved_partials_idx, nomad::reserved_partials_idx);
+      
+      std::swap(inputs_, nomad::inputs_);
+      std::swap(next_inputs_idx_, nomad::next_inputs_idx_);
+      std::swap(next_inputs_delta, nomad::next_inputs_delta);
+      std::swap(max_inputs_idx, nomad::max_inputs_idx);
+      std::swap(reserved_inputs_idx, nomad::reserved_inputs_idx);
+      
+      std::swap(direction_numbers_, nomad::direction_numbers_);
+      std::swap(max_direction_number_idx, nomad::max_direction_number_idx);
+      std::swap(reserved_direction_number_idx, nomad::reserved_direction_number_idx);
+      
+      std::swap(committed_stack_bytes_, nomad::committed_stack_bytes_);
+    }
+    
+    var_node_base* var_nodes_;
+    nomad_idx_t next_node_idx_;
+    nomad_idx_t max_node_idx;
+    nomad_idx_t reserved_node_idx;
+    
+    double* dual_numbers_;
+    nomad_idx_t next_dual_number_idx_;
+    nomad_idx_t max_dual_number_idx;
+    nomad_idx_t reserved_dual_number_idx;
+    nomad_idx_t dual_lane_stride_;
+    
+    double* partials_;
+    nomad_idx_t next_partials_idx_;
+    nomad_idx_t next_partials_delta;
+    nomad_idx_t max_partials_idx;
+    nomad_idx_t reserved_partials_idx;
+    
+    nomad_idx_t* inputs_;
+    nomad_idx_t next_inputs_idx_;
+    nomad_idx_t next_inputs_delta;
+    nomad_idx_t max_inputs_idx;
+    nomad_idx_t reserved_inputs_idx;
+    
+    double* direction_numbers_;
+    nomad_idx_t max_direction_number_idx;
+    nomad_idx_t reserved_direction_number_idx;
+    
+    std::size_t committed_stack_bytes_;
+    
+  };
+  
+  inline void update_high_water_mark(std::atomic<nomad_idx_t>& high_water_idx,
+                                     nomad_idx_t idx) {
+    nomad_idx_t current = high_water_idx.load(std::memory_order_relaxed);
+    while (current < idx
+           && !high_water_idx.compare_exchange_weak(current, idx, std::memory_order_relaxed)) {}
+  }
   
-  nomad_idx_t* inputs_;
-  nomad_idx_t next_inputs_idx_ = 1;
-  nomad_idx_t next_inputs_delta = 0;
-  nomad_idx_t max_inputs_idx = 0;
+  // Size to which a stack grows when it runs out of committed storage
+  inline std::size_t stack_growth_target(nomad_idx_t max_idx, nomad_idx_t base_size,
+                                         const std::atomic<nomad_idx_t>& high_water_idx) {
+    std::size_t target_idx = 2 * std::size_t(max_idx);
+    if (target_idx < base_size) target_idx = base_size;
+    nomad_idx_t high_water = high_water_idx.load(std::memory_order_relaxed);
+    if (target_idx < high_water) target_idx = high_water;
+    return target_idx;
+  }
   
   void reset() {
+    
+    if (track_high_water_mark_.load(std::memory_order_relaxed)) {
+      update_high_water_mark(high_water_node_idx_, next_node_idx_);
+      update_high_water_mark(high_water_partials_idx_, next_partials_idx_);
+      update_high_water_mark(high_water_inputs_idx_, next_inputs_idx_);
+    }
+    
     next_node_idx_ = 1;
     next_dual_number_idx_ = 1;
     next_partials_idx_ = 1;
     next_inputs_idx_ = 1;
+    
   }
   
   template <class Node>
   inline typename std::enable_if<Node::dynamic_inputs(), void>::type create_node(unsigned int n_inputs) {
+    if (unlikely(n_inputs > max_node_inputs))
+      throw nomad_error("Nomad stack construction terminated because a node exceeded "
+                        "the maximum of " + std::to_string(max_node_inputs) + " inputs");
     next_inputs_delta = n_inputs;
     next_partials_delta = Node::n_partials(n_inputs);
     new Node(n_inputs);
@@ -70,30 +242,6 @@ namespace nomad {
     new Node();
   }
   
-  template<short AutodiffOrder, bool ValidateIO>
-  inline void push_dual_numbers(double val) {
-    
-    if (ValidateIO) {
-      if (unlikely(std::isnan(val))) throw nomad_error();
-    }
-
-    dual_numbers_[next_dual_number_idx_++] = val;
-    dual_numbers_[next_dual_number_idx_++] = 0;
-    
-    if (AutodiffOrder >= 2) {
-      dual_numbers_[next_dual_number_idx_++] = 0;
-      dual_numbers_[next_dual_number_idx_++] = 0;
-    }
-    
-    if (AutodiffOrder >= 3) {
-      dual_numbers_[next_dual_number_idx_++] = 0;
-      dual_numbers_[next_dual_number_idx_++] = 0;
-      dual_numbers_[next_dual_number_idx_++] = 0;
-      dual_numbers_[next_dual_number_idx_++] = 0;
-    }
-    
-  }
-  
   template<bool ValidateIO>
   inline void push_partials(double partial) {
     if (ValidateIO) {
@@ -106,60 +254,20 @@ namespace nomad {
     inputs_[next_inputs_idx_++] = input;
   }
   
-  void expand_var_nodes();
-  
-  template<short AutodiffOrder>
-  inline void expand_dual_numbers() {
-    
-    if (!max_dual_number_idx) {
-      max_dual_number_idx = (1 << AutodiffOrder) * base_node_size_;
-      dual_numbers_ = new double[max_dual_number_idx];
-    } else {
-      max_dual_number_idx *= 2;
-      
-      double* new_stack = new double[max_dual_number_idx];
-      for (nomad_idx_t i = 0; i < next_dual_number_idx_; ++i)
-        new_stack[i] = dual_numbers_[i];
-      delete[] dual_numbers_;
-      
-      dual_numbers_ = new_stack;
-    }
-
-  }
-  
   void expand_partials() {
-    
-    if (!max_partials_idx) {
-      max_partials_idx = base_partials_size_;
-      partials_ = new double[max_partials_idx];
-    } else {
-      max_partials_idx *= 2;
-      
-      double* new_stack = new double[max_partials_idx];
-      for (nomad_idx_t i = 0; i < next_partials_idx_; ++i)
-        new_stack[i] = partials_[i];
-      delete[] partials_;
-      
-      partials_ = new_stack;
-    }
-    
+    thread_stacks_guard_.touch();
+    commit_stack(partials_, max_partials_idx, reserved_partials_idx,
+                 std::size_t(next_partials_idx_) + next_partials_delta,
+                 stack_growth_target(max_partials_idx, base_partials_size_,
+                                     high_water_partials_idx_));
   }
   
   void expand_inputs() {
-    if (!max_inputs_idx) {
-      max_inputs_idx = base_inputs_size_;
-      inputs_ = new nomad_idx_t[max_inputs_idx];
-    } else {
-      max_inputs_idx *= 2;
-      
-      nomad_idx_t* new_stack = new nomad_idx_t[max_inputs_idx];
-      for (nomad_idx_t i = 0; i < next_inputs_idx_; ++i)
-        new_stack[i] = inputs_[i];
-      delete[] inputs_;
-      
-      inputs_ = new_stack;
-    }
-    
+    thread_stacks_guard_.touch();
+    commit_stack(inputs_, max_inputs_idx, reserved_inputs_idx,
+                 std::size_t(next_inputs_idx_) + next_inputs_delta,
+                 stack_growth_target(max_inputs_idx, base_inputs_size_,
+                                     high_water_inputs_idx_));
   }
   
 }
@@ -0,0 +1,95 @@
+#ifndef nomad__src__autodiff__batch_hpp
+#define nomad__src__autodiff__batch_hpp
+
+#include <thread>
+#include <type_traits>
+
+#include <Eigen/Core>
+
+#include <src/autodiff/first_order.hpp>
+#include <src/autodiff/parallel.hpp>
+#include <src/autodiff/second_order.hpp>
+
+namespace nomad {
+
+  // Value and gradient of the functional at each column of X, with the
+  // gradient at X.col(k) written to G.col(k).  The points are spread over
+  // the threads of the pool, each recording and sweeping on its own stacks,
+  // so the functional must be safe to call from several threads at once.
+  template <typename F>
+  typename std::enable_if<is_var<typename F::var_type>::value && F::var_type::order() >= 1, void >::type
+  gradient_batch(const F& functional,
+                 const Eigen::MatrixXd& X,
+                 Eigen::VectorXd& f,
+                 Eigen::MatrixXd& G,
+                 thread_pool& pool) {
+
+    const eigen_idx_t d = X.rows();
+
+    pool.for_each(X.cols(), [&](std::size_t n) {
+
+      const eigen_idx_t k = static_cast<eigen_idx_t>(n);
+      const Eigen::VectorXd x = X.col(k);
+      Eigen::VectorXd g(d);
+
+      gradient(functional, x, f(k), g);
+
+      G.col(k) = g;
+
+    });
+
+  }
+
+  template <typename F>
+  void gradient_batch(const F& functional,
+                      const Eigen::MatrixXd& X,
+                      Eigen::VectorXd& f,
+                      Eigen::MatrixXd& G,
+                      std::size_t n_threads = std::thread::hardware_concurrency()) {
+    thread_pool pool(n_threads);
+    gradient_batch(functional, X, f, G, pool);
+  }
+
+  // Value, gradient, and Hessian of the functional at each column of X, with
+  // the Hessian at X.col(k) written to H.block(0, k * d, d, d)
+  template <typename F>
+  typename std::enable_if<is_var<typename F::var_type>::value && F::var_type::order() >= 2, void >::type
+  hessian_batch(const F& functional,
+                const Eigen::MatrixXd& X,
+                Eigen::VectorXd& f,
+                Eigen::MatrixXd& G,
+                Eigen::MatrixXd& H,
+                thread_pool& pool) {
+
+    const eigen_idx_t d = X.rows();
+
+    pool.for_each(X.cols(), [&](std::size_t n) {
+
+      const eigen_idx_t k = static_cast<eigen_idx_t>(n);
+      const Eigen::VectorXd x = X.col(k);
+      Eigen::VectorXd g(d);
+      Eigen::MatrixXd H_k(d, d);
+
+      hessian(functional, x, f(k), g, H_k);
+
+      G.col(k) = g;
+      H.block(0, k * d, d, d) = H_k;
+
+    });
+
+  }
+
+  template <typename F>
+  void hessian_batch(const F& functional,
+                     const Eigen::MatrixXd& X,
+                     Eigen::VectorXd& f,
+                     Eigen::MatrixXd& G,
+                     Eigen::MatrixXd& H,
+                     std::size_t n_threads = std::thread::hardware_concurrency()) {
+    thread_pool pool(n_threads);
+    hessian_batch(functional, X, f, G, H, pool);
+  }
+
+}
+
+#endif
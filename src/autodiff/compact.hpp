@@ -0,0 +1,281 @@
+#ifndef nomad__src__autodiff__compact_hpp
+#define nomad__src__autodiff__compact_hpp
+
+#include <algorithm>
+#include <vector>
+
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/dual_number_layout.hpp>
+#include <src/var/var.hpp>
+#include <src/var/var_node.hpp>
+#include <src/var/replay.hpp>
+
+namespace nomad {
+
+  // First, second, and third partials of a unary node with respect to its
+  // input, given the end of its partials.  Returns false for nodes of other
+  // kinds.
+  inline bool unary_partials(nomad_idx_t node_idx, nomad_idx_t partials_end, double* p) {
+
+    var_node_base& node = var_nodes_[node_idx];
+
+    p[0] = p[1] = p[2] = 0;
+
+    switch (node.opcode() >> 2) {
+
+      case unary_var_node_kind:
+        for (nomad_idx_t k = 0; k < 3 && node.partials() + k < partials_end; ++k)
+          p[k] = node.first_partials(k);
+        return true;
+
+      case unary_minus_var_node_kind:
+        p[0] = -1;
+        return true;
+
+      case unary_plus_var_node_kind:
+        p[0] = 1;
+        return true;
+
+      case square_var_node_kind:
+        p[0] = 2 * var_node_base::first_val(node.input());
+        p[1] = 2;
+        return true;
+
+      default:
+        return false;
+
+    }
+
+  }
+
+  // Whether a node only adds up its inputs
+  inline bool is_sum(nomad_idx_t node_idx) {
+    const unsigned char opcode = var_nodes_[node_idx].opcode();
+    return opcode == var_node_opcode(binary_sum_var_node_kind)
+           || opcode == var_node_opcode(multi_sum_var_node_kind);
+  }
+
+  // Partials of f(g(x)) from those of f and g by Faa di Bruno's formula
+  inline void compose_partials(const double* f, const double* g, double* h) {
+    h[0] = f[0] * g[0];
+    h[1] = f[1] * g[0] * g[0] + f[0] * g[1];
+    h[2] = f[2] * g[0] * g[0] * g[0] + 3 * f[1] * g[0] * g[1] + f[0] * g[2];
+  }
+
+  // Removes the nodes of a freshly recorded graph that the output does not
+  // depend on, so that the sweeps only visit the live nodes.  The first
+  // n_inputs nodes stay in place, the live nodes keep their order, and their
+  // dual numbers, partials, and inputs are moved down the stacks to match.
+  //
+  // Along the way a unary node whose only consumer is another unary node is
+  // folded into that consumer, which becomes a unary_var_node with the
+  // partials of the composition, so that chains such as exp(-v) or
+  // log1p(exp(x)) collapse into a single node.  Likewise a sum whose only
+  // consumer is another sum is flattened into that consumer, which becomes
+  // a multi_sum_var_node, so that a + b + c + ... reads its terms at once.
+  //
+  // Returns the output, which moves along with the other nodes.
+  template<class T_var>
+  T_var compact(const T_var& output, nomad_idx_t n_inputs) {
+
+    const short autodiff_order = T_var::order();
+    const nomad_idx_t n_partials = autodiff_order < 3 ? autodiff_order : 3;
+
+    const nomad_idx_t last = std::max(output.node(), n_inputs);
+    const nomad_idx_t end_partials = next_partials_idx_;
+    const nomad_idx_t end = next_node_idx_;
+
+    // Counts the live consumers of each node, the output counting as one,
+    // and later holds the new position of each live node
+    std::vector<nomad_idx_t> moved(last + 1, 0);
+    moved[output.node()] = 1;
+
+    nomad_idx_t n_live = 0;
+
+    for (nomad_idx_t n = last; n > 0; --n) {
+      if (!moved[n] && n > n_inputs) continue;
+
+      ++n_live;
+
+      for (nomad_idx_t k = 0; k < var_nodes_[n].n_inputs(); ++k)
+        ++moved[input_node<autodiff_order>(n, k)];
+    }
+
+    // Fuses unary chains, recording the input and the partials of each fused
+    // node, with the intermediate nodes left dead
+    std::vector<nomad_idx_t> fused_input;
+    std::vector<double> fused_partials;
+
+    for (nomad_idx_t n = n_inputs + 1; n <= last; ++n) {
+
+      if (!moved[n] || var_nodes_[n].n_inputs() != 1) continue;
+
+      const nomad_idx_t m = input_node<autodiff_order>(n, 0);
+      if (m <= n_inputs || moved[m] != 1) continue;
+
+      double f[3];
+      double g[3];
+
+      if (!unary_partials(n, n + 1 < end ? var_nodes_[n + 1].partials() : end_partials, f)) continue;
+
+      if (fused_input.empty() || !fused_input[m]) {
+        if (var_nodes_[m].n_inputs() != 1 || !unary_partials(m, var_nodes_[m + 1].partials(), g))
+          continue;
+      } else {
+        std::copy(&fused_partials[3 * m], &fused_partials[3 * m] + 3, g);
+      }
+
+      if (fused_input.empty()) {
+        fused_input.resize(last + 1, 0);
+        fused_partials.resize(3 * (last + 1));
+      }
+
+      compose_partials(f, g, &fused_partials[3 * n]);
+      fused_input[n] = fused_input[m] ? fused_input[m] : input_node<autodiff_order>(m, 0);
+
+      moved[m] = 0;
+      --n_live;
+
+    }
+
+    // Flattens sums, recording the start of the inputs, the number of
+    // inputs, and the number of terms of each sum that takes part
+    std::vector<nomad_idx_t> summands;
+
+    for (nomad_idx_t n = n_inputs + 1; n <= last; ++n) {
+
+      if (!moved[n] || !is_sum(n)) continue;
+
+      nomad_idx_t n_terms = var_nodes_[n].n_inputs();
+      bool flattened = false;
+
+      for (nomad_idx_t k = 0; k < var_nodes_[n].n_inputs(); ++k) {
+
+        const nomad_idx_t m = input_node<autodiff_order>(n, k);
+        if (m <= n_inputs || moved[m] != 1 || !is_sum(m)) continue;
+
+        if (summands.empty()) summands.resize(3 * (last + 1), 0);
+
+        const nomad_idx_t m_terms = summands[3 * m + 2] ? summands[3 * m + 2] : var_nodes_[m].n_inputs();
+        if (n_terms - 1 + m_terms > max_node_inputs) continue;
+
+        summands[3 * m] = var_nodes_[m].inputs();
+        summands[3 * m + 1] = var_nodes_[m].n_inputs();
+        summands[3 * m + 2] = m_terms;
+        n_terms += m_terms - 1;
+        flattened = true;
+
+        moved[m] = 0;
+        --n_live;
+
+      }
+
+      if (flattened) {
+        summands[3 * n] = var_nodes_[n].inputs();
+        summands[3 * n + 1] = var_nodes_[n].n_inputs();
+        summands[3 * n + 2] = n_terms;
+      }
+
+    }
+
+    if (n_live == end - 1 && fused_input.empty()) return output;
+
+    // A fused node may store more partials than it did before, so the
+    // partials are read from a copy once any node is fused
+    std::vector<double> recorded_partials;
+    const double* partials = partials_;
+
+    if (!fused_input.empty()) {
+      recorded_partials.assign(partials_, partials_ + end_partials);
+      partials = recorded_partials.data();
+    }
+
+    // The inputs of the flattened sums are read from a copy as well, since
+    // the nodes moved before a sum may overwrite those of the sums within it
+    std::vector<nomad_idx_t> recorded_inputs;
+    std::vector<nomad_idx_t> pending;
+
+    if (!summands.empty())
+      recorded_inputs.assign(inputs_, inputs_ + next_inputs_idx_);
+
+    next_node_idx_ = 1;
+    next_dual_number_idx_ = 1;
+    next_partials_idx_ = 1;
+    next_inputs_idx_ = 1;
+
+    // Every node moves down the stacks, if at all, so the data of the later
+    // nodes is still in place when each node is moved
+    for (nomad_idx_t n = 1; n <= last; ++n) {
+
+      if (!moved[n] && n > n_inputs) continue;
+
+      var_node_base& node = var_nodes_[n];
+
+      const nomad_idx_t m = next_node_idx_++;
+      const nomad_idx_t dual_numbers_idx = next_dual_number_idx_;
+      const nomad_idx_t partials_idx = next_partials_idx_;
+      const nomad_idx_t inputs_idx = next_inputs_idx_;
+
+      if (!fused_input.empty() && fused_input[n]) {
+
+        for (nomad_idx_t k = 0; k < n_partials; ++k)
+          partials_[next_partials_idx_++] = fused_partials[3 * n + k];
+
+        inputs_[next_inputs_idx_++] = var_nodes_[moved[fused_input[n]]].dual_numbers();
+
+        dual_number_layout::push<autodiff_order>(node.first_val());
+
+        node.relocate(var_nodes_[m], dual_numbers_idx, partials_idx, inputs_idx,
+                      var_node_opcode(unary_var_node_kind, 3), 1);
+
+      } else if (!summands.empty() && summands[3 * n + 2]) {
+
+        // Reads the terms of the sums within in order, depth first
+        pending.assign(1, n);
+
+        while (!pending.empty()) {
+          const nomad_idx_t s = pending.back();
+          pending.pop_back();
+
+          if (s != n && (moved[s] || !summands[3 * s + 2])) {
+            inputs_[next_inputs_idx_++] = var_nodes_[moved[s]].dual_numbers();
+            continue;
+          }
+
+          for (nomad_idx_t k = summands[3 * s + 1]; k > 0; --k)
+            pending.push_back(dual_number_layout::node_slot<autodiff_order>(
+                                recorded_inputs[summands[3 * s] + k - 1]) + 1);
+        }
+
+        dual_number_layout::push<autodiff_order>(node.first_val());
+
+        node.relocate(var_nodes_[m], dual_numbers_idx, partials_idx, inputs_idx,
+                      var_node_opcode(multi_sum_var_node_kind), summands[3 * n + 2]);
+
+      } else {
+
+        const nomad_idx_t partials_end = n + 1 < end ? var_nodes_[n + 1].partials() : end_partials;
+
+        for (nomad_idx_t p = node.partials(); p < partials_end; ++p)
+          partials_[next_partials_idx_++] = partials[p];
+
+        for (nomad_idx_t k = 0; k < node.n_inputs(); ++k)
+          inputs_[next_inputs_idx_++] = var_nodes_[moved[input_node<autodiff_order>(n, k)]].dual_numbers();
+
+        dual_number_layout::push<autodiff_order>(node.first_val());
+
+        node.relocate(var_nodes_[m], dual_numbers_idx, partials_idx, inputs_idx);
+
+      }
+
+      moved[n] = m;
+
+    }
+
+    return T_var(moved[output.node()]);
+
+  }
+
+}
+
+#endif
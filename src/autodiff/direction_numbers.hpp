@@ -0,0 +1,188 @@
+#ifndef nomad__src__autodiff__direction_numbers_hpp
+#define nomad__src__autodiff__direction_numbers_hpp
+
+#include <algorithm>
+#include <cstddef>
+
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/dual_number_layout.hpp>
+#include <src/autodiff/stack_arena.hpp>
+#include <src/autodiff/typedefs.hpp>
+
+namespace nomad {
+
+  // The higher-order sweeps propagate the tangents of a single direction
+  // through the second, third, and fourth dual number lanes of each node.
+  // A direction policy instead lets one sweep carry K directions at once,
+  // loading the partials of each node once and applying them to every
+  // direction.  The tangents of the extra directions live in a scratch
+  // stack, direction_numbers_, indexed by the position of each node.
+
+  // The tangents of K directions, with the arithmetic the sweeps need
+  template<int K>
+  struct direction_pack {
+
+    double v[K];
+
+    direction_pack() {}
+    direction_pack(double x) { for (int k = 0; k < K; ++k) v[k] = x; }
+
+    inline double& operator[](int k) { return v[k]; }
+    inline double operator[](int k) const { return v[k]; }
+
+    inline direction_pack& operator+=(const direction_pack& x) {
+      for (int k = 0; k < K; ++k) v[k] += x.v[k];
+      return *this;
+    }
+
+    inline direction_pack& operator-=(const direction_pack& x) {
+      for (int k = 0; k < K; ++k) v[k] -= x.v[k];
+      return *this;
+    }
+
+  };
+
+  template<int K>
+  inline direction_pack<K> operator+(const direction_pack<K>& x, const direction_pack<K>& y) {
+    direction_pack<K> z;
+    for (int k = 0; k < K; ++k) z.v[k] = x.v[k] + y.v[k];
+    return z;
+  }
+
+  template<int K>
+  inline direction_pack<K> operator-(const direction_pack<K>& x, const direction_pack<K>& y) {
+    direction_pack<K> z;
+    for (int k = 0; k < K; ++k) z.v[k] = x.v[k] - y.v[k];
+    return z;
+  }
+
+  template<int K>
+  inline direction_pack<K> operator-(const direction_pack<K>& x) {
+    direction_pack<K> z;
+    for (int k = 0; k < K; ++k) z.v[k] = -x.v[k];
+    return z;
+  }
+
+  template<int K>
+  inline direction_pack<K> operator*(const direction_pack<K>& x, double a) {
+    direction_pack<K> z;
+    for (int k = 0; k < K; ++k) z.v[k] = x.v[k] * a;
+    return z;
+  }
+
+  template<int K>
+  inline direction_pack<K> operator*(double a, const direction_pack<K>& x) {
+    return x * a;
+  }
+
+  // A single direction stored in the dual numbers of each node
+  struct scalar_directions {
+
+    typedef double second_type;
+    typedef double third_type;
+
+    static inline double& second_val(nomad_idx_t idx)  { return dual_number_layout::lane<2>(idx); }
+    static inline double& second_grad(nomad_idx_t idx) { return dual_number_layout::lane<3>(idx); }
+    static inline double& third_val(nomad_idx_t idx)   { return dual_number_layout::lane<4>(idx); }
+    static inline double& third_grad(nomad_idx_t idx)  { return dual_number_layout::lane<5>(idx); }
+    static inline double& fourth_val(nomad_idx_t idx)  { return dual_number_layout::lane<6>(idx); }
+    static inline double& fourth_grad(nomad_idx_t idx) { return dual_number_layout::lane<7>(idx); }
+
+  };
+
+  // K second order directions, as used to compute K columns of a Hessian
+  template<short AutodiffOrder, int K>
+  struct second_order_directions {
+
+    typedef direction_pack<K> second_type;
+
+    // Doubles of scratch storage per node
+    static const std::size_t width = 2 * K;
+
+    static inline direction_pack<K>* pack(nomad_idx_t idx) {
+      return reinterpret_cast<direction_pack<K>*>(direction_numbers_)
+             + 2 * std::size_t(dual_number_layout::node_slot<AutodiffOrder>(idx));
+    }
+
+    static inline second_type& second_val(nomad_idx_t idx)  { return pack(idx)[0]; }
+    static inline second_type& second_grad(nomad_idx_t idx) { return pack(idx)[1]; }
+
+  };
+
+  // A single second order direction, stored in the dual numbers, paired
+  // with K third order directions
+  template<short AutodiffOrder, int K>
+  struct third_order_directions {
+
+    typedef double second_type;
+    typedef direction_pack<K> third_type;
+
+    static const std::size_t width = 4 * K;
+
+    static inline direction_pack<K>* pack(nomad_idx_t idx) {
+      return reinterpret_cast<direction_pack<K>*>(direction_numbers_)
+             + 4 * std::size_t(dual_number_layout::node_slot<AutodiffOrder>(idx));
+    }
+
+    static inline double& second_val(nomad_idx_t idx)  { return dual_number_layout::lane<2>(idx); }
+    static inline double& second_grad(nomad_idx_t idx) { return dual_number_layout::lane<3>(idx); }
+    static inline third_type& third_val(nomad_idx_t idx)   { return pack(idx)[0]; }
+    static inline third_type& third_grad(nomad_idx_t idx)  { return pack(idx)[1]; }
+    static inline third_type& fourth_val(nomad_idx_t idx)  { return pack(idx)[2]; }
+    static inline third_type& fourth_grad(nomad_idx_t idx) { return pack(idx)[3]; }
+
+  };
+
+  // As third_order_directions, with the second order direction stored in
+  // the scratch tangents as well, so that sweeps on several threads sharing
+  // one graph never write its dual numbers, see parallel.hpp
+  template<short AutodiffOrder, int K>
+  struct private_third_order_directions {
+
+    typedef double second_type;
+    typedef direction_pack<K> third_type;
+
+    static const std::size_t width = 4 * K + 2;
+
+    static inline double* slot(nomad_idx_t idx) {
+      return direction_numbers_
+             + width * std::size_t(dual_number_layout::node_slot<AutodiffOrder>(idx));
+    }
+
+    static inline third_type* pack(nomad_idx_t idx) {
+      return reinterpret_cast<third_type*>(slot(idx) + 2);
+    }
+
+    static inline double& second_val(nomad_idx_t idx)  { return slot(idx)[0]; }
+    static inline double& second_grad(nomad_idx_t idx) { return slot(idx)[1]; }
+    static inline third_type& third_val(nomad_idx_t idx)   { return pack(idx)[0]; }
+    static inline third_type& third_grad(nomad_idx_t idx)  { return pack(idx)[1]; }
+    static inline third_type& fourth_val(nomad_idx_t idx)  { return pack(idx)[2]; }
+    static inline third_type& fourth_grad(nomad_idx_t idx) { return pack(idx)[3]; }
+
+  };
+
+  // Number of directions carried by each sweep of hessian(),
+  // trace_matrix_times_hessian(), and grad_hessian().  The scratch tangents
+  // take 2 or 4 times this many doubles per node.
+#ifndef NOMAD_DIRECTION_LANES
+#define NOMAD_DIRECTION_LANES 8
+#endif
+
+  const int direction_lanes = NOMAD_DIRECTION_LANES;
+
+  // Commits the scratch tangents of the policy for the current expression
+  // graph and clears them, as the sweeps never write the tangents of nodes
+  // without inputs
+  template<class Directions>
+  void expand_direction_numbers() {
+    thread_stacks_guard_.touch();
+    std::size_t n_idx = Directions::width * (std::size_t(next_node_idx_) - 1);
+    commit_stack(direction_numbers_, max_direction_number_idx,
+                 reserved_direction_number_idx, n_idx, n_idx);
+    std::fill(direction_numbers_, direction_numbers_ + n_idx, 0.0);
+  }
+
+}
+
+#endif
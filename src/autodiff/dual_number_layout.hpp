@@ -0,0 +1,174 @@
+#ifndef nomad__src__autodiff__dual_number_layout_hpp
+#define nomad__src__autodiff__dual_number_layout_hpp
+
+#include <cmath>
+#include <cstddef>
+
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/exceptions.hpp>
+#include <src/autodiff/stack_arena.hpp>
+#include <src/autodiff/typedefs.hpp>
+
+namespace nomad {
+
+  // Every node owns eight dual number lanes, first_val, first_grad,
+  // second_val, second_grad, third_val, third_grad, fourth_val, and
+  // fourth_grad, of which a graph of order k uses the first 2^k.  A layout
+  // policy decides where the lanes of a node live on the dual numbers stack
+  // given the dual number index of the node.  The dual numbers are always
+  // committed for all eight lanes so that graphs of any order can be
+  // recorded into the same stacks.
+
+  // Stores the lanes of each node next to each other, so that a node occupies
+  // 2, 4, or 8 consecutive doubles depending on the order of the graph.
+  // First order nodes advance the node and dual number stacks in step, so
+  // the dual numbers start half a page into their stack to keep the dual
+  // numbers written by a sweep from sharing the low address bits of the node
+  // records read next, which stalls those loads on 4K aliasing.
+  struct interleaved_dual_numbers {
+
+    static const nomad_idx_t offset = 256;
+
+    template<int Lane>
+    static inline double& lane(nomad_idx_t idx) {
+      return dual_numbers_[offset + idx + Lane];
+    }
+
+    // Position of a node among the nodes of a graph of the given order
+    template<short AutodiffOrder>
+    static inline nomad_idx_t node_slot(nomad_idx_t idx) {
+      return (idx - 1) >> AutodiffOrder;
+    }
+
+    template<short AutodiffOrder>
+    static inline void push(double val) {
+
+      dual_numbers_[offset + next_dual_number_idx_++] = val;
+      dual_numbers_[offset + next_dual_number_idx_++] = 0;
+
+      if (AutodiffOrder >= 2) {
+        dual_numbers_[offset + next_dual_number_idx_++] = 0;
+        dual_numbers_[offset + next_dual_number_idx_++] = 0;
+      }
+
+      if (AutodiffOrder >= 3) {
+        dual_numbers_[offset + next_dual_number_idx_++] = 0;
+        dual_numbers_[offset + next_dual_number_idx_++] = 0;
+        dual_numbers_[offset + next_dual_number_idx_++] = 0;
+        dual_numbers_[offset + next_dual_number_idx_++] = 0;
+      }
+
+    }
+
+    // Returns the number of nodes whose dual numbers are committed
+    static nomad_idx_t expand(std::size_t min_nodes, std::size_t target_nodes) {
+      commit_stack(dual_numbers_, max_dual_number_idx, reserved_dual_number_idx,
+                   offset + 8 * min_nodes + 1, offset + 8 * target_nodes + 1);
+      return (max_dual_number_idx - offset - 1) / 8;
+    }
+
+    static void decommit(std::size_t keep_nodes) {
+      decommit_stack(dual_numbers_, max_dual_number_idx,
+                     keep_nodes ? offset + 8 * keep_nodes + 1 : 0);
+    }
+
+    static void release() {
+      release_stack(dual_numbers_, max_dual_number_idx, reserved_dual_number_idx);
+    }
+
+  };
+
+  // Stores each lane in its own array, so that a sweep streams only the
+  // lanes it reads no matter the order of the graph.  The arrays are carved
+  // out of one reservation dual_lane_stride_ elements apart, each starting on
+  // a chunk boundary, and the dual number index of a node is its position
+  // within every array.
+  struct lane_dual_numbers {
+
+    template<int Lane>
+    static inline double& lane(nomad_idx_t idx) {
+      return dual_numbers_[Lane * dual_lane_stride_ + idx];
+    }
+
+    template<short AutodiffOrder>
+    static inline nomad_idx_t node_slot(nomad_idx_t idx) {
+      return idx - 1;
+    }
+
+    template<short AutodiffOrder>
+    static inline void push(double val) {
+
+      const nomad_idx_t idx = next_dual_number_idx_++;
+
+      lane<0>(idx) = val;
+      lane<1>(idx) = 0;
+
+      if (AutodiffOrder >= 2) {
+        lane<2>(idx) = 0;
+        lane<3>(idx) = 0;
+      }
+
+      if (AutodiffOrder >= 3) {
+        lane<4>(idx) = 0;
+        lane<5>(idx) = 0;
+        lane<6>(idx) = 0;
+        lane<7>(idx) = 0;
+      }
+
+    }
+
+    static nomad_idx_t expand(std::size_t min_nodes, std::size_t target_nodes) {
+
+      if (!dual_numbers_) {
+        reserve_stack(dual_numbers_, max_dual_number_idx, reserved_dual_number_idx);
+        const std::size_t chunk_size = stack_chunk_bytes / sizeof(double);
+        dual_lane_stride_ = static_cast<nomad_idx_t>(
+          reserved_dual_number_idx / 8 / chunk_size * chunk_size);
+      }
+
+      commit_lanes(dual_numbers_, max_dual_number_idx, dual_lane_stride_, 8,
+                   min_nodes + 1, target_nodes + 1);
+      return max_dual_number_idx - 1;
+
+    }
+
+    static void decommit(std::size_t keep_nodes) {
+      decommit_lanes(dual_numbers_, max_dual_number_idx, dual_lane_stride_, 8,
+                     keep_nodes ? keep_nodes + 1 : 0);
+    }
+
+    static void release() {
+      release_stack(dual_numbers_, max_dual_number_idx, reserved_dual_number_idx, 8);
+      dual_lane_stride_ = 0;
+    }
+
+  };
+
+  // The layout is fixed for the whole program, as every graph on every
+  // thread is swept by the same node implementations
+#ifndef NOMAD_DUAL_NUMBER_LAYOUT
+#define NOMAD_DUAL_NUMBER_LAYOUT interleaved_dual_numbers
+#endif
+
+  typedef NOMAD_DUAL_NUMBER_LAYOUT dual_number_layout;
+
+  template<short AutodiffOrder, bool ValidateIO>
+  inline void push_dual_numbers(double val) {
+
+    if (ValidateIO) {
+      if (unlikely(std::isnan(val))) throw nomad_error();
+    }
+
+    dual_number_layout::push<AutodiffOrder>(val);
+
+  }
+
+  // Returns the number of nodes whose dual numbers are committed
+  nomad_idx_t expand_dual_numbers(std::size_t min_nodes, std::size_t target_nodes) {
+    thread_stacks_guard_.touch();
+    return dual_number_layout::expand(min_nodes, target_nodes);
+  }
+
+}
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef nomad__src__autodiff__edge_pushing_hpp
+#define nomad__src__autodiff__edge_pushing_hpp
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+
+#include <src/var/var.hpp>
+#include <src/var/var_node_dispatch.hpp>
+#include <src/autodiff/first_order.hpp>
+
+namespace nomad {
+
+  // Edge pushing computes a Hessian in a single reverse sweep.  It keeps the
+  // second-order adjoint of the nodes swept so far as a sparse symmetric
+  // matrix over the remaining nodes, indexed by the position of each node on
+  // the stack.  Sweeping a node pushes its row of that matrix onto the inputs
+  // of the node, through the first partials of the node, and then creates
+  // the contribution of its second partials weighted by its first-order
+  // adjoint.  Once the sweep reaches the inputs the matrix restricted to
+  // them is the Hessian, so the cost scales with the fill-in of the matrix
+  // rather than with the number of inputs.
+  template<short AutodiffOrder>
+  class edge_pushing_sweep {
+  public:
+
+    explicit edge_pushing_sweep(nomad_idx_t n_nodes):
+    off_diagonal_(n_nodes), diagonal_(n_nodes, 0.0), slot_(0) {}
+
+    // Sweeps the nodes 1 through last_idx, which requires their first-order
+    // adjoints from a first-order reverse sweep
+    void sweep(nomad_idx_t last_idx) {
+      for (nomad_idx_t n = last_idx; n > 0; --n) {
+        slot_ = n - 1;
+        visit_node<AutodiffOrder>(var_nodes_[n], *this);
+      }
+    }
+
+    // Appends the entries of the lower triangle of the Hessian of the first
+    // n_inputs nodes
+    void lower_triangle(nomad_idx_t n_inputs,
+                        std::vector<Eigen::Triplet<double> >& entries) const {
+      for (nomad_idx_t j = 0; j < n_inputs; ++j) {
+        if (diagonal_[j] != 0) entries.push_back(Eigen::Triplet<double>(j, j, diagonal_[j]));
+        for (const auto& w : off_diagonal_[j])
+          if (w.first < j) entries.push_back(Eigen::Triplet<double>(j, w.first, w.second));
+      }
+    }
+
+    template<class Node>
+    void operator()(Node& node) {
+
+      if (!node.n_inputs()) return;
+
+      local_partials_.resize(node.n_inputs());
+      partial_collector collect = { node, local_partials_ };
+      node.local_partials(collect);
+
+      // Pushing, where entries of nodes that have already been swept are dead
+      for (const auto& w : off_diagonal_[slot_]) {
+        if (w.first >= slot_ || w.second == 0) continue;
+        for (const auto& p : local_partials_)
+          add(p.first, w.first, p.second * w.second);
+      }
+
+      const double w_diag = diagonal_[slot_];
+      if (w_diag != 0) {
+        for (std::size_t k = 0; k < local_partials_.size(); ++k)
+          for (std::size_t j = 0; j <= k; ++j)
+            add_positions(j, k, local_partials_[j].second * local_partials_[k].second * w_diag);
+      }
+
+      // Creating
+      const double g1 = node.first_grad();
+      if (g1 != 0) {
+        second_partial_collector create = { *this, g1 };
+        node.local_second_partials(create);
+      }
+
+      // No later node refers to this one
+      std::unordered_map<nomad_idx_t, double>().swap(off_diagonal_[slot_]);
+
+    }
+
+  private:
+
+    struct partial_collector {
+      var_node_base& node;
+      std::vector<std::pair<nomad_idx_t, double> >& partials;
+      inline void operator()(nomad_idx_t k, double partial) {
+        partials[k] = std::make_pair(
+          dual_number_layout::node_slot<AutodiffOrder>(node.input(k)), partial);
+      }
+    };
+
+    struct second_partial_collector {
+      edge_pushing_sweep& sweep;
+      double g1;
+      inline void operator()(nomad_idx_t j, nomad_idx_t k, double partial) {
+        sweep.add_positions(j, k, g1 * partial);
+      }
+    };
+
+    // Adds a symmetric contribution at the nodes of two positions among the
+    // inputs of the current node, where distinct positions may name the
+    // same node
+    inline void add_positions(nomad_idx_t j, nomad_idx_t k, double w) {
+      const nomad_idx_t a = local_partials_[j].first;
+      const nomad_idx_t b = local_partials_[k].first;
+      if (a == b && j == k) diagonal_[a] += w;
+      else                  add(a, b, w);
+    }
+
+    // Adds w to both the (a, b) and (b, a) entries
+    inline void add(nomad_idx_t a, nomad_idx_t b, double w) {
+      if (a == b) {
+        diagonal_[a] += 2 * w;
+      } else {
+        off_diagonal_[a][b] += w;
+        off_diagonal_[b][a] += w;
+      }
+    }
+
+    std::vector<std::unordered_map<nomad_idx_t, double> > off_diagonal_;
+    std::vector<double> diagonal_;
+    std::vector<std::pair<nomad_idx_t, double> > local_partials_;
+    nomad_idx_t slot_;
+
+  };
+
+  template <typename F>
+  typename std::enable_if<is_var<typename F::var_type>::value && F::var_type::order() >= 2, void >::type
+  hessian_edge_pushing(const F& functional,
+                       const Eigen::VectorXd& x,
+                       double& f,
+                       Eigen::VectorXd& g,
+                       Eigen::SparseMatrix<double>& H) {
+
+    reset();
+
+    eigen_idx_t d = x.size();
+
+    try {
+
+      auto f_var = functional(x);
+
+      f = f_var.first_val();
+
+      // First-order
+      first_order_reverse_adj(f_var);
+
+      for (eigen_idx_t i = 0; i < d; ++i)
+      g(i) = var_nodes_[i + 1].first_grad();
+
+      // Second-order
+      edge_pushing_sweep<F::var_type::order()> sweep(f_var.node());
+      sweep.sweep(f_var.node());
+
+      std::vector<Eigen::Triplet<double> > entries;
+      sweep.lower_triangle(static_cast<nomad_idx_t>(d), entries);
+
+      std::size_t n_lower = entries.size();
+      for (std::size_t n = 0; n < n_lower; ++n) {
+        if (entries[n].row() != entries[n].col())
+          entries.push_back(Eigen::Triplet<double>(entries[n].col(), entries[n].row(),
+                                                   entries[n].value()));
+      }
+
+      H.resize(d, d);
+      H.setFromTriplets(entries.begin(), entries.end());
+
+      reset();
+
+    } catch (nomad_error&) {
+      reset();
+      throw;
+    }
+
+  }
+
+  template <typename F>
+  void hessian_edge_pushing(const F& functional,
+                            const Eigen::VectorXd& x,
+                            double& f,
+                            Eigen::VectorXd& g,
+                            Eigen::MatrixXd& H) {
+    Eigen::SparseMatrix<double> H_sparse;
+    hessian_edge_pushing(functional, x, f, g, H_sparse);
+    H = Eigen::MatrixXd(H_sparse);
+  }
+
+  template <typename F>
+  void hessian_edge_pushing(const F& functional,
+                            const Eigen::VectorXd& x,
+                            Eigen::MatrixXd& H) {
+    double f;
+    Eigen::VectorXd g(x.size());
+    hessian_edge_pushing(functional, x, f, g, H);
+  }
+
+}
+
+#endif
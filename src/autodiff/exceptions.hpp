@@ -1,8 +1,10 @@
 #ifndef nomad__src__autodiff__exceptions_hpp
 #define nomad__src__autodiff__exceptions_hpp
 
+#include <cstddef>
 #include <string>
 #include <exception>
+#include <stdexcept>
 
 namespace nomad {
 
@@ -59,6 +61,16 @@ namespace nomad {
   };
   void nomad_output_partial_error::anchor_vtable() {}
   
+  class nomad_memory_error: public nomad_error {
+  public:
+    nomad_memory_error(std::size_t cap):
+    nomad_error("Nomad stack construction terminated because the stacks "
+                "would exceed the memory cap of " + std::to_string(cap) + " bytes") {}
+  private:
+    virtual void anchor_vtable();
+  };
+  void nomad_memory_error::anchor_vtable() {}
+  
 }
 
 #endif
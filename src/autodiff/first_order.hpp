@@ -8,21 +8,20 @@
 #include <Eigen/Core>
 
 #include <src/var/var.hpp>
+#include <src/var/var_node_dispatch.hpp>
 #include <src/autodiff/exceptions.hpp>
 
 namespace nomad {
 
   template<class T_var>
   void first_order_forward_adj(const T_var& v) {
-    for (nomad_idx_t i = 1; i <= v.node(); ++i)
-      var_nodes_[i].first_order_forward_adj();
+    sweep_nodes<T_var::order(), first_order_forward_sweep, false>(v.node());
   }
   
   template<class T_var>
   void first_order_reverse_adj(const T_var& v) {
     var_nodes_[v.node()].first_grad() = 1.0;
-    for (nomad_idx_t i = v.node(); i > 0; --i)
-      var_nodes_[i].first_order_reverse_adj();
+    sweep_nodes<T_var::order(), first_order_reverse_sweep, true>(v.node());
   }
 
   template <typename F>
@@ -47,9 +46,9 @@ namespace nomad {
       
       reset();
       
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       reset();
-      throw e;
+      throw;
     }
     
   }
@@ -105,7 +104,7 @@ namespace nomad {
       gradient(functional, x, auto_grad);
     } catch (std::runtime_error& e) {
       std::cout << "Cannot compute Gradient Test" << std::endl;
-      throw e;
+      throw;
     }
     
     Eigen::VectorXd diff_grad(x.size());
@@ -113,7 +112,7 @@ namespace nomad {
       finite_diff_gradient(functional, x, diff_grad, epsilon);
     } catch (std::runtime_error& e) {
       std::cout << "Cannot compute Gradient Test" << std::endl;
-      throw e;
+      throw;
     }
     
     std::cout.precision(6);
@@ -181,9 +180,9 @@ namespace nomad {
       
       reset();
       
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       reset();
-      throw e;
+      throw;
     }
     
   }
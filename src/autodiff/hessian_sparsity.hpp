@@ -0,0 +1,323 @@
+#ifndef nomad__src__autodiff__hessian_sparsity_hpp
+#define nomad__src__autodiff__hessian_sparsity_hpp
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <src/var/var.hpp>
+#include <src/var/var_node_dispatch.hpp>
+
+namespace nomad {
+
+  // Structurally non-zero entries of a symmetric Hessian in compressed sparse
+  // row form, where the sorted column indices of row i are
+  // inner[outer[i]] through inner[outer[i + 1] - 1]
+  struct hessian_pattern {
+
+    nomad_idx_t n;
+    std::vector<nomad_idx_t> outer;
+    std::vector<nomad_idx_t> inner;
+
+    hessian_pattern(): n(0), outer(1, 0) {}
+
+    inline nomad_idx_t nonzeros() const { return static_cast<nomad_idx_t>(inner.size()); }
+
+    bool contains(nomad_idx_t i, nomad_idx_t j) const {
+      return std::binary_search(inner.begin() + outer[i], inner.begin() + outer[i + 1], j);
+    }
+
+    // Coordinate form of the same entries, ordered by row
+    void coo(std::vector<nomad_idx_t>& rows, std::vector<nomad_idx_t>& cols) const {
+      rows.clear();
+      for (nomad_idx_t i = 0; i < n; ++i)
+        rows.insert(rows.end(), outer[i + 1] - outer[i], i);
+      cols = inner;
+    }
+
+  };
+
+  // Propagates the set of independent inputs that each node depends on
+  // forward through the graph.  Wherever a node has a second partial that is
+  // not identically zero, every input in the set of one of its inputs
+  // interacts with every input in the set of the other, regardless of the
+  // value of the partial at the point the graph was recorded.  Nodes whose
+  // second partials all vanish, such as sums and differences, only pass the
+  // sets on, and a set is only formed for the nodes that eventually reach
+  // such an interaction, so long running sums cost nothing.
+  template<short AutodiffOrder>
+  class hessian_sparsity_sweep {
+  public:
+
+    explicit hessian_sparsity_sweep(nomad_idx_t n_inputs):
+    rows_(n_inputs), n_inputs_(n_inputs), slot_(0) {}
+
+    // Sweeps the nodes that the output node depends on
+    void sweep(nomad_idx_t output_idx) {
+
+      // Backwards, marking the nodes that reach the output and the nodes
+      // whose sets are needed by an interaction
+      live_.assign(output_idx, 0);
+      live_[output_idx - 1] = live_node;
+
+      needs_marker mark = { *this };
+      for (nomad_idx_t n = output_idx; n > 0; --n) {
+        if (!live_[n - 1]) continue;
+        slot_ = n - 1;
+        visit_node<AutodiffOrder>(var_nodes_[n], mark);
+      }
+
+      // Forwards, forming the needed sets and the interactions
+      sets_.assign(output_idx, std::vector<nomad_idx_t>());
+      for (nomad_idx_t i = 0; i < n_inputs_ && i < output_idx; ++i)
+        sets_[i].push_back(i);
+
+      for (nomad_idx_t n = n_inputs_ + 1; n <= output_idx; ++n) {
+        if (!live_[n - 1]) continue;
+        slot_ = n - 1;
+        visit_node<AutodiffOrder>(var_nodes_[n], *this);
+      }
+
+    }
+
+    void pattern(hessian_pattern& p) const {
+      p.n = n_inputs_;
+      p.outer.assign(1, 0);
+      p.inner.clear();
+
+      // Mirror the lower triangle
+      std::vector<std::vector<nomad_idx_t> > rows(n_inputs_);
+      for (nomad_idx_t i = 0; i < n_inputs_; ++i) {
+        for (nomad_idx_t j : rows_[i]) {
+          rows[i].push_back(j);
+          if (j != i) rows[j].push_back(i);
+        }
+      }
+
+      for (nomad_idx_t i = 0; i < n_inputs_; ++i) {
+        std::sort(rows[i].begin(), rows[i].end());
+        p.inner.insert(p.inner.end(), rows[i].begin(), rows[i].end());
+        p.outer.push_back(static_cast<nomad_idx_t>(p.inner.size()));
+      }
+    }
+
+    template<class Node>
+    void operator()(Node& node) {
+
+      if (!node.n_inputs()) return;
+
+      if (live_[slot_] & needed_node) {
+        std::vector<nomad_idx_t>& set = sets_[slot_];
+        for (nomad_idx_t k = 0; k < node.n_inputs(); ++k) {
+          const std::vector<nomad_idx_t>& input_set = sets_[slot(node.input(k))];
+          std::vector<nomad_idx_t> merged;
+          merged.reserve(set.size() + input_set.size());
+          std::set_union(set.begin(), set.end(), input_set.begin(), input_set.end(),
+                         std::back_inserter(merged));
+          set.swap(merged);
+        }
+      }
+
+      interaction_collector interact = { *this, node };
+      node.local_second_partials(interact);
+
+    }
+
+  private:
+
+    enum { live_node = 1, needed_node = 2 };
+
+    static inline nomad_idx_t slot(nomad_idx_t dual_numbers_idx) {
+      return dual_number_layout::node_slot<AutodiffOrder>(dual_numbers_idx);
+    }
+
+    struct needs_marker {
+      hessian_sparsity_sweep& sweep;
+
+      template<class Node>
+      void operator()(Node& node) {
+        const bool needed = sweep.live_[sweep.slot_] & needed_node;
+        for (nomad_idx_t k = 0; k < node.n_inputs(); ++k)
+          sweep.live_[slot(node.input(k))] |= needed ? live_node | needed_node : live_node;
+        interaction_marker interact = { sweep, node };
+        node.local_second_partials(interact);
+      }
+    };
+
+    struct interaction_marker {
+      hessian_sparsity_sweep& sweep;
+      var_node_base& node;
+      inline void operator()(nomad_idx_t j, nomad_idx_t k, double partial) {
+        (void)partial;
+        sweep.live_[slot(node.input(j))] |= needed_node;
+        sweep.live_[slot(node.input(k))] |= needed_node;
+      }
+    };
+
+    struct interaction_collector {
+      hessian_sparsity_sweep& sweep;
+      var_node_base& node;
+      inline void operator()(nomad_idx_t j, nomad_idx_t k, double partial) {
+        (void)partial;
+        const std::vector<nomad_idx_t>& a = sweep.sets_[slot(node.input(j))];
+        const std::vector<nomad_idx_t>& b = sweep.sets_[slot(node.input(k))];
+        for (nomad_idx_t u : a)
+          for (nomad_idx_t v : b)
+            sweep.rows_[std::max(u, v)].insert(std::min(u, v));
+      }
+    };
+
+    std::vector<char> live_;
+    std::vector<std::vector<nomad_idx_t> > sets_;
+    std::vector<std::set<nomad_idx_t> > rows_;
+    nomad_idx_t n_inputs_;
+    nomad_idx_t slot_;
+
+  };
+
+  // Identifies the structure of the expression graph held by the calling
+  // thread: the kind and inputs of every node, but none of the values
+  struct tape_signature {
+
+    nomad_idx_t n_inputs;
+    nomad_idx_t n_nodes;
+    nomad_idx_t n_input_edges;
+    std::uint64_t hash;
+
+    bool operator<(const tape_signature& other) const {
+      if (hash != other.hash) return hash < other.hash;
+      if (n_inputs != other.n_inputs) return n_inputs < other.n_inputs;
+      if (n_nodes != other.n_nodes) return n_nodes < other.n_nodes;
+      return n_input_edges < other.n_input_edges;
+    }
+
+  };
+
+  inline tape_signature current_tape_signature(nomad_idx_t n_inputs, nomad_idx_t output_idx) {
+
+    // 64-bit FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](std::uint64_t word) {
+      hash ^= word;
+      hash *= 1099511628211ull;
+    };
+
+    for (nomad_idx_t n = 1; n < next_node_idx_; ++n)
+      mix((std::uint64_t(var_nodes_[n].opcode()) << 32) | var_nodes_[n].n_inputs());
+
+    for (nomad_idx_t i = 1; i < next_inputs_idx_; ++i)
+      mix(inputs_[i]);
+
+    mix(output_idx);
+
+    tape_signature signature = { n_inputs, next_node_idx_ - 1, next_inputs_idx_ - 1, hash };
+    return signature;
+
+  }
+
+  // A pattern computed by hessian_sparsity together with the structure of
+  // the graph it was computed for, so that a lookup whose signature hashes
+  // alike is confirmed against the graph itself before it is trusted
+  struct cached_hessian_pattern {
+
+    std::vector<std::uint64_t> nodes;
+    std::vector<nomad_idx_t> inputs;
+    nomad_idx_t output;
+    hessian_pattern pattern;
+    std::uint64_t last_use;
+
+    // Copies the structure of the graph held by the calling thread
+    void capture(nomad_idx_t output_idx) {
+      nodes.resize(next_node_idx_ - 1);
+      for (nomad_idx_t n = 1; n < next_node_idx_; ++n)
+        nodes[n - 1] = (std::uint64_t(var_nodes_[n].opcode()) << 32) | var_nodes_[n].n_inputs();
+      inputs.assign(inputs_ + 1, inputs_ + next_inputs_idx_);
+      output = output_idx;
+    }
+
+    bool matches(nomad_idx_t output_idx) const {
+      if (output != output_idx) return false;
+      if (nodes.size() != std::size_t(next_node_idx_ - 1)) return false;
+      if (inputs.size() != std::size_t(next_inputs_idx_ - 1)) return false;
+      for (nomad_idx_t n = 1; n < next_node_idx_; ++n)
+        if (nodes[n - 1] != ((std::uint64_t(var_nodes_[n].opcode()) << 32) | var_nodes_[n].n_inputs()))
+          return false;
+      return std::equal(inputs.begin(), inputs.end(), inputs_ + 1);
+    }
+
+  };
+
+  // Patterns computed by hessian_sparsity on the calling thread, of which the
+  // least recently used is dropped once the cache holds its capacity, so that
+  // a functional whose structure keeps changing does not grow it without bound
+  const std::size_t hessian_pattern_cache_capacity = 16;
+
+  thread_local std::map<tape_signature, cached_hessian_pattern> hessian_pattern_cache_;
+  thread_local std::uint64_t hessian_pattern_cache_clock_ = 0;
+
+  inline void clear_hessian_sparsity_cache() { hessian_pattern_cache_.clear(); }
+
+  // Records the functional at x and returns the structurally non-zero
+  // entries of its Hessian.  Patterns are cached by the structure of the
+  // recorded graph, so a repeated call that records the same graph only
+  // compares it against the cached structure and looks the pattern up.
+  template <typename F>
+  typename std::enable_if<is_var<typename F::var_type>::value && F::var_type::order() >= 2,
+                          hessian_pattern >::type
+  hessian_sparsity(const F& functional, const Eigen::VectorXd& x) {
+
+    reset();
+
+    nomad_idx_t d = static_cast<nomad_idx_t>(x.size());
+    hessian_pattern p;
+
+    try {
+
+      auto f_var = functional(x);
+
+      tape_signature signature = current_tape_signature(d, f_var.node());
+
+      auto cached = hessian_pattern_cache_.find(signature);
+
+      if (cached != hessian_pattern_cache_.end() && cached->second.matches(f_var.node())) {
+        p = cached->second.pattern;
+        cached->second.last_use = ++hessian_pattern_cache_clock_;
+      } else {
+        hessian_sparsity_sweep<F::var_type::order()> sweep(d);
+        sweep.sweep(f_var.node());
+        sweep.pattern(p);
+
+        // A signature collision replaces the entry it collided with
+        if (cached == hessian_pattern_cache_.end()
+            && hessian_pattern_cache_.size() >= hessian_pattern_cache_capacity) {
+          auto oldest = hessian_pattern_cache_.begin();
+          for (auto e = hessian_pattern_cache_.begin(); e != hessian_pattern_cache_.end(); ++e)
+            if (e->second.last_use < oldest->second.last_use) oldest = e;
+          hessian_pattern_cache_.erase(oldest);
+        }
+
+        cached_hessian_pattern& entry = hessian_pattern_cache_[signature];
+        entry.capture(f_var.node());
+        entry.pattern = p;
+        entry.last_use = ++hessian_pattern_cache_clock_;
+      }
+
+      reset();
+
+    } catch (nomad_error&) {
+      reset();
+      throw;
+    }
+
+    return p;
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,342 @@
+#ifndef nomad__src__autodiff__level_schedule_hpp
+#define nomad__src__autodiff__level_schedule_hpp
+
+#include <algorithm>
+#include <vector>
+
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/parallel.hpp>
+#include <src/var/var_node.hpp>
+#include <src/var/var_node_dispatch.hpp>
+#include <src/var/replay.hpp>
+
+namespace nomad {
+
+  // The first-order reverse sweep of nodes 1 through last, reorganized so
+  // that threads can share it.  The nodes are grouped into levels by the
+  // longest path from each node to the last, so that every consumer of a
+  // node lies in an earlier level.  Rather than pushing its adjoint onto its
+  // inputs, each node then gathers its adjoint from its consumers, which
+  // leaves the nodes of a level independent and every adjoint written by a
+  // single thread.
+  //
+  // The edges into the nodes of a level are split between threads in blocks
+  // of block_size, so that a node with many consumers, such as a parameter
+  // read by every term of a likelihood, is shared between threads as well.
+  // The adjoint of a node whose edges cross a block boundary is the sum of
+  // the partial sums of each block, added in order, and every other adjoint
+  // sums its consumers in the order of the sequential sweep, so the result
+  // does not depend on the number of threads.
+  //
+  // The schedule depends only on the structure of the graph, so a graph
+  // replayed by a tape can keep one across replays.  Building it costs a few
+  // sequential sweeps, and wide, shallow graphs such as a sum of many
+  // independent terms gain the most from it.
+  template<short AutodiffOrder>
+  class level_schedule {
+  public:
+
+    // Edges in each block
+    static const nomad_idx_t block_size = 1024;
+
+    // Levels with fewer nodes and edges than this are swept by the calling
+    // thread alone, with the other threads waiting once for a whole run of
+    // them
+    static const nomad_idx_t min_parallel_work = 8192;
+
+    // Schedules the graph bound to the calling thread, up to the node last
+    explicit level_schedule(nomad_idx_t last):
+    last_(last), n_levels_(0), edge_begin_(last + 2, 0), position_(last + 1),
+    entry_begin_(last + 1, 0), adjoints_(last) {
+
+      // Edges, one for each input of each node
+      for (nomad_idx_t n = 1; n <= last; ++n)
+        edge_begin_[n + 1] = edge_begin_[n] + var_nodes_[n].n_inputs();
+
+      // Levels, with the consumers of each node counted along the way
+      std::vector<nomad_idx_t> level(last + 1, 0);
+      std::vector<nomad_idx_t> n_consumers(last + 1, 0);
+
+      for (nomad_idx_t n = last; n > 0; --n) {
+        for (nomad_idx_t k = 0; k < var_nodes_[n].n_inputs(); ++k) {
+          const nomad_idx_t m = input_node<AutodiffOrder>(n, k);
+          if (level[m] < level[n] + 1) level[m] = level[n] + 1;
+          ++n_consumers[m];
+        }
+        if (level[n] + 1 > n_levels_) n_levels_ = level[n] + 1;
+      }
+
+      // Positions of the nodes in order of level, and in node order within
+      // each level
+      std::vector<nomad_idx_t> level_begin(n_levels_ + 1, 0);
+      for (nomad_idx_t n = 1; n <= last; ++n)
+        ++level_begin[level[n] + 1];
+      for (nomad_idx_t l = 0; l < n_levels_; ++l)
+        level_begin[l + 1] += level_begin[l];
+
+      std::vector<nomad_idx_t> next(level_begin.begin(), level_begin.end() - 1);
+      std::vector<nomad_idx_t> order(last);
+
+      for (nomad_idx_t n = 1; n <= last; ++n) {
+        position_[n] = next[level[n]]++;
+        order[position_[n]] = n;
+      }
+
+      // Consumers of the node at each position, from the last to the first,
+      // stored in position order so that a level reads its entries in one
+      // stretch and the adjoints of the levels before it in another
+      for (nomad_idx_t i = 0; i < last; ++i)
+        entry_begin_[i + 1] = entry_begin_[i] + n_consumers[order[i]];
+
+      const nomad_idx_t n_entries = entry_begin_[last];
+
+      consumer_position_.resize(n_entries);
+      entry_partials_.resize(n_entries);
+      edge_entry_.resize(edge_begin_[last + 1]);
+      block_sums_.resize(2 * (n_entries / block_size + 1));
+
+      next.assign(entry_begin_.begin(), entry_begin_.end() - 1);
+
+      for (nomad_idx_t n = last; n > 0; --n) {
+        for (nomad_idx_t k = 0; k < var_nodes_[n].n_inputs(); ++k) {
+          const nomad_idx_t e = next[position_[input_node<AutodiffOrder>(n, k)]]++;
+          consumer_position_[e] = position_[n];
+          edge_entry_[edge_begin_[n] + k] = e;
+        }
+      }
+
+      output_position_ = position_[last];
+
+      // Phases, each a level with enough work to split or a run of levels
+      // without, along with the nodes of each level whose edges cross a
+      // block boundary
+      for (nomad_idx_t l = 0; l < n_levels_; ++l) {
+
+        const nomad_idx_t begin = level_begin[l];
+        const nomad_idx_t end = level_begin[l + 1];
+        const bool parallel
+          = end - begin + entry_begin_[end] - entry_begin_[begin] >= min_parallel_work;
+
+        if (!parallel && !phases_.empty() && !phases_.back().parallel) {
+          phases_.back().end = end;
+        } else {
+          const phase p = { begin, end, static_cast<nomad_idx_t>(split_.size()), 0, parallel };
+          phases_.push_back(p);
+        }
+
+        for (nomad_idx_t i = begin; i < end; ++i)
+          if (crosses_block(i)) split_.push_back(i);
+
+        phases_.back().split_end = static_cast<nomad_idx_t>(split_.size());
+
+      }
+
+    }
+
+    nomad_idx_t last() const { return last_; }
+    nomad_idx_t n_levels() const { return n_levels_; }
+
+    // Sets the first-order adjoint of every scheduled node, with respect to
+    // the last, from the current partials of the graph
+    void reverse_sweep(std::size_t n_threads) {
+
+      thread_barrier barrier(n_threads > 0 ? n_threads : 1);
+
+      sweep_in_parallel(n_threads, [&](std::size_t t, std::size_t n) {
+
+        // Partials of the edges of a contiguous range of nodes, each written
+        // to the entry of its input
+        for (nomad_idx_t m = 1 + share(last_, t, n); m <= share(last_, t + 1, n); ++m) {
+          if (!var_nodes_[m].n_inputs()) continue;
+          partial_gatherer gather = { *this, edge_begin_[m] };
+          visit_node<AutodiffOrder>(var_nodes_[m], gather);
+        }
+
+        barrier.wait();
+
+        for (std::size_t p = 0; p < phases_.size(); ++p) {
+
+          const phase& s = phases_[p];
+
+          if (!s.parallel) {
+            if (t == 0) gather_adjoints(s.begin, s.end);
+            barrier.wait();
+            continue;
+          }
+
+          gather_adjoints(s, t, n);
+          barrier.wait();
+
+          if (s.split_begin == s.split_end) continue;
+
+          const nomad_idx_t n_split = s.split_end - s.split_begin;
+          for (nomad_idx_t j = s.split_begin + share(n_split, t, n);
+               j < s.split_begin + share(n_split, t + 1, n); ++j)
+            adjoints_[split_[j]] = sum_blocks(split_[j]);
+
+          barrier.wait();
+
+        }
+
+        for (nomad_idx_t m = 1 + share(last_, t, n); m <= share(last_, t + 1, n); ++m)
+          var_nodes_[m].first_grad() = adjoints_[position_[m]];
+
+      });
+
+    }
+
+  private:
+
+    struct phase {
+      nomad_idx_t begin;
+      nomad_idx_t end;
+      nomad_idx_t split_begin;
+      nomad_idx_t split_end;
+      bool parallel;
+    };
+
+    struct partial_collector {
+      level_schedule& schedule;
+      nomad_idx_t edge;
+      inline void operator()(nomad_idx_t k, double partial) {
+        schedule.entry_partials_[schedule.edge_entry_[edge + k]] = partial;
+      }
+    };
+
+    struct partial_gatherer {
+      level_schedule& schedule;
+      nomad_idx_t edge;
+      template<class Node>
+      inline void operator()(Node& node) const {
+        partial_collector collect = { schedule, edge };
+        node.local_partials(collect);
+      }
+    };
+
+    // Start of the t-th of n near equal shares of size items
+    static inline nomad_idx_t share(nomad_idx_t size, std::size_t t, std::size_t n) {
+      return static_cast<nomad_idx_t>(static_cast<unsigned long long>(size) * t / n);
+    }
+
+    static inline nomad_idx_t block_end(nomad_idx_t e) {
+      return (e / block_size + 1) * block_size;
+    }
+
+    // Each block holds the partial sums of at most two nodes, the one whose
+    // edges cross into the block and the one whose edges cross out of it
+    static inline nomad_idx_t block_slot(nomad_idx_t e) {
+      return 2 * (e / block_size) + (e % block_size != 0);
+    }
+
+    inline bool crosses_block(nomad_idx_t i) const {
+      const nomad_idx_t a = entry_begin_[i];
+      const nomad_idx_t b = entry_begin_[i + 1];
+      return b > a && a / block_size != (b - 1) / block_size;
+    }
+
+    inline double seed(nomad_idx_t i) const { return i == output_position_ ? 1 : 0; }
+
+    inline double sum_entries(double adj, nomad_idx_t begin, nomad_idx_t end) const {
+      for (nomad_idx_t e = begin; e < end; ++e)
+        adj += entry_partials_[e] * adjoints_[consumer_position_[e]];
+      return adj;
+    }
+
+    inline double sum_blocks(nomad_idx_t i) const {
+      double adj = seed(i);
+      for (nomad_idx_t e = entry_begin_[i]; e < entry_begin_[i + 1]; e = block_end(e))
+        adj += block_sums_[block_slot(e)];
+      return adj;
+    }
+
+    // Adjoints of a run of positions on one thread
+    inline void gather_adjoints(nomad_idx_t begin, nomad_idx_t end) {
+      for (nomad_idx_t i = begin; i < end; ++i) {
+        const nomad_idx_t a = entry_begin_[i];
+        const nomad_idx_t b = entry_begin_[i + 1];
+        if (!crosses_block(i)) {
+          adjoints_[i] = sum_entries(seed(i), a, b);
+        } else {
+          double adj = seed(i);
+          for (nomad_idx_t e = a; e < b; e = block_end(e))
+            adj += sum_entries(0, e, std::min(b, block_end(e)));
+          adjoints_[i] = adj;
+        }
+      }
+    }
+
+    // The share of thread t of n of the adjoints of a phase, leaving the
+    // block sums of nodes crossing a block boundary to be added once every
+    // thread is done
+    inline void gather_adjoints(const phase& s, std::size_t t, std::size_t n) {
+
+      const nomad_idx_t first = entry_begin_[s.begin];
+      const nomad_idx_t last = entry_begin_[s.end];
+
+      const nomad_idx_t lower
+        = t == 0 ? first
+        : std::max(first, (first + share(last - first, t, n)) / block_size * block_size);
+      const nomad_idx_t upper
+        = t + 1 == n ? last
+        : std::max(first, (first + share(last - first, t + 1, n)) / block_size * block_size);
+
+      const nomad_idx_t* entries = entry_begin_.data();
+      const nomad_idx_t i_lower = std::lower_bound(entries + s.begin, entries + s.end, lower) - entries;
+      const nomad_idx_t i_upper = t + 1 == n ? s.end
+        : std::lower_bound(entries + s.begin, entries + s.end, upper) - entries;
+
+      // The blocks of a node crossing into the share from before it
+      if (i_lower > s.begin && entry_begin_[i_lower] > lower) {
+        const nomad_idx_t b = std::min(entry_begin_[i_lower], upper);
+        for (nomad_idx_t e = lower; e < b; e = block_end(e))
+          block_sums_[block_slot(e)] = sum_entries(0, e, std::min(b, block_end(e)));
+      }
+
+      for (nomad_idx_t i = i_lower; i < i_upper; ++i) {
+        const nomad_idx_t a = entry_begin_[i];
+        const nomad_idx_t b = entry_begin_[i + 1];
+        if (!crosses_block(i)) {
+          adjoints_[i] = sum_entries(seed(i), a, b);
+        } else {
+          const nomad_idx_t c = std::min(b, upper);
+          for (nomad_idx_t e = a; e < c; e = block_end(e))
+            block_sums_[block_slot(e)] = sum_entries(0, e, std::min(c, block_end(e)));
+        }
+      }
+
+    }
+
+    nomad_idx_t last_;
+    nomad_idx_t n_levels_;
+    nomad_idx_t output_position_;
+
+    // First edge of each node, and the position of each node
+    std::vector<nomad_idx_t> edge_begin_;
+    std::vector<nomad_idx_t> position_;
+
+    // Entries of the consumers of each position, with the entry of each edge
+    std::vector<nomad_idx_t> entry_begin_;
+    std::vector<nomad_idx_t> consumer_position_;
+    std::vector<double> entry_partials_;
+    std::vector<nomad_idx_t> edge_entry_;
+
+    std::vector<double> adjoints_;
+    std::vector<double> block_sums_;
+    std::vector<phase> phases_;
+    std::vector<nomad_idx_t> split_;
+
+  };
+
+  // The first-order reverse sweep of a graph with a schedule for its output
+  template<class T_var>
+  void first_order_reverse_adj(const T_var& v,
+                               level_schedule<T_var::order()>& schedule,
+                               std::size_t n_threads) {
+    if (schedule.last() != v.node())
+      throw nomad_error("Nomad level schedule swept for a var other than its output");
+    schedule.reverse_sweep(n_threads);
+  }
+
+}
+
+#endif
@@ -0,0 +1,302 @@
+#ifndef nomad__src__autodiff__parallel_hpp
+#define nomad__src__autodiff__parallel_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <src/autodiff/autodiff_stack.hpp>
+
+namespace nomad {
+
+  // The expression graph bound to the calling thread, shared with worker
+  // threads that sweep it.  A worker bound to the graph reads its nodes,
+  // partials, inputs, and dual numbers in place, and must write only to its
+  // own scratch tangents, see direction_numbers.hpp, so that any number of
+  // workers can sweep the graph at once.
+  class shared_graph {
+  public:
+
+    shared_graph():
+    var_nodes_(nomad::var_nodes_), next_node_idx_(nomad::next_node_idx_),
+    dual_numbers_(nomad::dual_numbers_), next_dual_number_idx_(nomad::next_dual_number_idx_),
+    dual_lane_stride_(nomad::dual_lane_stride_),
+    partials_(nomad::partials_), next_partials_idx_(nomad::next_partials_idx_),
+    inputs_(nomad::inputs_), next_inputs_idx_(nomad::next_inputs_idx_) {}
+
+    class scope;
+
+  private:
+
+    void bind() const {
+      nomad::var_nodes_ = var_nodes_;
+      nomad::next_node_idx_ = next_node_idx_;
+      nomad::dual_numbers_ = dual_numbers_;
+      nomad::next_dual_number_idx_ = next_dual_number_idx_;
+      nomad::dual_lane_stride_ = dual_lane_stride_;
+      nomad::partials_ = partials_;
+      nomad::next_partials_idx_ = next_partials_idx_;
+      nomad::inputs_ = inputs_;
+      nomad::next_inputs_idx_ = next_inputs_idx_;
+    }
+
+    var_node_base* var_nodes_;
+    nomad_idx_t next_node_idx_;
+    double* dual_numbers_;
+    nomad_idx_t next_dual_number_idx_;
+    nomad_idx_t dual_lane_stride_;
+    double* partials_;
+    nomad_idx_t next_partials_idx_;
+    nomad_idx_t* inputs_;
+    nomad_idx_t next_inputs_idx_;
+
+  };
+
+  // Binds a shared graph to the calling thread for the lifetime of the
+  // scope, setting the stacks of the thread aside until the scope closes
+  class shared_graph::scope {
+  public:
+    explicit scope(const shared_graph& graph) { graph.bind(); }
+    ~scope() { own_.bind(); }
+
+    scope(const scope&) = delete;
+    scope& operator=(const scope&) = delete;
+  private:
+    shared_graph own_;
+  };
+
+  // Holds each of a fixed number of threads until all of them have arrived,
+  // and then releases them together, as many times as needed
+  class thread_barrier {
+  public:
+
+    explicit thread_barrier(std::size_t n_threads):
+    n_threads_(n_threads), n_waiting_(0), generation_(0) {}
+
+    thread_barrier(const thread_barrier&) = delete;
+    thread_barrier& operator=(const thread_barrier&) = delete;
+
+    void wait() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      const std::size_t generation = generation_;
+      if (++n_waiting_ == n_threads_) {
+        n_waiting_ = 0;
+        ++generation_;
+        released_.notify_all();
+      } else {
+        released_.wait(lock, [&]() { return generation_ != generation; });
+      }
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable released_;
+    std::size_t n_threads_;
+    std::size_t n_waiting_;
+    std::size_t generation_;
+  };
+
+  // Calls work(t, n_threads) for t = 0, ..., n_threads - 1, the first on
+  // the calling thread and the others on new threads bound to the graph of
+  // the calling thread, and returns once every call has.  The first
+  // exception thrown by any call is rethrown.  No call starts until every
+  // thread has been created, so work may wait on the other calls, and a
+  // failure to create a thread is rethrown without calling work at all.  A
+  // thread count of zero runs a single call.
+  template <class Work>
+  void sweep_in_parallel(std::size_t n_threads, const Work& work) {
+
+    if (n_threads < 2) {
+      work(0, 1);
+      return;
+    }
+
+    shared_graph graph;
+
+    std::vector<std::exception_ptr> errors(n_threads);
+    std::vector<std::thread> workers;
+    workers.reserve(n_threads - 1);
+
+    std::mutex mutex;
+    std::condition_variable started;
+    bool start = false;
+    bool abort = false;
+
+    std::exception_ptr spawn_error;
+
+    for (std::size_t t = 1; t < n_threads; ++t) {
+      try {
+        workers.push_back(std::thread([&, t]() {
+          {
+            std::unique_lock<std::mutex> lock(mutex);
+            started.wait(lock, [&]() { return start || abort; });
+            if (abort) return;
+          }
+          try {
+            shared_graph::scope bound(graph);
+            work(t, n_threads);
+          } catch (...) {
+            errors[t] = std::current_exception();
+          }
+        }));
+      } catch (...) {
+        spawn_error = std::current_exception();
+        break;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (spawn_error) abort = true;
+      else start = true;
+    }
+    started.notify_all();
+
+    if (spawn_error) {
+      for (std::size_t t = 0; t < workers.size(); ++t)
+        workers[t].join();
+      std::rethrow_exception(spawn_error);
+    }
+
+    try {
+      work(0, n_threads);
+    } catch (...) {
+      errors[0] = std::current_exception();
+    }
+
+    for (std::size_t t = 0; t < workers.size(); ++t)
+      workers[t].join();
+
+    for (std::size_t t = 0; t < n_threads; ++t)
+      if (errors[t]) std::rethrow_exception(errors[t]);
+
+  }
+
+  // A fixed set of worker threads, each with its own stacks, that evaluate
+  // independent items together with the calling thread.  The threads, and
+  // the stacks they have grown, persist from one call of for_each() to the
+  // next, so a pool kept across iterations records and sweeps without
+  // allocating once warm.
+  class thread_pool {
+  public:
+
+    // A thread count of zero gives a pool that runs on the calling
+    // thread alone
+    explicit thread_pool(std::size_t n_threads):
+    job_(0), generation_(0), n_busy_(0), stop_(false) {
+      try {
+        for (std::size_t t = 1; t < n_threads; ++t)
+          workers_.push_back(std::thread(&thread_pool::serve, this));
+      } catch (...) {
+        stop();
+        throw;
+      }
+    }
+
+    ~thread_pool() { stop(); }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    std::size_t size() const { return workers_.size() + 1; }
+
+    // Calls work(i) for i = 0, ..., n_items - 1, each thread taking the next
+    // unclaimed item as soon as it finishes its last, so that items of
+    // uneven cost balance across the threads.  Every item is attempted, and
+    // the exception thrown by the lowest failing item, if any, is rethrown.
+    template <class Work>
+    void for_each(std::size_t n_items, const Work& work) {
+
+      std::lock_guard<std::mutex> running(run_mutex_);
+
+      std::atomic<std::size_t> next(0);
+      std::mutex error_mutex;
+      std::size_t error_item = n_items;
+      std::exception_ptr error;
+
+      std::function<void()> job = [&]() {
+        for (std::size_t i = next++; i < n_items; i = next++) {
+          try {
+            work(i);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (i < error_item) {
+              error_item = i;
+              error = std::current_exception();
+            }
+          }
+        }
+      };
+
+      if (!workers_.empty()) {
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          job_ = &job;
+          n_busy_ = workers_.size();
+          ++generation_;
+        }
+        start_.notify_all();
+      }
+
+      job();
+
+      if (!workers_.empty()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]() { return n_busy_ == 0; });
+        job_ = 0;
+      }
+
+      if (error) std::rethrow_exception(error);
+
+    }
+
+  private:
+
+    void stop() {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      start_.notify_all();
+      for (std::size_t t = 0; t < workers_.size(); ++t)
+        workers_[t].join();
+    }
+
+    void serve() {
+      std::size_t seen = 0;
+      for (;;) {
+        const std::function<void()>* job;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          start_.wait(lock, [&]() { return stop_ || generation_ != seen; });
+          if (stop_) return;
+          seen = generation_;
+          job = job_;
+        }
+        (*job)();
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (--n_busy_ == 0) done_.notify_one();
+        }
+      }
+    }
+
+    std::mutex run_mutex_;
+    std::mutex mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    const std::function<void()>* job_;
+    std::size_t generation_;
+    std::size_t n_busy_;
+    bool stop_;
+    std::vector<std::thread> workers_;
+
+  };
+
+}
+
+#endif
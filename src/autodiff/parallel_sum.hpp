@@ -0,0 +1,195 @@
+#ifndef nomad__src__autodiff__parallel_sum_hpp
+#define nomad__src__autodiff__parallel_sum_hpp
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/compact.hpp>
+#include <src/autodiff/direction_numbers.hpp>
+#include <src/autodiff/first_order.hpp>
+#include <src/autodiff/parallel.hpp>
+#include <src/autodiff/second_order.hpp>
+#include <src/autodiff/third_order.hpp>
+#include <src/var/accumulator.hpp>
+#include <src/var/var.hpp>
+#include <src/var/var_node.hpp>
+#include <src/var/replay.hpp>
+
+namespace nomad {
+
+  // Value and packed partials of one shard of a parallel_sum, in the
+  // layout of var_node<AutodiffOrder, 3>
+  struct sum_shard {
+    double val;
+    std::vector<double> partials;
+  };
+
+  // Records f(theta, data[n]) for the terms of a shard on the stacks bound
+  // to the calling thread, with fresh inputs at the values of theta, and
+  // sweeps that graph for the derivatives of the sum with respect to them
+  template <short AutodiffOrder, bool StrictSmoothness, bool ValidateIO, class F, class Datum>
+  void record_sum_shard(const F& f,
+                        const std::vector<double>& theta_vals,
+                        const std::vector<Datum>& data,
+                        std::size_t begin,
+                        std::size_t end,
+                        sum_shard& shard) {
+
+    typedef var<AutodiffOrder, StrictSmoothness, ValidateIO> var_type;
+
+    const eigen_idx_t d = static_cast<eigen_idx_t>(theta_vals.size());
+
+    reset();
+
+    try {
+
+      std::vector<var_type> theta;
+      theta.reserve(d);
+      for (eigen_idx_t i = 0; i < d; ++i)
+        theta.push_back(var_type(theta_vals[i]));
+
+      accumulator<var_type> terms;
+      for (std::size_t n = begin; n < end; ++n)
+        terms += f(theta, data[n]);
+
+      auto f_var = compact(terms.sum(), d);
+
+      shard.val = f_var.first_val();
+      shard.partials.assign(var_node<AutodiffOrder, 3>::n_partials(d), 0);
+
+      first_order_reverse_adj(f_var);
+
+      for (eigen_idx_t i = 0; i < d; ++i)
+        shard.partials[i] = var_nodes_[i + 1].first_grad();
+
+      double* second_partials = shard.partials.data() + d;
+
+      if (AutodiffOrder == 2) {
+
+        Eigen::MatrixXd H(d, d);
+        second_order_hessian(f_var, d, H);
+
+        for (eigen_idx_t j = 0; j < d; ++j)
+          for (eigen_idx_t i = 0; i <= j; ++i)
+            second_partials[j * (j + 1) / 2 + i] = H(i, j);
+
+      } else if (AutodiffOrder >= 3) {
+
+        typedef third_order_directions<AutodiffOrder, direction_lanes> directions;
+
+        Eigen::MatrixXd H(d, d);
+        Eigen::MatrixXd grad_H(d, d * d);
+
+        expand_direction_numbers<directions>();
+        grad_hessian_columns<directions>(f_var, d, 0, 1, H, grad_H);
+
+        double* third_partials = second_partials + d * (d + 1) / 2;
+
+        for (eigen_idx_t j = 0; j < d; ++j)
+          for (eigen_idx_t k = 0; k <= j; ++k) {
+            second_partials[j * (j + 1) / 2 + k] = H(k, j);
+            for (eigen_idx_t i = 0; i <= k; ++i)
+              third_partials[j * (j + 1) * (j + 2) / 6 + k * (k + 1) / 2 + i]
+                = grad_H(j, i * d + k);
+          }
+
+      }
+
+      reset();
+
+    } catch (nomad_error&) {
+      reset();
+      throw;
+    }
+
+  }
+
+  // The sum over n of f(theta, data[n]), with f called as
+  //
+  //   var_type f(const std::vector<var_type>& theta, const Datum& datum)
+  //
+  // The data are dealt out in contiguous shards, one to each thread of the
+  // pool, which records its terms on its own stacks against fresh copies
+  // of theta and sweeps them for the first, second, and third partials of
+  // its sum as the order of the var requires.  The calling thread records
+  // its shard in a private context, so the graph it has already built is
+  // left untouched, and the shards are then added in order into a single
+  // var_node<AutodiffOrder, 3> reading theta.  The partials are dense in
+  // the size of theta, so the sum pays off for many terms over a modest
+  // number of parameters, and f must be safe to call from several threads
+  // at once.
+  //
+  // While a tape records, the terms are instead recorded one by one on the
+  // calling thread, since the dense node could not be replayed.
+  template <short AutodiffOrder, bool StrictSmoothness, bool ValidateIO, class F, class Datum>
+  var<AutodiffOrder, StrictSmoothness, ValidateIO>
+  parallel_sum(const F& f,
+               const std::vector<var<AutodiffOrder, StrictSmoothness, ValidateIO>>& theta,
+               const std::vector<Datum>& data,
+               thread_pool& pool) {
+
+    typedef var<AutodiffOrder, StrictSmoothness, ValidateIO> var_type;
+
+    if (replay_log_) {
+      accumulator<var_type> terms;
+      for (std::size_t n = 0; n < data.size(); ++n)
+        terms += f(theta, data[n]);
+      return terms.sum();
+    }
+
+    const nomad_idx_t d = static_cast<nomad_idx_t>(theta.size());
+
+    std::vector<double> theta_vals(d);
+    for (nomad_idx_t i = 0; i < d; ++i)
+      theta_vals[i] = theta[i].first_val();
+
+    const std::size_t n_shards = std::max<std::size_t>(1, std::min(pool.size(), data.size()));
+    std::vector<sum_shard> shards(n_shards);
+
+    {
+      autodiff_context private_context;
+      autodiff_context::scope bound(private_context);
+
+      pool.for_each(n_shards, [&](std::size_t s) {
+        record_sum_shard<AutodiffOrder, StrictSmoothness, ValidateIO>(
+          f, theta_vals, data, data.size() * s / n_shards,
+          data.size() * (s + 1) / n_shards, shards[s]);
+      });
+    }
+
+    for (std::size_t s = 1; s < n_shards; ++s) {
+      shards[0].val += shards[s].val;
+      for (std::size_t p = 0; p < shards[0].partials.size(); ++p)
+        shards[0].partials[p] += shards[s].partials[p];
+    }
+
+    create_node<var_node<AutodiffOrder, 3>>(d);
+    push_dual_numbers<AutodiffOrder, ValidateIO>(shards[0].val);
+
+    for (nomad_idx_t i = 0; i < d; ++i)
+      push_inputs(var_nodes_[theta[i].node()].dual_numbers());
+
+    for (std::size_t p = 0; p < shards[0].partials.size(); ++p)
+      push_partials<ValidateIO>(shards[0].partials[p]);
+
+    return var_type(next_node_idx_ - 1);
+
+  }
+
+  template <short AutodiffOrder, bool StrictSmoothness, bool ValidateIO, class F, class Datum>
+  var<AutodiffOrder, StrictSmoothness, ValidateIO>
+  parallel_sum(const F& f,
+               const std::vector<var<AutodiffOrder, StrictSmoothness, ValidateIO>>& theta,
+               const std::vector<Datum>& data,
+               std::size_t n_threads = std::thread::hardware_concurrency()) {
+    thread_pool pool(n_threads);
+    return parallel_sum(f, theta, data, pool);
+  }
+
+}
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef nomad__src__autodiff__pipeline_hpp
+#define nomad__src__autodiff__pipeline_hpp
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include <Eigen/Core>
+
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/first_order.hpp>
+
+namespace nomad {
+
+  struct gradient_result {
+    double f;
+    Eigen::VectorXd g;
+  };
+
+  // Computes gradients of a functional with recording and sweeping
+  // overlapped across two threads:
+  //
+  //   gradient_pipeline<F> pipeline(functional);
+  //   auto current = gradient_async(pipeline, x);
+  //   auto next = gradient_async(pipeline, x_proposed);
+  //   gradient_result r = current.get();
+  //
+  // One thread records the functional at each point in turn, and another
+  // runs the reverse sweep of the last graph recorded.  The graphs live in
+  // two autodiff_contexts that the threads trade back and forth, so the
+  // recording of one point proceeds while the previous one is swept, and
+  // the stacks of each context are kept from point to point.  Points are
+  // processed in the order they are submitted, and an error in the
+  // functional is rethrown by the get() of its future.  The functional is
+  // only ever called from the recording thread.
+  template <typename F>
+  class gradient_pipeline {
+  public:
+
+    typedef typename F::var_type var_type;
+
+    static_assert(is_var<var_type>::value && var_type::order() >= 1,
+                  "gradient_pipeline requires a functional of first order or higher");
+
+    explicit gradient_pipeline(const F& functional):
+    functional_(functional), stop_(false), recorder_done_(false) {
+      free_.push_back(0);
+      free_.push_back(1);
+      recorder_ = std::thread(&gradient_pipeline::record, this);
+      try {
+        sweeper_ = std::thread(&gradient_pipeline::sweep, this);
+      } catch (...) {
+        stop();
+        throw;
+      }
+    }
+
+    // Finishes every point already submitted before returning
+    ~gradient_pipeline() { stop(); }
+
+    gradient_pipeline(const gradient_pipeline&) = delete;
+    gradient_pipeline& operator=(const gradient_pipeline&) = delete;
+
+    std::future<gradient_result> submit(const Eigen::VectorXd& x) {
+      point p;
+      p.x = x;
+      std::future<gradient_result> result = p.promise.get_future();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(std::move(p));
+      }
+      changed_.notify_all();
+      return result;
+    }
+
+  private:
+
+    struct point {
+      Eigen::VectorXd x;
+      std::promise<gradient_result> promise;
+    };
+
+    struct recorded_point_graph {
+      std::size_t context;
+      nomad_idx_t output;
+      gradient_result result;
+      std::promise<gradient_result> promise;
+    };
+
+    void stop() {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+      }
+      changed_.notify_all();
+      if (recorder_.joinable()) recorder_.join();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        recorder_done_ = true;
+      }
+      changed_.notify_all();
+      if (sweeper_.joinable()) sweeper_.join();
+    }
+
+    void record() {
+      for (;;) {
+        point p;
+        std::size_t c;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          changed_.wait(lock, [this]() {
+            return (stop_ && pending_.empty()) || (!pending_.empty() && !free_.empty());
+          });
+          if (pending_.empty()) return;
+          p = std::move(pending_.front());
+          pending_.pop_front();
+          c = free_.front();
+          free_.pop_front();
+        }
+
+        recorded_point_graph r;
+        r.context = c;
+        r.promise = std::move(p.promise);
+
+        try {
+          autodiff_context::scope bound(contexts_[c]);
+          reset();
+          var_type f_var = functional_(p.x);
+          r.output = f_var.node();
+          r.result.f = f_var.first_val();
+          r.result.g.resize(p.x.size());
+        } catch (...) {
+          r.promise.set_exception(std::current_exception());
+          release(c);
+          continue;
+        }
+
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          recorded_.push_back(std::move(r));
+        }
+        changed_.notify_all();
+      }
+    }
+
+    void sweep() {
+      for (;;) {
+        recorded_point_graph r;
+        {
+          std::unique_lock<std::mutex> lock(mutex_);
+          changed_.wait(lock, [this]() { return recorder_done_ || !recorded_.empty(); });
+          if (recorded_.empty()) return;
+          r = std::move(recorded_.front());
+          recorded_.pop_front();
+        }
+
+        try {
+          autodiff_context::scope bound(contexts_[r.context]);
+          first_order_reverse_adj(var_type(r.output));
+          for (eigen_idx_t i = 0; i < r.result.g.size(); ++i)
+            r.result.g(i) = var_nodes_[i + 1].first_grad();
+          reset();
+          r.promise.set_value(std::move(r.result));
+        } catch (...) {
+          r.promise.set_exception(std::current_exception());
+        }
+
+        release(r.context);
+      }
+    }
+
+    void release(std::size_t c) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_.push_back(c);
+      }
+      changed_.notify_all();
+    }
+
+    F functional_;
+    autodiff_context contexts_[2];
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<point> pending_;
+    std::deque<recorded_point_graph> recorded_;
+    std::deque<std::size_t> free_;
+    bool stop_;
+    bool recorder_done_;
+
+    std::thread recorder_;
+    std::thread sweeper_;
+
+  };
+
+  // Queues the value and gradient of the pipeline's functional at x
+  template <typename F>
+  std::future<gradient_result> gradient_async(gradient_pipeline<F>& pipeline,
+                                              const Eigen::VectorXd& x) {
+    return pipeline.submit(x);
+  }
+
+}
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef nomad__src__autodiff__preaccumulate_hpp
+#define nomad__src__autodiff__preaccumulate_hpp
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/direction_numbers.hpp>
+#include <src/var/var.hpp>
+#include <src/var/var_node.hpp>
+#include <src/var/var_node_dispatch.hpp>
+#include <src/var/replay.hpp>
+
+namespace nomad {
+
+  // Collapses the nodes recorded on the calling thread while in scope into
+  // a single node.  The region must have one result, the var given to the
+  // guard, and no other var recorded in the region may be used after the
+  // scope closes:
+  //
+  //   T lp_n;
+  //   {
+  //     preaccumulate guard(lp_n);
+  //     lp_n = ...;
+  //   }
+  //
+  // When the scope closes, local sweeps over the region compute the first,
+  // second, and third partials of the result with respect to the nodes the
+  // region reads from before it, as the order of the var requires.  The
+  // region is then removed from the stacks and the result replaced by a
+  // var_node<AutodiffOrder, 3> holding those partials, so that later sweeps
+  // visit one node in place of the whole region.  The partials are dense in
+  // the number of inputs, so preaccumulation pays off for regions that
+  // fan a few inputs out into many nodes.
+  //
+  // The region is left as recorded while a tape records, since the dense
+  // node could not be replayed, and when the scope is left by an exception.
+  class preaccumulate {
+  public:
+
+    template <short AutodiffOrder, bool StrictSmoothness, bool ValidateIO>
+    explicit preaccumulate(var<AutodiffOrder, StrictSmoothness, ValidateIO>& output):
+    output_(&output), begin_(next_node_idx_), stack_(var_nodes_),
+    close_(&close<var<AutodiffOrder, StrictSmoothness, ValidateIO>>) {}
+
+    ~preaccumulate() {
+      if (std::uncaught_exception() || replay_log_) return;
+      if (var_nodes_ != stack_ || next_node_idx_ <= begin_) return;
+      close_(output_, begin_);
+    }
+
+    preaccumulate(const preaccumulate&) = delete;
+    preaccumulate& operator=(const preaccumulate&) = delete;
+
+  private:
+
+    template <class T_var>
+    static void close(void* output_ptr, nomad_idx_t begin) {
+
+      const short autodiff_order = T_var::order();
+      typedef scalar_directions directions;
+
+      T_var& output = *static_cast<T_var*>(output_ptr);
+      const nomad_idx_t last = output.node();
+
+      if (last < begin || last >= next_node_idx_) return;
+
+      // Nodes of the region that the result depends on, in order, and the
+      // nodes before the region that they read, in buffers kept across
+      // regions since a model may close one per observation
+      static thread_local std::vector<bool> live;
+      static thread_local std::vector<nomad_idx_t> region;
+      static thread_local std::vector<nomad_idx_t> inputs;
+      static thread_local std::vector<double> partials;
+
+      live.assign(last + 1 - begin, false);
+      live[last - begin] = true;
+
+      region.clear();
+      inputs.clear();
+
+      for (nomad_idx_t n = last + 1; n-- > begin;) {
+        if (!live[n - begin]) continue;
+
+        region.push_back(n);
+
+        for (nomad_idx_t k = 0; k < var_nodes_[n].n_inputs(); ++k) {
+          const nomad_idx_t m = input_node<autodiff_order>(n, k);
+          if (m >= begin) live[m - begin] = true;
+          else            inputs.push_back(m);
+        }
+      }
+
+      std::reverse(region.begin(), region.end());
+      std::sort(inputs.begin(), inputs.end());
+      inputs.erase(std::unique(inputs.begin(), inputs.end()), inputs.end());
+
+      const nomad_idx_t n_inputs = static_cast<nomad_idx_t>(inputs.size());
+      partials.assign(var_node<autodiff_order, 3>::n_partials(n_inputs), 0);
+
+      if (autodiff_order >= 1) {
+
+        for (std::size_t r = 0; r < region.size(); ++r)
+          var_nodes_[region[r]].first_grad() = 0;
+        for (nomad_idx_t i = 0; i < n_inputs; ++i)
+          var_nodes_[inputs[i]].first_grad() = 0;
+        var_nodes_[last].first_grad() = 1;
+
+        sweep<autodiff_order>(region, first_order_reverse_sweep(), true);
+
+        for (nomad_idx_t i = 0; i < n_inputs; ++i)
+          partials[i] = var_nodes_[inputs[i]].first_grad();
+
+      }
+
+      if (autodiff_order >= 2) {
+
+        double* second_partials = partials.data() + n_inputs;
+        double* third_partials = second_partials + n_inputs * (n_inputs + 1) / 2;
+
+        for (nomad_idx_t j = 0; j < n_inputs; ++j) {
+
+          for (nomad_idx_t i = 0; i < n_inputs; ++i) {
+            var_nodes_[inputs[i]].second_val() = static_cast<double>(i == j);
+            var_nodes_[inputs[i]].second_grad() = 0;
+          }
+
+          sweep<autodiff_order>(region, second_order_forward_sweep<directions>(), false);
+          var_nodes_[last].second_grad() = 0;
+          sweep<autodiff_order>(region, second_order_reverse_sweep<directions>(), true);
+
+          for (nomad_idx_t i = 0; i <= j; ++i)
+            second_partials[j * (j + 1) / 2 + i] = var_nodes_[inputs[i]].second_grad();
+
+          if (autodiff_order < 3) continue;
+
+          for (nomad_idx_t k = 0; k <= j; ++k) {
+
+            for (nomad_idx_t i = 0; i < n_inputs; ++i) {
+              var_nodes_[inputs[i]].third_val() = static_cast<double>(i == k);
+              var_nodes_[inputs[i]].fourth_val() = 0;
+              var_nodes_[inputs[i]].third_grad() = 0;
+              var_nodes_[inputs[i]].fourth_grad() = 0;
+            }
+
+            sweep<autodiff_order>(region, third_order_forward_sweep<directions>(), false);
+            var_nodes_[last].third_grad() = 0;
+            var_nodes_[last].fourth_grad() = 0;
+            sweep<autodiff_order>(region, third_order_reverse_sweep<directions>(), true);
+
+            for (nomad_idx_t i = 0; i <= k; ++i)
+              third_partials[j * (j + 1) * (j + 2) / 6 + k * (k + 1) / 2 + i]
+                = var_nodes_[inputs[i]].fourth_grad();
+
+          }
+
+        }
+
+      }
+
+      // The inputs are left as they were pushed
+      for (nomad_idx_t i = 0; i < n_inputs; ++i) {
+        var_node_base& input = var_nodes_[inputs[i]];
+        input.first_grad() = 0;
+        if (autodiff_order >= 2) input.second_val() = input.second_grad() = 0;
+        if (autodiff_order >= 3) {
+          input.third_val() = input.third_grad() = 0;
+          input.fourth_val() = input.fourth_grad() = 0;
+        }
+      }
+
+      const double val = output.first_val();
+
+      rewind_stacks(begin);
+
+      create_node<var_node<autodiff_order, 3>>(n_inputs);
+      push_dual_numbers<autodiff_order, false>(val);
+
+      for (nomad_idx_t i = 0; i < n_inputs; ++i)
+        push_inputs(var_nodes_[inputs[i]].dual_numbers());
+
+      for (std::size_t p = 0; p < partials.size(); ++p)
+        push_partials<false>(partials[p]);
+
+      output.set_node(next_node_idx_ - 1);
+
+    }
+
+    template <short AutodiffOrder, class Sweep>
+    static inline void sweep(const std::vector<nomad_idx_t>& region, Sweep s, bool reverse) {
+      const std::size_t n = region.size();
+      for (std::size_t r = 0; r < n; ++r)
+        visit_node<AutodiffOrder>(var_nodes_[region[reverse ? n - 1 - r : r]], s);
+    }
+
+    void* output_;
+    nomad_idx_t begin_;
+    var_node_base* stack_;
+    void (*close_)(void* output, nomad_idx_t begin);
+
+  };
+
+}
+
+#endif
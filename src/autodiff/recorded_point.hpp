@@ -0,0 +1,159 @@
+#ifndef nomad__src__autodiff__recorded_point_hpp
+#define nomad__src__autodiff__recorded_point_hpp
+
+#include <type_traits>
+
+#include <Eigen/Core>
+
+#include <src/var/var.hpp>
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/compact.hpp>
+#include <src/autodiff/direction_numbers.hpp>
+#include <src/autodiff/exceptions.hpp>
+#include <src/autodiff/first_order.hpp>
+#include <src/autodiff/second_order.hpp>
+#include <src/autodiff/third_order.hpp>
+
+namespace nomad {
+
+  // An expression graph recorded once at a fixed point, in its own context,
+  // for answering many derivative queries at that point.  The value and
+  // gradient are computed when the point is recorded, and every query after
+  // that only seeds and sweeps the higher-order components of the existing
+  // nodes, leaving the first-order adjoints in place.  The graph is released
+  // along with the point.
+  template <class T_var>
+  class recorded_point {
+  public:
+
+    template <typename F>
+    recorded_point(const F& functional, const Eigen::VectorXd& x):
+    d_(x.size()), g_(x.size()) {
+
+      autodiff_context::scope bound(context_);
+
+      reset();
+
+      try {
+
+        f_var_ = compact(functional(x), d_);
+
+        f_ = f_var_.first_val();
+
+        first_order_reverse_adj(f_var_);
+
+        for (eigen_idx_t i = 0; i < d_; ++i)
+        g_(i) = var_nodes_[i + 1].first_grad();
+
+      } catch (nomad_error&) {
+        reset();
+        throw;
+      }
+
+    }
+
+    recorded_point(const recorded_point&) = delete;
+    recorded_point& operator=(const recorded_point&) = delete;
+
+    double value() const { return f_; }
+
+    const Eigen::VectorXd& gradient() const { return g_; }
+
+    template <class T = T_var>
+    typename std::enable_if<T::order() >= 2, void >::type
+    hvp(const Eigen::VectorXd& v, Eigen::VectorXd& hessian_dot_v) {
+
+      autodiff_context::scope bound(context_);
+
+      for (eigen_idx_t i = 0; i < d_; ++i)
+      var_nodes_[i + 1].second_val() = v(i);
+
+      second_order_forward_val(f_var_);
+      second_order_reverse_adj(f_var_);
+
+      for (eigen_idx_t i = 0; i < d_; ++i)
+      hessian_dot_v(i) = var_nodes_[i + 1].second_grad();
+
+    }
+
+    // Product of the Hessian with each column of V, computing
+    // direction_lanes columns with each pair of sweeps
+    template <class T = T_var>
+    typename std::enable_if<T::order() >= 2, void >::type
+    hvp_block(const Eigen::MatrixXd& V, Eigen::MatrixXd& hessian_dot_V) {
+
+      autodiff_context::scope bound(context_);
+
+      typedef second_order_directions<T_var::order(), direction_lanes> directions;
+      expand_direction_numbers<directions>();
+
+      const eigen_idx_t m = V.cols();
+
+      for (eigen_idx_t c = 0; c < m; c += direction_lanes) {
+
+        for (eigen_idx_t j = 0; j < d_; ++j)
+        for (int k = 0; k < direction_lanes; ++k)
+        var_nodes_[j + 1].template second_val<directions>()[k] = c + k < m ? V(j, c + k) : 0;
+
+        second_order_forward_val<directions>(f_var_);
+        second_order_reverse_adj<directions>(f_var_);
+
+        for (int k = 0; k < direction_lanes && c + k < m; ++k)
+        for (eigen_idx_t j = 0; j < d_; ++j)
+        hessian_dot_V(j, c + k) = var_nodes_[j + 1].template second_grad<directions>()[k];
+
+      }
+
+    }
+
+    template <class T = T_var>
+    typename std::enable_if<T::order() >= 2, void >::type
+    hessian(Eigen::MatrixXd& H) {
+      autodiff_context::scope bound(context_);
+      second_order_hessian(f_var_, d_, H);
+    }
+
+    // Gradient of the second directional derivative along u and v, the
+    // third derivative tensor contracted with u and v
+    template <class T = T_var>
+    typename std::enable_if<T::order() >= 3, void >::type
+    third_order_contract(const Eigen::VectorXd& u,
+                         const Eigen::VectorXd& v,
+                         Eigen::VectorXd& grad_u_hessian_v) {
+
+      autodiff_context::scope bound(context_);
+
+      // Second-order
+      for (eigen_idx_t i = 0; i < d_; ++i)
+      var_nodes_[i + 1].second_val() = u(i);
+
+      second_order_forward_val(f_var_);
+      second_order_reverse_adj(f_var_);
+
+      // Third-order
+      for (eigen_idx_t i = 0; i < d_; ++i) {
+        var_nodes_[i + 1].third_val() = v(i);
+        var_nodes_[i + 1].fourth_val() = 0;
+      }
+
+      third_order_forward_val(f_var_);
+      third_order_reverse_adj(f_var_);
+
+      for (eigen_idx_t i = 0; i < d_; ++i)
+      grad_u_hessian_v(i) = var_nodes_[i + 1].fourth_grad();
+
+    }
+
+  private:
+
+    autodiff_context context_;
+    eigen_idx_t d_;
+    T_var f_var_;
+    double f_;
+    Eigen::VectorXd g_;
+
+  };
+
+}
+
+#endif
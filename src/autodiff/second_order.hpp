@@ -6,30 +6,91 @@
 #include <Eigen/Core>
 
 #include <src/var/var.hpp>
+#include <src/var/var_node_dispatch.hpp>
+#include <src/autodiff/compact.hpp>
 #include <src/autodiff/first_order.hpp>
+#include <src/autodiff/parallel.hpp>
 
 namespace nomad {
 
-  template<class T_var>
+  template<class Directions = scalar_directions, class T_var>
   void second_order_forward_val(const T_var& v) {
-    for (nomad_idx_t i = 1; i <= v.node(); ++i)
-      var_nodes_[i].second_order_forward_val();
+    sweep_nodes<T_var::order(), second_order_forward_sweep<Directions>, false>(v.node());
   }
   
-  template<class T_var>
+  template<class Directions = scalar_directions, class T_var>
   void second_order_reverse_adj(const T_var& v) {
-    var_nodes_[v.node()].second_grad() = 0;
-    for (nomad_idx_t i = v.node(); i > 0; --i)
-      var_nodes_[i].second_order_reverse_adj();
+    var_nodes_[v.node()].template second_grad<Directions>() = 0;
+    sweep_nodes<T_var::order(), second_order_reverse_sweep<Directions>, true>(v.node());
   }
 
+  // Hessian with respect to the first d nodes of a graph whose first-order
+  // adjoints have already been computed.  With more than one thread the
+  // blocks of rows are dealt out to threads sharing the graph, each sweeping
+  // with its own scratch tangents.
+  template<class T_var>
+  void second_order_hessian(const T_var& f_var,
+                            eigen_idx_t d,
+                            Eigen::MatrixXd& H,
+                            std::size_t n_threads = 1) {
+    
+    // Computing direction_lanes rows with each pair of sweeps
+    typedef second_order_directions<T_var::order(), direction_lanes> directions;
+    
+    sweep_in_parallel(n_threads, [&](std::size_t t, std::size_t n) {
+      
+      expand_direction_numbers<directions>();
+      
+      const eigen_idx_t first = static_cast<eigen_idx_t>(t) * direction_lanes;
+      const eigen_idx_t stride = static_cast<eigen_idx_t>(n) * direction_lanes;
+      
+      for (eigen_idx_t i = first; i < d; i += stride) {
+        
+        for (eigen_idx_t j = 0; j < d; ++j)
+        for (int k = 0; k < direction_lanes; ++k)
+        var_nodes_[j + 1].template second_val<directions>()[k] = static_cast<double>(i + k == j);
+        
+        second_order_forward_val<directions>(f_var);
+        second_order_reverse_adj<directions>(f_var);
+        
+        for (int k = 0; k < direction_lanes && i + k < d; ++k)
+        for (eigen_idx_t j = 0; j < d; ++j)
+        H(i + k, j) = var_nodes_[j + 1].template second_grad<directions>()[k];
+        
+      }
+      
+    });
+    
+  }
+  
+  // Gradient and Hessian of a freshly recorded graph with respect to the
+  // first d nodes
+  template<class T_var>
+  void hessian_sweeps(const T_var& f_var,
+                      eigen_idx_t d,
+                      Eigen::VectorXd& g,
+                      Eigen::MatrixXd& H,
+                      std::size_t n_threads = 1) {
+    
+    // First-order
+    first_order_reverse_adj(f_var);
+    
+    for (eigen_idx_t i = 0; i < d; ++i)
+    g(i) = var_nodes_[i + 1].first_grad();
+    
+    // Second-order
+    second_order_hessian(f_var, d, H, n_threads);
+    
+  }
+  
   template <typename F>
   typename std::enable_if<is_var<typename F::var_type>::value && F::var_type::order() >= 2, void >::type
   hessian(const F& functional,
           const Eigen::VectorXd& x,
           double& f,
           Eigen::VectorXd& g,
-          Eigen::MatrixXd& H) {
+          Eigen::MatrixXd& H,
+          std::size_t n_threads = 1) {
     
     reset();
     
@@ -37,35 +98,17 @@ namespace nomad {
     
     try {
       
-      auto f_var = functional(x);
+      auto f_var = compact(functional(x), d);
       
       f = f_var.first_val();
       
-      // First-order
-      first_order_reverse_adj(f_var);
-      
-      for (eigen_idx_t i = 0; i < d; ++i)
-      g(i) = var_nodes_[i + 1].first_grad();
-      
-      // Second-order
-      for (eigen_idx_t i = 0; i < d; ++i) {
-        
-        for (eigen_idx_t j = 0; j < d; ++j)
-        var_nodes_[j + 1].second_val() = static_cast<double>(i == j);
-        
-        second_order_forward_val(f_var);
-        second_order_reverse_adj(f_var);
-        
-        for (eigen_idx_t j = 0; j < d; ++j)
-        H(i, j) = var_nodes_[j + 1].second_grad();
-        
-      }
+      hessian_sweeps(f_var, d, g, H, n_threads);
       
       reset();
       
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       reset();
-      throw e;
+      throw;
     }
     
   }
@@ -122,17 +165,17 @@ namespace nomad {
     Eigen::MatrixXd auto_H(x.size(), x.size());
     try {
       hessian(functional, x, auto_H);
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       std::cout << "Cannot compute Hessian Test" << std::endl;
-      throw e;
+      throw;
     }
     
     Eigen::MatrixXd diff_H(x.size(), x.size());
     try {
       finite_diff_hessian(functional, x, diff_H, epsilon);
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       std::cout << "Cannot compute Hessian Test" << std::endl;
-      throw e;
+      throw;
     }
     
     std::cout.precision(6);
@@ -215,9 +258,9 @@ namespace nomad {
       
       reset();
       
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       reset();
-      throw e;
+      throw;
     }
     
   }
@@ -240,17 +283,17 @@ namespace nomad {
     Eigen::MatrixXd H_auto(x.size(), x.size());
     try {
       hessian(functional, x, H_auto);
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       std::cout << "Cannot compute Hessian Doc Vector Test" << std::endl;
-      throw e;
+      throw;
     }
     
     Eigen::VectorXd H_dot_v_auto(x.size());
     try {
       hessian_dot_vector(functional, x, v, H_dot_v_auto);
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       std::cout << "Cannot compute Hessian Doc Vector Test" << std::endl;
-      throw e;
+      throw;
     }
     
     std::cout.precision(6);
@@ -306,7 +349,7 @@ namespace nomad {
 
     try {
       
-      auto f_var = functional(x);
+      auto f_var = compact(functional(x), d);
       
       f = f_var.first_val();
       
@@ -316,26 +359,31 @@ namespace nomad {
       for (eigen_idx_t i = 0; i < d; ++i)
       g(i) = var_nodes_[i + 1].first_grad();
       
-      // Second-order
+      // Second-order, sweeping direction_lanes columns of M at a time
       trace_m_times_h = 0;
       
-      for (eigen_idx_t i = 0; i < d; ++i) {
+      typedef second_order_directions<F::var_type::order(), direction_lanes> directions;
+      expand_direction_numbers<directions>();
+      
+      for (eigen_idx_t i = 0; i < d; i += direction_lanes) {
         
         for (eigen_idx_t j = 0; j < d; ++j)
-        var_nodes_[j + 1].second_val() = M(j, i);
+        for (int k = 0; k < direction_lanes; ++k)
+        var_nodes_[j + 1].second_val<directions>()[k] = i + k < d ? M(j, i + k) : 0;
         
-        second_order_forward_val(f_var);
-        second_order_reverse_adj(f_var);
+        second_order_forward_val<directions>(f_var);
+        second_order_reverse_adj<directions>(f_var);
         
-        trace_m_times_h += var_nodes_[i + 1].second_grad();
+        for (int k = 0; k < direction_lanes && i + k < d; ++k)
+        trace_m_times_h += var_nodes_[i + k + 1].second_grad<directions>()[k];
         
       }
       
       reset();
       
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       reset();
-      throw e;
+      throw;
     }
     
   }
@@ -358,9 +406,9 @@ namespace nomad {
     Eigen::MatrixXd H_auto(x.size(), x.size());
     try {
       hessian(functional, x, H_auto);
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       std::cout << "Cannot compute Trace Matrix Times Hessian Test" << std::endl;
-      throw e;
+      throw;
     }
     
     double trace_m_times_h = (M * H_auto).trace();
@@ -368,9 +416,9 @@ namespace nomad {
     double trace_m_times_h_auto;
     try {
       trace_matrix_times_hessian(functional, x, M, trace_m_times_h_auto);
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       std::cout << "Cannot compute Trace Matrix Times Hessian Test" << std::endl;
-      throw e;
+      throw;
     }
     
     std::cout.precision(6);
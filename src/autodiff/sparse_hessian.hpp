@@ -0,0 +1,192 @@
+#ifndef nomad__src__autodiff__sparse_hessian_hpp
+#define nomad__src__autodiff__sparse_hessian_hpp
+
+#include <algorithm>
+#include <vector>
+
+#include <Eigen/Core>
+#include <Eigen/Sparse>
+
+#include <src/var/var.hpp>
+#include <src/autodiff/compact.hpp>
+#include <src/autodiff/direction_numbers.hpp>
+#include <src/autodiff/first_order.hpp>
+#include <src/autodiff/hessian_sparsity.hpp>
+#include <src/autodiff/second_order.hpp>
+
+namespace nomad {
+
+  // Greedy star coloring of the adjacency graph of a symmetric pattern,
+  // following Gebremedhin, Manne, and Pothen (2005).  Adjacent columns get
+  // distinct colors and every path on four vertices uses at least three
+  // colors, so each entry of the Hessian can be read directly off the
+  // product of the Hessian with the sum of the columns of one color.
+  // Columns are colored in order of decreasing degree, so that dense rows
+  // and columns such as those of arrow-shaped Hessians are colored first.
+  // Returns the number of colors.
+  inline nomad_idx_t star_coloring(const hessian_pattern& pattern,
+                                   std::vector<nomad_idx_t>& colors) {
+
+    const nomad_idx_t uncolored = static_cast<nomad_idx_t>(-1);
+    const nomad_idx_t n = pattern.n;
+
+    colors.assign(n, uncolored);
+    std::vector<nomad_idx_t> forbidden(n + 1, uncolored);
+    nomad_idx_t n_colors = 0;
+
+    std::vector<nomad_idx_t> order(n);
+    for (nomad_idx_t v = 0; v < n; ++v) order[v] = v;
+    std::stable_sort(order.begin(), order.end(), [&pattern](nomad_idx_t u, nomad_idx_t v) {
+      return pattern.outer[u + 1] - pattern.outer[u] > pattern.outer[v + 1] - pattern.outer[v];
+    });
+
+    for (nomad_idx_t v : order) {
+
+      for (nomad_idx_t a = pattern.outer[v]; a < pattern.outer[v + 1]; ++a) {
+        const nomad_idx_t w = pattern.inner[a];
+        if (w == v) continue;
+        if (colors[w] != uncolored) forbidden[colors[w]] = v;
+
+        for (nomad_idx_t b = pattern.outer[w]; b < pattern.outer[w + 1]; ++b) {
+          const nomad_idx_t x = pattern.inner[b];
+          if (x == v || x == w || colors[x] == uncolored) continue;
+
+          if (colors[w] == uncolored) {
+            forbidden[colors[x]] = v;
+          } else {
+            // Coloring v like x would complete a two-colored path through
+            // x whenever x already has another neighbor colored like w
+            for (nomad_idx_t c = pattern.outer[x]; c < pattern.outer[x + 1]; ++c) {
+              const nomad_idx_t y = pattern.inner[c];
+              if (y != w && y != x && colors[y] == colors[w]) {
+                forbidden[colors[x]] = v;
+                break;
+              }
+            }
+          }
+        }
+      }
+
+      nomad_idx_t color = 0;
+      while (forbidden[color] == v) ++color;
+      colors[v] = color;
+      if (color + 1 > n_colors) n_colors = color + 1;
+
+    }
+
+    return n_colors;
+
+  }
+
+  // Computes the Hessian entries in the given pattern with one pair of
+  // second-order sweeps per color of a star coloring, instead of one per
+  // input, seeding every input of a color in the same direction.  All of the
+  // sweeps reuse the graph recorded at x.
+  template <typename F>
+  typename std::enable_if<is_var<typename F::var_type>::value && F::var_type::order() >= 2, void >::type
+  sparse_hessian(const F& functional,
+                 const Eigen::VectorXd& x,
+                 const hessian_pattern& pattern,
+                 double& f,
+                 Eigen::VectorXd& g,
+                 Eigen::SparseMatrix<double>& H) {
+
+    reset();
+
+    eigen_idx_t d = x.size();
+
+    if (static_cast<eigen_idx_t>(pattern.n) != d)
+      throw nomad_error("The Hessian pattern passed to sparse_hessian does not match the number of inputs");
+
+    std::vector<nomad_idx_t> colors;
+    const nomad_idx_t n_colors = star_coloring(pattern, colors);
+
+    try {
+
+      auto f_var = compact(functional(x), d);
+
+      f = f_var.first_val();
+
+      // First-order
+      first_order_reverse_adj(f_var);
+
+      for (eigen_idx_t i = 0; i < d; ++i)
+      g(i) = var_nodes_[i + 1].first_grad();
+
+      // Second-order, compressing the Hessian into one column per color and
+      // computing direction_lanes colors with each pair of sweeps
+      typedef second_order_directions<F::var_type::order(), direction_lanes> directions;
+      expand_direction_numbers<directions>();
+
+      Eigen::MatrixXd B(d, n_colors);
+
+      for (nomad_idx_t c = 0; c < n_colors; c += direction_lanes) {
+
+        for (eigen_idx_t j = 0; j < d; ++j)
+        for (int k = 0; k < direction_lanes; ++k)
+        var_nodes_[j + 1].second_val<directions>()[k] = static_cast<double>(c + k == colors[j]);
+
+        second_order_forward_val<directions>(f_var);
+        second_order_reverse_adj<directions>(f_var);
+
+        for (int k = 0; k < direction_lanes && c + k < n_colors; ++k)
+        for (eigen_idx_t i = 0; i < d; ++i)
+        B(i, c + k) = var_nodes_[i + 1].second_grad<directions>()[k];
+
+      }
+
+      reset();
+
+      // Recovery, reading H(i, j) from row i of the compressed column of the
+      // color of j when no other column of row i shares that color, and
+      // otherwise from row j of the compressed column of the color of i
+      std::vector<Eigen::Triplet<double> > entries;
+      entries.reserve(pattern.nonzeros());
+
+      std::vector<nomad_idx_t> color_count(n_colors, 0);
+
+      for (nomad_idx_t i = 0; i < pattern.n; ++i) {
+        const nomad_idx_t begin = pattern.outer[i];
+        const nomad_idx_t end = pattern.outer[i + 1];
+
+        for (nomad_idx_t a = begin; a < end; ++a) ++color_count[colors[pattern.inner[a]]];
+
+        for (nomad_idx_t a = begin; a < end; ++a) {
+          const nomad_idx_t j = pattern.inner[a];
+          const double h = color_count[colors[j]] == 1 ? B(i, colors[j]) : B(j, colors[i]);
+          entries.push_back(Eigen::Triplet<double>(i, j, h));
+        }
+
+        for (nomad_idx_t a = begin; a < end; ++a) color_count[colors[pattern.inner[a]]] = 0;
+      }
+
+      H.resize(d, d);
+      H.setFromTriplets(entries.begin(), entries.end());
+
+    } catch (nomad_error&) {
+      reset();
+      throw;
+    }
+
+  }
+
+  template <typename F>
+  void sparse_hessian(const F& functional,
+                      const Eigen::VectorXd& x,
+                      const hessian_pattern& pattern,
+                      Eigen::SparseMatrix<double>& H) {
+    double f;
+    Eigen::VectorXd g(x.size());
+    sparse_hessian(functional, x, pattern, f, g, H);
+  }
+
+  template <typename F>
+  void sparse_hessian(const F& functional,
+                      const Eigen::VectorXd& x,
+                      Eigen::SparseMatrix<double>& H) {
+    sparse_hessian(functional, x, hessian_sparsity(functional, x), H);
+  }
+
+}
+
+#endif
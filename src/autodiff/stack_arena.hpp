@@ -0,0 +1,173 @@
+#ifndef nomad__src__autodiff__stack_arena_hpp
+#define nomad__src__autodiff__stack_arena_hpp
+
+#include <climits>
+#include <cstddef>
+#include <new>
+
+#include <sys/mman.h>
+
+#include <src/autodiff/exceptions.hpp>
+#include <src/autodiff/typedefs.hpp>
+
+namespace nomad {
+
+  // Each stack reserves a contiguous range of virtual addresses on first use
+  // and commits that range in fixed-size chunks as the stack grows.  Growing
+  // a stack never copies or moves existing records, so the base pointer and
+  // every record stay valid until the stack is released.
+
+  const std::size_t stack_chunk_bytes = std::size_t(1) << 21;
+  std::size_t stack_reserve_bytes = std::size_t(1) << 35;
+
+  inline std::size_t round_up_to_chunk(std::size_t n_bytes) {
+    return (n_bytes + stack_chunk_bytes - 1) / stack_chunk_bytes * stack_chunk_bytes;
+  }
+
+  // Back the stacks with transparent huge pages where the system supports
+  // them, which keeps the indirect accesses of long sweeps within the TLB.
+  // Chunks are aligned to the huge page size either way.
+  bool stack_huge_pages_ = true;
+
+  // An optional limit on the memory committed to the stacks of each thread
+  // or autodiff_context, with zero indicating no limit
+  std::size_t stack_memory_cap_ = 0;
+  thread_local std::size_t committed_stack_bytes_ = 0;
+
+  inline void advise_huge_pages(void* begin, std::size_t n_bytes) {
+#ifdef MADV_HUGEPAGE
+    // Failure leaves the range on regular pages, which is still correct
+    if (stack_huge_pages_) madvise(begin, n_bytes, MADV_HUGEPAGE);
+#else
+    (void)begin; (void)n_bytes;
+#endif
+  }
+
+  // Reserves the address range of a stack that has not yet been used
+  template<typename T>
+  void reserve_stack(T*& stack, nomad_idx_t& max_idx, nomad_idx_t& reserved_idx) {
+
+    // Elements beyond the range of nomad_idx_t can never be addressed
+    std::size_t n_bytes = stack_reserve_bytes;
+    if (n_bytes / sizeof(T) > UINT_MAX) n_bytes = sizeof(T) * std::size_t(UINT_MAX);
+
+    std::size_t n_chunks = n_bytes / stack_chunk_bytes;
+    void* base = MAP_FAILED;
+
+    // Fall back to smaller reservations when the address space is limited.
+    // One extra chunk leaves room to align the range to a chunk boundary.
+    for (; n_chunks > 0; n_chunks /= 2) {
+      base = mmap(0, (n_chunks + 1) * stack_chunk_bytes, PROT_NONE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if (base != MAP_FAILED) break;
+    }
+
+    if (base == MAP_FAILED) throw std::bad_alloc();
+
+    char* unaligned = static_cast<char*>(base);
+    char* aligned = reinterpret_cast<char*>(
+      round_up_to_chunk(reinterpret_cast<std::size_t>(unaligned)));
+    char* end = aligned + n_chunks * stack_chunk_bytes;
+
+    if (aligned > unaligned) munmap(unaligned, aligned - unaligned);
+    munmap(end, unaligned + (n_chunks + 1) * stack_chunk_bytes - end);
+
+    advise_huge_pages(aligned, n_chunks * stack_chunk_bytes);
+
+    stack = reinterpret_cast<T*>(aligned);
+    max_idx = 0;
+    reserved_idx = static_cast<nomad_idx_t>(n_chunks * stack_chunk_bytes / sizeof(T));
+
+  }
+
+  // Commits the first target_idx elements of each of n_lanes lanes, spaced
+  // lane_stride elements apart, or only min_idx elements if the larger commit
+  // would overrun a lane or exceed the memory cap.  The committed memory of
+  // each lane always extends to the chunk boundary above max_idx.
+  template<typename T>
+  void commit_lanes(T* stack, nomad_idx_t& max_idx,
+                    std::size_t lane_stride, std::size_t n_lanes,
+                    std::size_t min_idx, std::size_t target_idx) {
+
+    if (min_idx > lane_stride) throw std::bad_alloc();
+
+    if (target_idx < min_idx) target_idx = min_idx;
+    if (target_idx > lane_stride) target_idx = lane_stride;
+    if (target_idx <= max_idx) return;
+
+    std::size_t begin = round_up_to_chunk(sizeof(T) * std::size_t(max_idx));
+    std::size_t end = round_up_to_chunk(sizeof(T) * target_idx);
+
+    if (stack_memory_cap_
+        && committed_stack_bytes_ + n_lanes * (end - begin) > stack_memory_cap_) {
+      target_idx = min_idx > max_idx ? min_idx : max_idx;
+      end = round_up_to_chunk(sizeof(T) * target_idx);
+      if (committed_stack_bytes_ + n_lanes * (end - begin) > stack_memory_cap_)
+        throw nomad_memory_error(stack_memory_cap_);
+    }
+
+    if (end > begin) {
+      for (std::size_t k = 0; k < n_lanes; ++k) {
+        char* base = reinterpret_cast<char*>(stack + k * lane_stride);
+        if (mprotect(base + begin, end - begin, PROT_READ | PROT_WRITE))
+          throw std::bad_alloc();
+        committed_stack_bytes_ += end - begin;
+      }
+    }
+
+    max_idx = static_cast<nomad_idx_t>(target_idx);
+
+  }
+
+  template<typename T>
+  void commit_stack(T*& stack, nomad_idx_t& max_idx, nomad_idx_t& reserved_idx,
+                    std::size_t min_idx, std::size_t target_idx) {
+    if (!stack) reserve_stack(stack, max_idx, reserved_idx);
+    commit_lanes(stack, max_idx, reserved_idx, 1, min_idx, target_idx);
+  }
+
+  // Returns the memory committed beyond keep_idx elements of each lane to
+  // the system
+  template<typename T>
+  void decommit_lanes(T* stack, nomad_idx_t& max_idx,
+                      std::size_t lane_stride, std::size_t n_lanes,
+                      std::size_t keep_idx) {
+
+    if (!stack || keep_idx >= max_idx) return;
+
+    std::size_t begin = round_up_to_chunk(sizeof(T) * keep_idx);
+    std::size_t end = round_up_to_chunk(sizeof(T) * std::size_t(max_idx));
+
+    if (end > begin) {
+      for (std::size_t k = 0; k < n_lanes; ++k) {
+        // The pages stay mapped, and are refilled with zeros when next touched
+        char* base = reinterpret_cast<char*>(stack + k * lane_stride);
+        madvise(base + begin, end - begin, MADV_DONTNEED);
+        committed_stack_bytes_ -= end - begin;
+      }
+    }
+
+    max_idx = static_cast<nomad_idx_t>(keep_idx);
+
+  }
+
+  template<typename T>
+  void decommit_stack(T* stack, nomad_idx_t& max_idx, std::size_t keep_idx) {
+    decommit_lanes(stack, max_idx, 0, 1, keep_idx);
+  }
+
+  template<typename T>
+  void release_stack(T*& stack, nomad_idx_t& max_idx, nomad_idx_t& reserved_idx,
+                     std::size_t n_lanes = 1) {
+    if (stack) {
+      committed_stack_bytes_ -= n_lanes * round_up_to_chunk(sizeof(T) * std::size_t(max_idx));
+      munmap(stack, round_up_to_chunk(sizeof(T) * std::size_t(reserved_idx)));
+    }
+    stack = 0;
+    max_idx = 0;
+    reserved_idx = 0;
+  }
+
+}
+
+#endif
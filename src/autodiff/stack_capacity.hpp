@@ -0,0 +1,83 @@
+#ifndef nomad__src__autodiff__stack_capacity_hpp
+#define nomad__src__autodiff__stack_capacity_hpp
+
+#include <Eigen/Core>
+
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/dual_number_layout.hpp>
+#include <src/var/var_node.hpp>
+
+namespace nomad {
+
+  // Number of nodes, partials, and inputs in an expression graph
+  struct stack_sizes {
+    nomad_idx_t n_nodes;
+    nomad_idx_t n_partials;
+    nomad_idx_t n_inputs;
+  };
+
+  // Sizes of the expression graph currently held by the calling thread
+  inline stack_sizes stack_usage() {
+    stack_sizes sizes = { next_node_idx_ - 1, next_partials_idx_ - 1, next_inputs_idx_ - 1 };
+    return sizes;
+  }
+
+  // Largest expression graph recorded while track_high_water_mark_ was set
+  inline stack_sizes high_water_mark() {
+    stack_sizes sizes = { 0, 0, 0 };
+    if (nomad_idx_t n = high_water_node_idx_.load()) sizes.n_nodes = n - 1;
+    if (nomad_idx_t n = high_water_partials_idx_.load()) sizes.n_partials = n - 1;
+    if (nomad_idx_t n = high_water_inputs_idx_.load()) sizes.n_inputs = n - 1;
+    return sizes;
+  }
+
+  // Commits the stacks of the calling thread to hold an expression graph of
+  // the given size, so that recording it performs no further allocations
+  void reserve(nomad_idx_t n_nodes, nomad_idx_t n_partials, nomad_idx_t n_inputs) {
+
+    thread_stacks_guard_.touch();
+
+    std::size_t node_idx = std::size_t(n_nodes) + 1;
+    expand_dual_numbers(node_idx, node_idx);
+    commit_stack(var_nodes_, max_node_idx, reserved_node_idx, node_idx, node_idx);
+
+    commit_stack(partials_, max_partials_idx, reserved_partials_idx,
+                 std::size_t(n_partials) + 1, std::size_t(n_partials) + 1);
+    commit_stack(inputs_, max_inputs_idx, reserved_inputs_idx,
+                 std::size_t(n_inputs) + 1, std::size_t(n_inputs) + 1);
+
+  }
+
+  void reserve(const stack_sizes& sizes) {
+    reserve(sizes.n_nodes, sizes.n_partials, sizes.n_inputs);
+  }
+
+  // Returns the memory committed beyond the current expression graph of the
+  // calling thread to the system; after reset() this releases everything
+  // except the address ranges themselves
+  void shrink_to_fit() {
+    // The dual numbers keep covering every committed node
+    std::size_t node_idx = next_node_idx_ > 1 ? next_node_idx_ : 0;
+    decommit_stack(var_nodes_, max_node_idx, node_idx);
+    dual_number_layout::decommit(node_idx);
+    decommit_stack(partials_, max_partials_idx,
+                   next_partials_idx_ > 1 ? next_partials_idx_ : 0);
+    decommit_stack(inputs_, max_inputs_idx,
+                   next_inputs_idx_ > 1 ? next_inputs_idx_ : 0);
+    decommit_stack(direction_numbers_, max_direction_number_idx, 0);
+  }
+
+  // Records the functional in a scratch context, leaving the stacks of the
+  // calling thread untouched, and returns the exact sizes it requires.  The
+  // values of the graph drive its control flow, so they are recorded too.
+  template <typename F>
+  stack_sizes measure_stacks(const F& functional, const Eigen::VectorXd& x) {
+    autodiff_context context;
+    autodiff_context::scope bound(context);
+    functional(x);
+    return stack_usage();
+  }
+
+}
+
+#endif
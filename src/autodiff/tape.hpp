@@ -0,0 +1,279 @@
+#ifndef nomad__src__autodiff__tape_hpp
+#define nomad__src__autodiff__tape_hpp
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <Eigen/Core>
+
+#include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/exceptions.hpp>
+#include <src/autodiff/first_order.hpp>
+#include <src/autodiff/level_schedule.hpp>
+#include <src/autodiff/second_order.hpp>
+
+namespace nomad {
+
+  // An expression graph recorded once in its own context and then replayed
+  // at new inputs.  Replaying refreshes the values and partials of every
+  // node in place, in the order they were recorded, without running the
+  // functional or allocating, after which the usual sweeps apply.  The
+  // functional must reach its inputs only through the vars it creates from
+  // them, in order, at the bottom of the graph.  It may branch on their
+  // values through the comparison operators, fmin, and fmax, whose outcomes
+  // are checked as the tape is replayed, and the graph is recorded again at
+  // the new inputs whenever one of them changes.  A graph containing a node
+  // that cannot be replayed, for example one created by a function outside
+  // the library, is recorded again on every replay.
+  template <class T_var>
+  class tape {
+  public:
+
+    tape(): output_(0), n_inputs_(0), replayable_(false), recordings_(0), scheduled_recording_(0) {
+      end_idx_[0] = end_idx_[1] = end_idx_[2] = end_idx_[3] = 1;
+    }
+
+    tape(const tape&) = delete;
+    tape& operator=(const tape&) = delete;
+
+    template <typename F>
+    void record(const F& functional, const Eigen::VectorXd& x) {
+      functional_ = functional;
+      record(x);
+    }
+
+    void replay(const Eigen::VectorXd& x) {
+      if (!replayable_ || x.size() != static_cast<eigen_idx_t>(n_inputs_) || !replay_nodes(x))
+        record(x);
+    }
+
+    bool replayable() const { return replayable_; }
+
+    // Number of times the functional has been recorded, including the
+    // recordings forced by a violated guard
+    std::size_t recordings() const { return recordings_; }
+
+    nomad_idx_t n_inputs() const { return n_inputs_; }
+
+    // The output, which is only meaningful while the context is bound
+    T_var output() const { return T_var(output_); }
+
+    autodiff_context& context() { return context_; }
+
+    // Level schedule of the recorded graph, built on first use after each
+    // recording, which is only meaningful while the context is bound
+    level_schedule<T_var::order()>& schedule() {
+      if (!schedule_ || scheduled_recording_ != recordings_) {
+        schedule_.reset(new level_schedule<T_var::order()>(output_));
+        scheduled_recording_ = recordings_;
+      }
+      return *schedule_;
+    }
+
+    // Replay entries of the nodes with inputs, in node order, and the
+    // guards checked along the way
+    const std::vector<replay_entry>& log() const { return log_; }
+    const std::vector<replay_guard>& guards() const { return guards_; }
+
+  private:
+
+    // Replays the nodes in order, stopping as soon as a guard is violated
+    bool replay_nodes(const Eigen::VectorXd& x) {
+
+      autodiff_context::scope bound(context_);
+      unsimplified_recording in_place;
+
+      try {
+
+        typename std::vector<replay_entry>::const_iterator entry = log_.begin();
+        typename std::vector<replay_guard>::const_iterator guard = guards_.begin();
+        bool positioned = false;
+
+        for (nomad_idx_t n = 1; ; ++n) {
+          for (; guard != guards_.end() && guard->node == n; ++guard) {
+            if (!guard->holds()) {
+              restore_stacks();
+              return false;
+            }
+          }
+
+          if (n == end_idx_[0]) break;
+
+          if (!positioned) rewind_stacks(n);
+
+          if (var_nodes_[n].n_inputs()) {
+            entry->replay(*entry);
+            positioned = entry->function != 0;
+            ++entry;
+          } else {
+            // Leaves, clearing their adjoints along with those of the
+            // replayed nodes
+            T_var(n <= n_inputs_ ? x(n - 1) : var_nodes_[n].first_val());
+            positioned = true;
+          }
+        }
+
+        restore_stacks();
+
+      } catch (nomad_error&) {
+        restore_stacks();
+        throw;
+      }
+
+      return true;
+
+    }
+
+    void record(const Eigen::VectorXd& x) {
+
+      if (!functional_)
+        throw nomad_error("Nomad tape replayed before a functional was recorded");
+
+      autodiff_context::scope bound(context_);
+
+      reset();
+      log_.clear();
+      guards_.clear();
+      replayable_ = false;
+      ++recordings_;
+
+      std::vector<replay_entry>* enclosing_log = replay_log_;
+      std::vector<replay_guard>* enclosing_guard_log = replay_guard_log_;
+      replay_log_ = &log_;
+      replay_guard_log_ = &guards_;
+
+      try {
+        output_ = functional_(x).node();
+      } catch (...) {
+        replay_log_ = enclosing_log;
+        replay_guard_log_ = enclosing_guard_log;
+        output_ = 0;
+        reset();
+        throw;
+      }
+
+      replay_log_ = enclosing_log;
+      replay_guard_log_ = enclosing_guard_log;
+
+      n_inputs_ = static_cast<nomad_idx_t>(x.size());
+      end_idx_[0] = next_node_idx_;
+      end_idx_[1] = next_dual_number_idx_;
+      end_idx_[2] = next_partials_idx_;
+      end_idx_[3] = next_inputs_idx_;
+
+      replayable_ = logged_every_node();
+
+    }
+
+    // Every node is either a leaf, with the inputs first, or has exactly
+    // one entry in the log
+    bool logged_every_node() const {
+      if (end_idx_[0] <= n_inputs_) return false;
+
+      typename std::vector<replay_entry>::const_iterator entry = log_.begin();
+
+      for (nomad_idx_t n = 1; n < end_idx_[0]; ++n) {
+        const bool logged = entry != log_.end() && entry->node == n;
+        if (var_nodes_[n].n_inputs()) {
+          if (!logged || n <= n_inputs_) return false;
+          ++entry;
+        } else if (logged) {
+          return false;
+        }
+      }
+
+      return entry == log_.end();
+    }
+
+    void restore_stacks() {
+      next_node_idx_ = end_idx_[0];
+      next_dual_number_idx_ = end_idx_[1];
+      next_partials_idx_ = end_idx_[2];
+      next_inputs_idx_ = end_idx_[3];
+    }
+
+    autodiff_context context_;
+    std::vector<replay_entry> log_;
+    std::vector<replay_guard> guards_;
+    std::function<T_var(const Eigen::VectorXd&)> functional_;
+    std::unique_ptr<level_schedule<T_var::order()>> schedule_;
+
+    nomad_idx_t output_;
+    nomad_idx_t n_inputs_;
+    nomad_idx_t end_idx_[4];
+    bool replayable_;
+    std::size_t recordings_;
+    std::size_t scheduled_recording_;
+
+  };
+
+  template <class T_var>
+  typename std::enable_if<T_var::order() >= 1, void >::type
+  gradient(tape<T_var>& t,
+           const Eigen::VectorXd& x,
+           double& f,
+           Eigen::VectorXd& g) {
+
+    t.replay(x);
+
+    autodiff_context::scope bound(t.context());
+
+    T_var f_var = t.output();
+    f = f_var.first_val();
+    first_order_reverse_adj(f_var);
+
+    for (eigen_idx_t i = 0; i < x.size(); ++i)
+    g(i) = var_nodes_[i + 1].first_grad();
+
+  }
+
+  // Gradient with the reverse sweep split across threads by the level
+  // schedule of the tape
+  template <class T_var>
+  typename std::enable_if<T_var::order() >= 1, void >::type
+  gradient(tape<T_var>& t,
+           const Eigen::VectorXd& x,
+           double& f,
+           Eigen::VectorXd& g,
+           std::size_t n_threads) {
+
+    t.replay(x);
+
+    autodiff_context::scope bound(t.context());
+
+    T_var f_var = t.output();
+    f = f_var.first_val();
+    first_order_reverse_adj(f_var, t.schedule(), n_threads);
+
+    for (eigen_idx_t i = 0; i < x.size(); ++i)
+    g(i) = var_nodes_[i + 1].first_grad();
+
+  }
+
+  template <class T_var>
+  typename std::enable_if<T_var::order() >= 2, void >::type
+  hessian(tape<T_var>& t,
+          const Eigen::VectorXd& x,
+          double& f,
+          Eigen::VectorXd& g,
+          Eigen::MatrixXd& H,
+          std::size_t n_threads = 1) {
+
+    t.replay(x);
+
+    autodiff_context::scope bound(t.context());
+
+    T_var f_var = t.output();
+    f = f_var.first_val();
+    hessian_sweeps(f_var, x.size(), g, H, n_threads);
+
+  }
+
+}
+
+#endif
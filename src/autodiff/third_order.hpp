@@ -6,23 +6,78 @@
 #include <Eigen/Core>
 
 #include <src/var/var.hpp>
+#include <src/var/var_node_dispatch.hpp>
+#include <src/autodiff/compact.hpp>
 #include <src/autodiff/first_order.hpp>
 #include <src/autodiff/second_order.hpp>
 
 namespace nomad {
 
-  template<class T_var>
+  template<class Directions = scalar_directions, class T_var>
   void third_order_forward_val(const T_var& v) {
-    for (nomad_idx_t i = 1; i <= v.node(); ++i)
-      var_nodes_[i].third_order_forward_val();
+    sweep_nodes<T_var::order(), third_order_forward_sweep<Directions>, false>(v.node());
   }
   
-  template<class T_var>
+  template<class Directions = scalar_directions, class T_var>
   void third_order_reverse_adj(const T_var& v) {
-    var_nodes_[v.node()].third_grad() = 0;
-    var_nodes_[v.node()].fourth_grad() = 0;
-    for (nomad_idx_t i = v.node(); i > 0; --i)
-      var_nodes_[i].third_order_reverse_adj();
+    var_nodes_[v.node()].template third_grad<Directions>() = 0;
+    var_nodes_[v.node()].template fourth_grad<Directions>() = 0;
+    sweep_nodes<T_var::order(), third_order_reverse_sweep<Directions>, true>(v.node());
+  }
+
+  // Columns first, first + stride, ... of the Hessian and of its gradient,
+  // of a graph whose first-order adjoints have already been computed
+  template<class Directions, class T_var>
+  void grad_hessian_columns(const T_var& f_var,
+                            eigen_idx_t d,
+                            eigen_idx_t first,
+                            eigen_idx_t stride,
+                            Eigen::MatrixXd& H,
+                            Eigen::MatrixXd& grad_H) {
+    
+    Eigen::VectorXd v(d);
+    
+    for (eigen_idx_t i = first; i < d; i += stride) {
+      
+      // Second-order
+      for (eigen_idx_t j = 0; j < d; ++j)
+      var_nodes_[j + 1].template second_val<Directions>() = static_cast<double>(i == j);
+      
+      second_order_forward_val<Directions>(f_var);
+      second_order_reverse_adj<Directions>(f_var);
+      
+      for (eigen_idx_t j = 0; j < d; ++j)
+      v(j) = var_nodes_[j + 1].template second_grad<Directions>();
+      
+      H.col(i) = v;
+      
+      // Third-order, computing direction_lanes columns with each pair of sweeps
+      for (eigen_idx_t j = 0; j < d; ++j)
+      var_nodes_[j + 1].template fourth_val<Directions>() = 0;
+      
+      for (eigen_idx_t k = 0; k <= i; k += direction_lanes) {
+        
+        for (eigen_idx_t j = 0; j < d; ++j)
+        for (int l = 0; l < direction_lanes; ++l)
+        var_nodes_[j + 1].template third_val<Directions>()[l] = static_cast<double>(k + l == j);
+        
+        third_order_forward_val<Directions>(f_var);
+        third_order_reverse_adj<Directions>(f_var);
+        
+        for (int l = 0; l < direction_lanes && k + l <= i; ++l) {
+          
+          for (eigen_idx_t j = 0; j < d; ++j)
+          v(j) = var_nodes_[j + 1].template fourth_grad<Directions>()[l];
+          
+          grad_H.block(0, i * d, d, d).col(k + l) = v;
+          grad_H.block(0, (k + l) * d, d, d).col(i) = v;
+          
+        }
+        
+      }
+      
+    }
+    
   }
 
   template <typename F>
@@ -32,7 +87,8 @@ namespace nomad {
                double& f,
                Eigen::VectorXd& g,
                Eigen::MatrixXd& H,
-               Eigen::MatrixXd& grad_H) {
+               Eigen::MatrixXd& grad_H,
+               std::size_t n_threads = 1) {
     
     reset();
     
@@ -40,7 +96,7 @@ namespace nomad {
     
     try {
       
-      auto f_var = functional(x);
+      auto f_var = compact(functional(x), d);
       
       f = f_var.first_val();
       
@@ -50,53 +106,32 @@ namespace nomad {
       for (eigen_idx_t i = 0; i < d; ++i)
       g(i) = var_nodes_[i + 1].first_grad();
       
-      Eigen::VectorXd v(d);
-      
-      for (eigen_idx_t i = 0; i < d; ++i) {
+      // Third-order, with the columns dealt out to threads sharing the graph
+      // when more than one is asked for
+      if (n_threads > 1) {
         
-        // Second-order
-        for (eigen_idx_t j = 0; j < d; ++j)
-        var_nodes_[j + 1].second_val() = static_cast<double>(i == j);
+        typedef private_third_order_directions<F::var_type::order(), direction_lanes> directions;
         
-        second_order_forward_val(f_var);
-        second_order_reverse_adj(f_var);
+        sweep_in_parallel(n_threads, [&](std::size_t t, std::size_t n) {
+          expand_direction_numbers<directions>();
+          grad_hessian_columns<directions>(f_var, d, static_cast<eigen_idx_t>(t),
+                                           static_cast<eigen_idx_t>(n), H, grad_H);
+        });
         
-        for (Eigen::internal::traits<Eigen::Matrix<double,Eigen::Dynamic,Eigen::Dynamic> >::Index j = 0; j < d; ++j)
-        v(j) = var_nodes_[j + 1].second_grad();
+      } else {
         
-        H.col(i) = v;
+        typedef third_order_directions<F::var_type::order(), direction_lanes> directions;
         
-        // Third-order
-        for (eigen_idx_t j = 0; j < d; ++j)
-        var_nodes_[j + 1].fourth_val() = 0;
-        
-        for (eigen_idx_t k = 0; k <= i; ++k) {
-          
-          for (eigen_idx_t j = 0; j < d; ++j)
-          var_nodes_[j + 1].third_val() = static_cast<double>(k == j);
-          
-          third_order_forward_val(f_var);
-          
-          for (eigen_idx_t j = 0; j < d; ++j)
-          v(j) = var_nodes_[j + 1].fourth_grad();
-          
-          third_order_reverse_adj(f_var);
-          
-          for (eigen_idx_t j = 0; j < d; ++j)
-          v(j) = var_nodes_[j + 1].fourth_grad();
-          
-          grad_H.block(0, i * d, d, d).col(k) = v;
-          grad_H.block(0, k * d, d, d).col(i) = v;
-          
-        }
+        expand_direction_numbers<directions>();
+        grad_hessian_columns<directions>(f_var, d, 0, 1, H, grad_H);
         
       }
       
       reset();
       
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       reset();
-      throw e;
+      throw;
     }
     
   }
@@ -154,17 +189,17 @@ namespace nomad {
     Eigen::MatrixXd auto_grad_H(d, d * d);
     try {
       grad_hessian(functional, x, auto_grad_H);
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       std::cout << "Cannot compute Hessian Gradient Test" << std::endl;
-      throw e;
+      throw;
     }
     
     Eigen::MatrixXd diff_grad_H(d, d * d);
     try {
       finite_diff_grad_hessian(functional, x, diff_grad_H, epsilon);
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       std::cout << "Cannot compute Hessian Gradient Test" << std::endl;
-      throw e;
+      throw;
     }
     
     std::cout.precision(6);
@@ -218,6 +253,51 @@ namespace nomad {
     
   }
   
+  // Columns first, first + stride, ... of the Hessian, and the gradients of
+  // M.col(i) . H.col(i) with respect to the first d nodes for each of those
+  // columns, of a graph whose first-order adjoints have already been computed
+  template<class Directions, class T_var>
+  void grad_trace_columns(const T_var& f_var,
+                          const Eigen::MatrixXd& M,
+                          eigen_idx_t first,
+                          eigen_idx_t stride,
+                          Eigen::MatrixXd& H,
+                          Eigen::MatrixXd& terms) {
+    
+    const eigen_idx_t d = M.rows();
+    Eigen::VectorXd v(d);
+    
+    for (eigen_idx_t i = first; i < d; i += stride) {
+      
+      // Second-order
+      for (eigen_idx_t j = 0; j < d; ++j)
+      var_nodes_[j + 1].template second_val<Directions>() = static_cast<double>(i == j);
+      
+      second_order_forward_val<Directions>(f_var);
+      second_order_reverse_adj<Directions>(f_var);
+      
+      for (eigen_idx_t j = 0; j < d; ++j)
+      v(j) = var_nodes_[j + 1].template second_grad<Directions>();
+      
+      H.col(i) = v;
+      
+      // Third-order
+      for (eigen_idx_t j = 0; j < d; ++j)
+      var_nodes_[j + 1].template fourth_val<Directions>() = 0;
+      
+      for (eigen_idx_t j = 0; j < d; ++j)
+      var_nodes_[j + 1].template third_val<Directions>() = M(j, i);
+      
+      third_order_forward_val<Directions>(f_var);
+      third_order_reverse_adj<Directions>(f_var);
+      
+      for (eigen_idx_t j = 0; j < d; ++j)
+      terms(j, i) = var_nodes_[j + 1].template fourth_grad<Directions>()[0];
+      
+    }
+    
+  }
+  
   template <typename F>
   typename std::enable_if<is_var<typename F::var_type>::value && F::var_type::order() >= 3, void >::type
   grad_trace_matrix_times_hessian(const F& functional,
@@ -226,7 +306,8 @@ namespace nomad {
                                   double& f,
                                   Eigen::VectorXd& g,
                                   Eigen::MatrixXd& H,
-                                  Eigen::VectorXd& grad_trace_m_times_h) {
+                                  Eigen::VectorXd& grad_trace_m_times_h,
+                                  std::size_t n_threads = 1) {
     
     reset();
     
@@ -234,7 +315,7 @@ namespace nomad {
     
     try {
       
-      auto f_var = functional(x);
+      auto f_var = compact(functional(x), d);
       
       f = f_var.first_val();
       
@@ -244,45 +325,40 @@ namespace nomad {
       for (eigen_idx_t i = 0; i < d; ++i)
       g(i) = var_nodes_[i + 1].first_grad();
       
-      Eigen::VectorXd v(d);
-      grad_trace_m_times_h.setZero();
+      // The third-order sweep of each column yields one term of the
+      // gradient, summed in column order once every column is swept so that
+      // the result does not depend on the number of threads
+      Eigen::MatrixXd terms(d, d);
       
-      for (eigen_idx_t i = 0; i < d; ++i) {
+      if (n_threads > 1) {
         
-        // Second-order
-        for (eigen_idx_t j = 0; j < d; ++j)
-        var_nodes_[j + 1].second_val() = static_cast<double>(i == j);
+        typedef private_third_order_directions<F::var_type::order(), 1> directions;
         
-        second_order_forward_val(f_var);
-        second_order_reverse_adj(f_var);
+        sweep_in_parallel(n_threads, [&](std::size_t t, std::size_t n) {
+          expand_direction_numbers<directions>();
+          grad_trace_columns<directions>(f_var, M, static_cast<eigen_idx_t>(t),
+                                         static_cast<eigen_idx_t>(n), H, terms);
+        });
         
-        for (eigen_idx_t j = 0; j < d; ++j)
-        v(j) = var_nodes_[j + 1].second_grad();
+      } else {
         
-        H.col(i) = v;
+        typedef third_order_directions<F::var_type::order(), 1> directions;
         
-        // Third-order
-        for (eigen_idx_t j = 0; j < d; ++j)
-        var_nodes_[j + 1].fourth_val() = 0;
-        
-        for (eigen_idx_t j = 0; j < d; ++j)
-        var_nodes_[j + 1].third_val() = M(j, i);
-        
-        third_order_forward_val(f_var);
-        third_order_reverse_adj(f_var);
-        
-        for (eigen_idx_t j = 0; j < d; ++j)
-        v(j) = var_nodes_[j + 1].fourth_grad();
-        
-        grad_trace_m_times_h += v;
+        expand_direction_numbers<directions>();
+        grad_trace_columns<directions>(f_var, M, 0, 1, H, terms);
         
       }
       
+      grad_trace_m_times_h.setZero();
+      
+      for (eigen_idx_t i = 0; i < d; ++i)
+      grad_trace_m_times_h += terms.col(i);
+      
       reset();
       
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       reset();
-      throw e;
+      throw;
     }
     
   }
@@ -307,9 +383,9 @@ namespace nomad {
     Eigen::MatrixXd grad_hessian_auto(d, d * d);
     try {
       grad_hessian(functional, x, grad_hessian_auto);
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       std::cout << "Cannot compute Gradient of Trace Matrix Times Hessian Test" << std::endl;
-      throw e;
+      throw;
     }
     
     Eigen::VectorXd grad_trace_m_times_h = Eigen::VectorXd::Zero(d);
@@ -323,9 +399,9 @@ namespace nomad {
     Eigen::VectorXd grad_trace_m_times_h_auto(x.size());
     try {
       grad_trace_matrix_times_hessian(functional, x, M, grad_trace_m_times_h_auto);
-    } catch (nomad_error& e) {
+    } catch (nomad_error&) {
       std::cout << "Cannot compute Gradient of Trace Matrix Times Hessian Test" << std::endl;
-      throw e;
+      throw;
     }
     
     std::cout.precision(6);
@@ -0,0 +1,731 @@
+#ifndef nomad__src__codegen__emit_hpp
+#define nomad__src__codegen__emit_hpp
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <initializer_list>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <src/autodiff/exceptions.hpp>
+#include <src/autodiff/tape.hpp>
+#include <src/var/accumulator.hpp>
+#include <src/var/replay.hpp>
+#include <src/matrix/functions.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+namespace nomad {
+
+  namespace codegen {
+
+    // C++ expressions for the value and partials of the node created by one
+    // var function.  In each expression $a, $b, and $c stand for the values
+    // of the var arguments in order, $k and $l for the double arguments in
+    // order, and $r for the value of the node itself.  The second partials
+    // are packed by column, (0, 0), (0, 1), (1, 1), (0, 2), (1, 2), (2, 2),
+    // and empty expressions are zero.
+    struct rule {
+      rule() {}
+
+      rule(const std::string& value,
+           std::initializer_list<std::string> first,
+           std::initializer_list<std::string> second = {}): value(value) {
+        std::copy(first.begin(), first.begin() + std::min<std::size_t>(first.size(), 3),
+                  this->first);
+        std::copy(second.begin(), second.begin() + std::min<std::size_t>(second.size(), 6),
+                  this->second);
+      }
+
+      std::string value;
+      std::string first[3];
+      std::string second[6];
+    };
+
+    typedef std::map<void (*)(), rule> rule_table;
+
+    template <class... Args>
+    inline void define(rule_table& table,
+                       typename replay_signature<Args...>::type function,
+                       const rule& r) {
+      table[reinterpret_cast<void (*)()>(function)] = r;
+    }
+
+    template <class T_var, bool StrictSmoothness = T_var::strict()>
+    struct nonsmooth_rules {
+      static void define_all(rule_table&) {}
+    };
+
+    // Piecewise functions whose pieces are chosen by the generated code
+    // itself, instead of being fixed when the tape was recorded
+    template <class T_var>
+    struct nonsmooth_rules<T_var, false> {
+      static void define_all(rule_table& table) {
+        typedef const T_var& V;
+
+        define<V>(table, &fabs, { "std::fabs($a)", { "($a < 0 ? -1.0 : 1.0)" } });
+        define<V>(table, &cbrt, { "std::cbrt($a)", { "$r / (3 * $a)" },
+                                  { "-2 * $r / (9 * $a * $a)" } });
+
+        define<V, V>(table, &fdim, { "std::fdim($a, $b)",
+                                     { "($a > $b ? 1.0 : 0.0)", "($a > $b ? -1.0 : 0.0)" } });
+        define<double, V>(table, &fdim, { "std::fdim($k, $a)", { "($k > $a ? -1.0 : 0.0)" } });
+        define<V, double>(table, &fdim, { "std::fdim($a, $k)", { "($a > $k ? 1.0 : 0.0)" } });
+
+        define<V, V>(table, &fmod, { "std::fmod($a, $b)", { "1", "-std::trunc($a / $b)" } });
+        define<double, V>(table, &fmod, { "std::fmod($k, $a)", { "-std::trunc($k / $a)" } });
+        define<V, double>(table, &fmod, { "std::fmod($a, $k)", { "1" } });
+      }
+    };
+
+    template <class T_var>
+    rule_table make_rules() {
+
+      typedef const T_var& V;
+      typedef T_var& M;
+
+      rule_table table;
+
+      // Operators
+      define<V>(table, &operator+, { "$a", { "1" } });
+      define<V>(table, &operator-, { "-$a", { "-1" } });
+      define<M>(table, &operator++, { "$a + 1", { "1" } });
+      define<M>(table, &operator--, { "$a - 1", { "1" } });
+      define<V, int>(table, &operator++, { "$a + 1", { "1" } });
+      define<V, int>(table, &operator--, { "$a - 1", { "1" } });
+
+      define<V, V>(table, &operator+, { "$a + $b", { "1", "1" } });
+      define<double, V>(table, &operator+, { "$k + $a", { "1" } });
+      define<V, double>(table, &operator+, { "$a + $k", { "1" } });
+      define<M, V>(table, &operator+=, { "$a + $b", { "1", "1" } });
+      define<M, double>(table, &operator+=, { "$a + $k", { "1" } });
+
+      define<V, V>(table, &operator-, { "$a - $b", { "1", "-1" } });
+      define<double, V>(table, &operator-, { "$k - $a", { "-1" } });
+      define<V, double>(table, &operator-, { "$a - $k", { "1" } });
+      define<M, V>(table, &operator-=, { "$a - $b", { "1", "-1" } });
+      define<M, double>(table, &operator-=, { "$a - $k", { "1" } });
+
+      const rule product = { "$a * $b", { "$b", "$a" }, { "", "1", "" } };
+      define<V, V>(table, &operator*, product);
+      define<double, V>(table, &operator*, { "$k * $a", { "$k" } });
+      define<V, double>(table, &operator*, { "$a * $k", { "$k" } });
+      define<M, V>(table, &operator*=, product);
+      define<M, double>(table, &operator*=, { "$a * $k", { "$k" } });
+
+      const rule quotient = { "$a / $b", { "1 / $b", "-$r / $b" },
+                              { "", "-1 / ($b * $b)", "2 * $r / ($b * $b)" } };
+      define<V, V>(table, &operator/, quotient);
+      define<double, V>(table, &operator/, { "$k / $a", { "-$r / $a" },
+                                             { "2 * $r / ($a * $a)" } });
+      define<V, double>(table, &operator/, { "$a / $k", { "1 / $k" } });
+      define<M, V>(table, &operator/=, quotient);
+      define<M, double>(table, &operator/=, { "$a / $k", { "1 / $k" } });
+
+      // Unary functions
+      define<V>(table, &exp, { "std::exp($a)", { "$r" }, { "$r" } });
+      define<V>(table, &exp2, { "std::exp2($a)", { "0.69314718055994531 * $r" },
+                                { "0.48045301391820143 * $r" } });
+      define<V>(table, &expm1, { "std::expm1($a)", { "$r + 1" }, { "$r + 1" } });
+      define<V>(table, &log, { "std::log($a)", { "1 / $a" }, { "-1 / ($a * $a)" } });
+      define<V>(table, &log2, { "std::log2($a)", { "1.4426950408889634 / $a" },
+                                { "-1.4426950408889634 / ($a * $a)" } });
+      define<V>(table, &log10, { "std::log10($a)", { "0.43429448190325182 / $a" },
+                                 { "-0.43429448190325182 / ($a * $a)" } });
+      define<V>(table, &log1p, { "std::log1p($a)", { "1 / (1 + $a)" },
+                                 { "-1 / ((1 + $a) * (1 + $a))" } });
+      define<V>(table, &log1p_exp, { "($a > 0 ? $a + std::log1p(std::exp(-$a)) : std::log1p(std::exp($a)))",
+                                     { "1 / (1 + std::exp(-$a))" },
+                                     { "1 / ((1 + std::exp(-$a)) * (1 + std::exp($a)))" } });
+      define<V>(table, &inv_logit, { "($a > 0 ? 1 / (1 + std::exp(-$a)) : std::exp($a) / (1 + std::exp($a)))",
+                                     { "$r * (1 - $r)" },
+                                     { "$r * (1 - $r) * (1 - 2 * $r)" } });
+      define<V>(table, &inv_cloglog, { "1 - std::exp(-std::exp($a))",
+                                       { "std::exp($a - std::exp($a))" },
+                                       { "std::exp($a - std::exp($a)) * (1 - std::exp($a))" } });
+
+      define<V>(table, &sqrt, { "std::sqrt($a)", { "0.5 / $r" }, { "-0.25 / ($r * $a)" } });
+      define<V>(table, &inv_sqrt, { "1 / std::sqrt($a)", { "-0.5 * $r / $a" },
+                                    { "0.75 * $r / ($a * $a)" } });
+      define<V>(table, &inv, { "1 / $a", { "-$r * $r" }, { "2 * $r * $r * $r" } });
+      define<V>(table, &inv_square, { "1 / ($a * $a)", { "-2 * $r / $a" },
+                                      { "6 * $r / ($a * $a)" } });
+      define<V>(table, &square, { "$a * $a", { "2 * $a" }, { "2" } });
+
+      define<V>(table, &sin, { "std::sin($a)", { "std::cos($a)" }, { "-$r" } });
+      define<V>(table, &cos, { "std::cos($a)", { "-std::sin($a)" }, { "-$r" } });
+      define<V>(table, &tan, { "std::tan($a)", { "1 + $r * $r" },
+                               { "2 * $r * (1 + $r * $r)" } });
+      define<V>(table, &asin, { "std::asin($a)", { "1 / std::sqrt(1 - $a * $a)" },
+                                { "$a / ((1 - $a * $a) * std::sqrt(1 - $a * $a))" } });
+      define<V>(table, &acos, { "std::acos($a)", { "-1 / std::sqrt(1 - $a * $a)" },
+                                { "-$a / ((1 - $a * $a) * std::sqrt(1 - $a * $a))" } });
+      define<V>(table, &atan, { "std::atan($a)", { "1 / (1 + $a * $a)" },
+                                { "-2 * $a / ((1 + $a * $a) * (1 + $a * $a))" } });
+
+      define<V>(table, &sinh, { "std::sinh($a)", { "std::cosh($a)" }, { "$r" } });
+      define<V>(table, &cosh, { "std::cosh($a)", { "std::sinh($a)" }, { "$r" } });
+      define<V>(table, &tanh, { "std::tanh($a)", { "1 - $r * $r" },
+                                { "-2 * $r * (1 - $r * $r)" } });
+      define<V>(table, &asinh, { "std::asinh($a)", { "1 / std::sqrt($a * $a + 1)" },
+                                 { "-$a / (($a * $a + 1) * std::sqrt($a * $a + 1))" } });
+      define<V>(table, &acosh, { "std::acosh($a)", { "1 / std::sqrt($a * $a - 1)" },
+                                 { "-$a / (($a * $a - 1) * std::sqrt($a * $a - 1))" } });
+      define<V>(table, &atanh, { "std::atanh($a)", { "1 / (1 - $a * $a)" },
+                                 { "2 * $a / ((1 - $a * $a) * (1 - $a * $a))" } });
+
+      define<V>(table, &erf, { "std::erf($a)", { "1.1283791670955126 * std::exp(-$a * $a)" },
+                               { "-2.2567583341910252 * $a * std::exp(-$a * $a)" } });
+      define<V>(table, &erfc, { "std::erfc($a)", { "-1.1283791670955126 * std::exp(-$a * $a)" },
+                                { "2.2567583341910252 * $a * std::exp(-$a * $a)" } });
+      define<V>(table, &Phi, { "($a < -40 ? 0.0 : $a < 0 ? 0.5 * std::erfc(-0.70710678118654752 * $a)"
+                               " : $a < 40 ? 0.5 * (1 + std::erf(0.70710678118654752 * $a)) : 1.0)",
+                               { "0.3989422804014327 * std::exp(-0.5 * $a * $a)" },
+                               { "-0.3989422804014327 * $a * std::exp(-0.5 * $a * $a)" } });
+
+      // Binary functions
+      define<V, V>(table, &pow, { "std::pow($a, $b)", { "$b * $r / $a", "std::log($a) * $r" },
+                                  { "$b * ($b - 1) * $r / ($a * $a)",
+                                    "(1 + $b * std::log($a)) * $r / $a",
+                                    "std::log($a) * std::log($a) * $r" } });
+      define<double, V>(table, &pow, { "std::pow($k, $a)", { "std::log($k) * $r" },
+                                       { "std::log($k) * std::log($k) * $r" } });
+      define<V, double>(table, &pow, { "std::pow($a, $k)", { "$k * $r / $a" },
+                                       { "$k * ($k - 1) * $r / ($a * $a)" } });
+
+      define<V, V>(table, &atan2, { "std::atan2($a, $b)",
+                                    { "$b / ($a * $a + $b * $b)", "-$a / ($a * $a + $b * $b)" },
+                                    { "-2 * $a * $b / (($a * $a + $b * $b) * ($a * $a + $b * $b))",
+                                      "($a * $a - $b * $b) / (($a * $a + $b * $b) * ($a * $a + $b * $b))",
+                                      "2 * $a * $b / (($a * $a + $b * $b) * ($a * $a + $b * $b))" } });
+      define<double, V>(table, &atan2, { "std::atan2($k, $a)", { "-$k / ($k * $k + $a * $a)" },
+                                         { "2 * $k * $a / (($k * $k + $a * $a) * ($k * $k + $a * $a))" } });
+      define<V, double>(table, &atan2, { "std::atan2($a, $k)", { "$k / ($a * $a + $k * $k)" },
+                                         { "-2 * $k * $a / (($a * $a + $k * $k) * ($a * $a + $k * $k))" } });
+
+      define<V, V>(table, &hypot, { "std::hypot($a, $b)", { "$a / $r", "$b / $r" },
+                                    { "$b * $b / ($r * $r * $r)", "-$a * $b / ($r * $r * $r)",
+                                      "$a * $a / ($r * $r * $r)" } });
+      define<double, V>(table, &hypot, { "std::hypot($k, $a)", { "$a / $r" },
+                                         { "$k * $k / ($r * $r * $r)" } });
+      define<V, double>(table, &hypot, { "std::hypot($a, $k)", { "$a / $r" },
+                                         { "$k * $k / ($r * $r * $r)" } });
+
+      define<V, V>(table, &log_sum_exp, { "($a > $b ? $a + std::log(std::exp($b - $a) + 1)"
+                                          " : $b + std::log(std::exp($a - $b) + 1))",
+                                          { "std::exp($a - $r)", "std::exp($b - $r)" },
+                                          { "std::exp($a + $b - 2 * $r)", "-std::exp($a + $b - 2 * $r)",
+                                            "std::exp($a + $b - 2 * $r)" } });
+      define<double, V>(table, &log_sum_exp, { "($k > $a ? $k + std::log(std::exp($a - $k) + 1)"
+                                               " : $a + std::log(std::exp($k - $a) + 1))",
+                                               { "std::exp($a - $r)" },
+                                               { "std::exp($k + $a - 2 * $r)" } });
+      define<V, double>(table, &log_sum_exp, { "($a > $k ? $a + std::log(std::exp($k - $a) + 1)"
+                                               " : $k + std::log(std::exp($a - $k) + 1))",
+                                               { "std::exp($a - $r)" },
+                                               { "std::exp($a + $k - 2 * $r)" } });
+
+      define<V, V>(table, &log_diff_exp, { "$a + std::log(-std::expm1($b - $a))",
+                                           { "std::exp($a - $r)", "-std::exp($b - $r)" },
+                                           { "-std::exp($a + $b - 2 * $r)", "std::exp($a + $b - 2 * $r)",
+                                             "-std::exp($a + $b - 2 * $r)" } });
+      define<double, V>(table, &log_diff_exp, { "$k + std::log(-std::expm1($a - $k))",
+                                                { "-std::exp($a - $r)" },
+                                                { "-std::exp($k + $a - 2 * $r)" } });
+      define<V, double>(table, &log_diff_exp, { "$a + std::log(-std::expm1($k - $a))",
+                                                { "std::exp($a - $r)" },
+                                                { "-std::exp($a + $k - 2 * $r)" } });
+
+      define<V, V>(table, &multiply_log, { "($a == 0 && $b == 0 ? 0.0 : $a * std::log($b))",
+                                           { "std::log($b)", "$a / $b" },
+                                           { "", "1 / $b", "-$a / ($b * $b)" } });
+      define<double, V>(table, &multiply_log, { "($k == 0 && $a == 0 ? 0.0 : $k * std::log($a))",
+                                                { "$k / $a" }, { "-$k / ($a * $a)" } });
+      define<V, double>(table, &multiply_log, { "($a == 0 && $k == 0 ? 0.0 : $a * std::log($k))",
+                                                { "std::log($k)" } });
+
+      define<V, V>(table, &binary_prod_cubes, { "$a * $a * $a * $b * $b * $b",
+                                                { "3 * $a * $a * $b * $b * $b",
+                                                  "3 * $a * $a * $a * $b * $b" },
+                                                { "6 * $a * $b * $b * $b",
+                                                  "9 * $a * $a * $b * $b",
+                                                  "6 * $a * $a * $a * $b" } });
+
+      // Ternary functions
+      define<V, V, V>(table, &fma, { "$a * $b + $c", { "$b", "$a", "1" },
+                                     { "", "1", "", "", "", "" } });
+      define<V, V, V>(table, &trinary_prod_cubes, { "$a * $a * $a * $b * $b * $b * $c * $c * $c",
+                                                    { "3 * $a * $a * $b * $b * $b * $c * $c * $c",
+                                                      "3 * $a * $a * $a * $b * $b * $c * $c * $c",
+                                                      "3 * $a * $a * $a * $b * $b * $b * $c * $c" },
+                                                    { "6 * $a * $b * $b * $b * $c * $c * $c",
+                                                      "9 * $a * $a * $b * $b * $c * $c * $c",
+                                                      "6 * $a * $a * $a * $b * $c * $c * $c",
+                                                      "9 * $a * $a * $b * $b * $b * $c * $c",
+                                                      "9 * $a * $a * $a * $b * $b * $c * $c",
+                                                      "6 * $a * $a * $a * $b * $b * $b * $c" } });
+
+      nonsmooth_rules<T_var>::define_all(table);
+
+      return table;
+
+    }
+
+    template <class T_var>
+    const rule_table& rules() {
+      static const rule_table table = make_rules<T_var>();
+      return table;
+    }
+
+    // A double literal that reads back exactly
+    inline std::string literal(double x) {
+      if (std::isnan(x)) return "std::numeric_limits<double>::quiet_NaN()";
+      if (std::isinf(x))
+        return x > 0 ? "std::numeric_limits<double>::infinity()"
+                     : "(-std::numeric_limits<double>::infinity())";
+
+      char buffer[32];
+      std::snprintf(buffer, sizeof(buffer), "%.17g", x);
+      std::string s(buffer);
+      if (s.find_first_of(".e") == std::string::npos) s += ".0";
+      return x < 0 ? "(" + s + ")" : s;
+    }
+
+    // Straight-line source for one recorded graph, with a local for the
+    // value of every node that feeds the output
+    template <class T_var>
+    class emitter {
+    public:
+
+      emitter(tape<T_var>& t, const std::string& name, bool hvp, const std::string& guard):
+      name_(name), guard_(guard.empty() ? name + "_hpp" : guard), hvp_(hvp) {
+
+        if (!t.replayable())
+          throw nomad_error("Nomad codegen can only emit tapes whose every node can be replayed");
+
+        if (!t.guards().empty())
+          throw nomad_error("Nomad codegen cannot emit a tape that branches on the values of its inputs");
+
+        autodiff_context::scope bound(t.context());
+
+        n_inputs_ = t.n_inputs();
+        output_ = t.output().node();
+        nodes_.resize(output_ + 1);
+
+        const rule_table& table = rules<T_var>();
+        typename std::vector<replay_entry>::const_iterator entry = t.log().begin();
+
+        for (nomad_idx_t n = 1; n <= output_; ++n) {
+          node& v = nodes_[n];
+          var_node_base& recorded = var_nodes_[n];
+
+          if (!recorded.n_inputs()) {
+            v.kind = n <= n_inputs_ ? input_kind : constant_kind;
+            v.constants[0] = recorded.first_val();
+            continue;
+          }
+
+          for (nomad_idx_t k = 0; k < recorded.n_inputs(); ++k)
+            v.inputs.push_back(input_node<T_var::order()>(n, k));
+
+          if (entry->replay == &replay_sum<T_var::order(), T_var::validate()>) {
+            v.kind = sum_kind;
+          } else if (entry->replay == &replay_dot<T_var::order(), T_var::validate()>) {
+            v.kind = dot_kind;
+          } else if (entry->replay == &replay_linear_combination<T_var::order(), T_var::validate()>) {
+            v.kind = combination_kind;
+            for (nomad_idx_t k = 0; k < recorded.n_inputs(); ++k)
+              v.weights.push_back(recorded.first_partials(k));
+          } else {
+            rule_table::const_iterator r = table.find(entry->function);
+            if (r == table.end())
+              throw nomad_error("Nomad codegen has no rule for node "
+                                + std::to_string(n) + " of the tape");
+            v.kind = rule_kind;
+            v.r = &r->second;
+            v.constants[0] = entry->constants[0];
+            v.constants[1] = entry->constants[1];
+          }
+
+          ++entry;
+        }
+
+        // Only the nodes that feed the output are emitted
+        nodes_[output_].live = true;
+        for (nomad_idx_t n = output_; n > 0; --n)
+          if (nodes_[n].live)
+            for (std::size_t k = 0; k < nodes_[n].inputs.size(); ++k)
+              nodes_[nodes_[n].inputs[k]].live = true;
+
+      }
+
+      void write(std::ostream& out) {
+        out << "#ifndef " << guard_ << "\n#define " << guard_ << "\n\n"
+            << "// Generated by nomad::codegen::emit from a recorded tape\n\n"
+            << "#include <cmath>\n#include <limits>\n\n";
+
+        write_gradient(out);
+
+        if (hvp_) {
+          out << "\n";
+          write_hvp(out);
+        }
+
+        out << "\n#endif\n";
+      }
+
+    private:
+
+      enum node_kind { input_kind, constant_kind, rule_kind, sum_kind, dot_kind, combination_kind };
+
+      struct node {
+        node(): kind(constant_kind), r(0), live(false) { constants[0] = constants[1] = 0; }
+        node_kind kind;
+        const rule* r;
+        std::vector<nomad_idx_t> inputs;
+        std::vector<double> weights;
+        double constants[2];
+        bool live;
+      };
+
+      static std::string local(char prefix, nomad_idx_t n) {
+        return prefix + std::to_string(n);
+      }
+
+      static std::string partial(nomad_idx_t n, std::size_t k) {
+        return "d" + std::to_string(n) + "_" + std::to_string(k);
+      }
+
+      static std::string second_partial(nomad_idx_t n, std::size_t k) {
+        return "h" + std::to_string(n) + "_" + std::to_string(k);
+      }
+
+      // Expands the placeholders of a rule expression for node n
+      std::string expand(const std::string& expression, nomad_idx_t n) const {
+        const node& v = nodes_[n];
+        std::string out;
+        for (std::size_t i = 0; i < expression.size(); ++i) {
+          if (expression[i] != '$' || i + 1 == expression.size()) {
+            out += expression[i];
+            continue;
+          }
+          const char p = expression[++i];
+          if (p >= 'a' && p <= 'c') out += local('v', v.inputs[p - 'a']);
+          else if (p == 'k' || p == 'l') out += literal(v.constants[p - 'k']);
+          else if (p == 'r') out += local('v', n);
+          else throw nomad_error("Nomad codegen found an unknown placeholder in a rule");
+        }
+        return out;
+      }
+
+      std::string value(nomad_idx_t n) const {
+        const node& v = nodes_[n];
+        std::string s;
+        switch (v.kind) {
+          case input_kind:
+            return "x[" + std::to_string(n - 1) + "]";
+          case constant_kind:
+            return literal(v.constants[0]);
+          case rule_kind:
+            return expand(v.r->value, n);
+          case sum_kind:
+            for (std::size_t k = 0; k < v.inputs.size(); ++k)
+              s += (k ? " + " : "") + local('v', v.inputs[k]);
+            return s;
+          case dot_kind:
+            for (std::size_t k = 0; k < v.inputs.size() / 2; ++k)
+              s += (k ? " + " : "") + local('v', v.inputs[k])
+                   + " * " + local('v', v.inputs[k + v.inputs.size() / 2]);
+            return s;
+          case combination_kind:
+            for (std::size_t k = 0; k < v.inputs.size(); ++k)
+              s += (k ? " + " : "") + literal(v.weights[k]) + " * " + local('v', v.inputs[k]);
+            return s;
+        }
+        return s;
+      }
+
+      // Partial of node n with respect to its input k, as a local when the
+      // rule does not make it a constant
+      std::string first(nomad_idx_t n, std::size_t k) const {
+        const node& v = nodes_[n];
+        if (v.kind == sum_kind) return "1";
+        if (v.kind == combination_kind) {
+          if (v.weights[k] == 1) return "1";
+          if (v.weights[k] == -1) return "-1";
+          return literal(v.weights[k]);
+        }
+        if (v.kind == dot_kind) {
+          const std::size_t end = v.inputs.size() / 2;
+          return local('v', v.inputs[k < end ? k + end : k - end]);
+        }
+        const std::string& p = v.r->first[k];
+        if (p.empty() || p == "1" || p == "-1") return p;
+        return partial(n, k);
+      }
+
+      void write_partials(std::ostream& out, nomad_idx_t n) const {
+        const node& v = nodes_[n];
+        if (v.kind != rule_kind) return;
+        for (std::size_t k = 0; k < v.inputs.size(); ++k)
+          if (first(n, k) == partial(n, k))
+            out << "  const double " << partial(n, k) << " = "
+                << expand(v.r->first[k], n) << ";\n";
+      }
+
+      static std::string scale(const std::string& adjoint, const std::string& p) {
+        if (p == "1") return adjoint;
+        if (p == "-1") return "-" + adjoint;
+        return adjoint + " * " + p;
+      }
+
+      // Adds a term to an adjoint local, declaring it on the first term
+      static void accumulate(std::ostream& out, std::vector<bool>& declared,
+                             char prefix, nomad_idx_t m, const std::string& term) {
+        if (declared[m]) {
+          out << "  " << local(prefix, m) << " += " << term << ";\n";
+        } else {
+          out << "  double " << local(prefix, m) << " = " << term << ";\n";
+          declared[m] = true;
+        }
+      }
+
+      void write_values(std::ostream& out) const {
+        for (nomad_idx_t n = 1; n <= output_; ++n)
+          if (nodes_[n].live)
+            out << "  const double " << local('v', n) << " = " << value(n) << ";\n";
+      }
+
+      void write_outputs(std::ostream& out, const std::vector<bool>& declared,
+                         char prefix, const char* target) const {
+        for (nomad_idx_t n = 1; n <= n_inputs_; ++n)
+          out << "  " << target << "[" << n - 1 << "] = "
+              << (n <= output_ && declared[n] ? local(prefix, n) : "0") << ";\n";
+      }
+
+      void write_gradient(std::ostream& out) const {
+        out << "inline double " << name_ << "(const double* x, double* g) {\n";
+
+        write_values(out);
+
+        std::vector<bool> declared(output_ + 1, false);
+        out << "  double " << local('a', output_) << " = 1;\n";
+        declared[output_] = true;
+
+        for (nomad_idx_t n = output_; n > 0; --n) {
+          const node& v = nodes_[n];
+          if (!v.live || v.inputs.empty()) continue;
+          write_partials(out, n);
+          for (std::size_t k = 0; k < v.inputs.size(); ++k) {
+            const std::string p = first(n, k);
+            if (!p.empty() && nodes_[v.inputs[k]].kind != constant_kind)
+              accumulate(out, declared, 'a', v.inputs[k], scale(local('a', n), p));
+          }
+        }
+
+        write_outputs(out, declared, 'a', "g");
+        out << "  return " << local('v', output_) << ";\n}\n";
+      }
+
+      // Whether the second partial of node n with respect to its inputs j
+      // and k is nonzero
+      bool curved(nomad_idx_t n, std::size_t j, std::size_t k) const {
+        const node& u = nodes_[n];
+        if (u.kind == dot_kind) {
+          const std::size_t end = u.inputs.size() / 2;
+          return j == (k < end ? k + end : k - end);
+        }
+        if (u.kind != rule_kind) return false;
+        const std::size_t hi = j < k ? k : j;
+        const std::size_t lo = j < k ? j : k;
+        return !u.r->second[hi * (hi + 1) / 2 + lo].empty();
+      }
+
+      // The nodes whose tangent is both nonzero and read, either by the
+      // tangent of a node that is itself read or by a second partial
+      std::vector<bool> tangents() const {
+        std::vector<bool> nonzero(output_ + 1, false);
+        for (nomad_idx_t n = 1; n <= output_; ++n) {
+          const node& u = nodes_[n];
+          if (!u.live) continue;
+          nonzero[n] = u.kind == input_kind;
+          for (std::size_t k = 0; k < u.inputs.size(); ++k)
+            if (nonzero[u.inputs[k]] && !first(n, k).empty()) nonzero[n] = true;
+        }
+
+        std::vector<bool> read(output_ + 1, false);
+        for (nomad_idx_t n = output_; n > 0; --n) {
+          const node& u = nodes_[n];
+          if (!u.live) continue;
+          for (std::size_t k = 0; k < u.inputs.size(); ++k) {
+            const nomad_idx_t m = u.inputs[k];
+            if (read[n] && !first(n, k).empty()) read[m] = true;
+            for (std::size_t j = 0; j < u.inputs.size(); ++j)
+              if (nodes_[u.inputs[j]].kind != constant_kind && curved(n, j, k)) read[m] = true;
+          }
+        }
+
+        for (nomad_idx_t n = 1; n <= output_; ++n)
+          nonzero[n] = nonzero[n] && read[n];
+        return nonzero;
+      }
+
+      // Forward-over-reverse Hessian-vector product, carrying the tangent
+      // of every value along v forward and the adjoint of that tangent back
+      void write_hvp(std::ostream& out) const {
+        out << "inline double " << name_
+            << "_hvp(const double* x, const double* v, double* g, double* hv) {\n";
+
+        const std::vector<bool> tangent = tangents();
+
+        for (nomad_idx_t n = 1; n <= output_; ++n) {
+          const node& u = nodes_[n];
+          if (!u.live) continue;
+
+          out << "  const double " << local('v', n) << " = " << value(n) << ";\n";
+          write_partials(out, n);
+
+          if (!tangent[n]) continue;
+
+          std::string t;
+          if (u.kind == input_kind) t = "v[" + std::to_string(n - 1) + "]";
+          for (std::size_t k = 0; k < u.inputs.size(); ++k) {
+            const std::string p = first(n, k);
+            if (p.empty() || !tangent[u.inputs[k]]) continue;
+            const std::string term = scale(local('t', u.inputs[k]), p);
+            t += t.empty() ? term : (term[0] == '-' ? " - " + term.substr(1) : " + " + term);
+          }
+
+          out << "  const double " << local('t', n) << " = " << t << ";\n";
+        }
+
+        std::vector<bool> declared(output_ + 1, false);
+        std::vector<bool> declared_tangent(output_ + 1, false);
+        out << "  double " << local('a', output_) << " = 1;\n";
+        declared[output_] = true;
+
+        for (nomad_idx_t n = output_; n > 0; --n) {
+          const node& u = nodes_[n];
+          if (!u.live || u.inputs.empty()) continue;
+
+          const std::size_t n_inputs = u.inputs.size();
+
+          // Second partials of the node contracted with the input tangents
+          std::vector<std::string> curvature(n_inputs);
+
+          if (u.kind == dot_kind) {
+            const std::size_t end = n_inputs / 2;
+            for (std::size_t k = 0; k < n_inputs; ++k) {
+              const nomad_idx_t partner = u.inputs[k < end ? k + end : k - end];
+              if (tangent[partner]) curvature[k] = local('t', partner);
+            }
+          } else if (u.kind == rule_kind) {
+            for (std::size_t j = 0; j < n_inputs; ++j) {
+              for (std::size_t k = 0; k <= j; ++k) {
+                const std::size_t packed = j * (j + 1) / 2 + k;
+                const std::string& h = u.r->second[packed];
+                if (h.empty()) continue;
+                const bool simple = h == "1" || h == "-1";
+                const bool to_k = tangent[u.inputs[j]] && nodes_[u.inputs[k]].kind != constant_kind;
+                const bool to_j = j != k && tangent[u.inputs[k]]
+                                  && nodes_[u.inputs[j]].kind != constant_kind;
+                if (!simple && (to_k || to_j))
+                  out << "  const double " << second_partial(n, packed) << " = "
+                      << expand(h, n) << ";\n";
+                const std::string c = simple ? h : second_partial(n, packed);
+                if (to_k) {
+                  const std::string term = scale(local('t', u.inputs[j]), c);
+                  curvature[k] += (curvature[k].empty() ? "" : " + ") + term;
+                }
+                if (to_j) {
+                  const std::string term = scale(local('t', u.inputs[k]), c);
+                  curvature[j] += (curvature[j].empty() ? "" : " + ") + term;
+                }
+              }
+            }
+          }
+
+          for (std::size_t k = 0; k < n_inputs; ++k) {
+            const nomad_idx_t m = u.inputs[k];
+            const std::string p = first(n, k);
+            if (nodes_[m].kind == constant_kind) continue;
+
+            if (!p.empty())
+              accumulate(out, declared, 'a', m, scale(local('a', n), p));
+
+            std::string b;
+            if (!p.empty() && declared_tangent[n])
+              b = scale(local('b', n), p);
+            if (!curvature[k].empty())
+              b += (b.empty() ? "" : " + ") + local('a', n) + " * (" + curvature[k] + ")";
+            if (!b.empty())
+              accumulate(out, declared_tangent, 'b', m, b);
+          }
+        }
+
+        write_outputs(out, declared, 'a', "g");
+        write_outputs(out, declared_tangent, 'b', "hv");
+        out << "  return " << local('v', output_) << ";\n}\n";
+      }
+
+      std::string name_;
+      std::string guard_;
+      bool hvp_;
+      nomad_idx_t n_inputs_;
+      nomad_idx_t output_;
+      std::vector<node> nodes_;
+
+    };
+
+    // Function name for a generated header, the file name without its
+    // directory or extension
+    inline std::string function_name(const std::string& path) {
+      std::string name = path.substr(path.find_last_of("/\\") + 1);
+      name = name.substr(0, name.find('.'));
+      for (std::size_t i = 0; i < name.size(); ++i)
+        if (!std::isalnum(static_cast<unsigned char>(name[i]))) name[i] = '_';
+      if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) name = "_" + name;
+      return name;
+    }
+
+    // Writes a header defining
+    //
+    //   double name(const double* x, double* g)
+    //
+    // which returns the value of the recorded graph at x and stores its
+    // gradient in g, along with, when hvp is set,
+    //
+    //   double name_hvp(const double* x, const double* v, double* g, double* hv)
+    //
+    // which also stores the product of the Hessian with v in hv.  The
+    // generated code depends only on <cmath>, and holds for the graph the
+    // tape recorded, so tapes that branch on their inputs are rejected.  The
+    // header guard defaults to name_hpp.
+    template <class T_var>
+    void emit(tape<T_var>& t, std::ostream& out, const std::string& name, bool hvp = false,
+              const std::string& guard = "") {
+      emitter<T_var>(t, name, hvp, guard).write(out);
+    }
+
+    template <class T_var>
+    void emit(tape<T_var>& t, const std::string& path, bool hvp = false) {
+      std::ostringstream source;
+      emit(t, source, function_name(path), hvp);
+
+      std::ofstream file(path.c_str());
+      file << source.str();
+      if (!file)
+        throw nomad_error("Nomad codegen could not write " + path);
+    }
+
+  }
+
+}
+
+#endif
@@ -4,10 +4,27 @@
 #include <Eigen/Core>
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/dot_var_node.hpp>
 
 namespace nomad {
   
+  template<short AutodiffOrder, bool ValidateIO>
+  void replay_dot(const replay_entry& entry) {
+    var_node_base& node = var_nodes_[entry.node];
+    
+    double sum = 0;
+    
+    nomad_idx_t end = node.n_inputs() / 2;
+    for (nomad_idx_t n = 0; n < end; ++n)
+      sum +=   var_node_base::first_val(node.input(n))
+             * var_node_base::first_val(node.input(n + end));
+    
+    rewind_stacks(entry.node);
+    push_dual_numbers<AutodiffOrder, ValidateIO>(sum);
+  }
+  
   template<typename DerivedA, typename DerivedB>
   inline typename
   std::enable_if<
@@ -27,13 +44,14 @@ namespace nomad {
     const nomad_idx_t n_inputs = static_cast<nomad_idx_t>(2 * N);
     
     create_node<dot_var_node<autodiff_order>>(n_inputs);
+    record_custom_replay(&replay_dot<autodiff_order, validate_io>);
     
     double sum = 0;
     
     for (eigen_idx_t n = 0; n < N; ++n)
       sum += v1(n).first_val() * v2(n).first_val();
 
-    push_dual_numbers<autodiff_order>(sum);
+    push_dual_numbers<autodiff_order, validate_io>(sum);
     
     for (eigen_idx_t n = 0; n < N; ++n)
       push_inputs(v1(n).dual_numbers());
@@ -41,7 +59,7 @@ namespace nomad {
     for (eigen_idx_t n = 0; n < N; ++n)
       push_inputs(v2(n).dual_numbers());
     
-    return var<autodiff_order, strict_smoothness, validate_io>(next_node_idx_ - 1);
+    return var<autodiff_order, strict_smoothness, validate_io>(commit_node<autodiff_order>());
     
   }
   
@@ -4,10 +4,25 @@
 #include <Eigen/Core>
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/multi_sum_var_node.hpp>
 
 namespace nomad {
   
+  template<short AutodiffOrder, bool ValidateIO>
+  void replay_sum(const replay_entry& entry) {
+    var_node_base& node = var_nodes_[entry.node];
+    
+    double sum = 0;
+    
+    for (nomad_idx_t n = 0; n < node.n_inputs(); ++n)
+      sum += var_node_base::first_val(node.input(n));
+    
+    rewind_stacks(entry.node);
+    push_dual_numbers<AutodiffOrder, ValidateIO>(sum);
+  }
+  
   template<typename Derived>
   inline typename std::enable_if<
     is_var<typename Eigen::MatrixBase<Derived>::Scalar>::value,
@@ -21,17 +36,18 @@ namespace nomad {
     const nomad_idx_t n_inputs = static_cast<nomad_idx_t>(input.size());
     
     create_node<multi_sum_var_node<autodiff_order>>(n_inputs);
+    record_custom_replay(&replay_sum<autodiff_order, validate_io>);
     
     double sum = 0;
     
     for (eigen_idx_t n = 0; n < n_inputs; ++n)
       sum += input(n).first_val();
-    push_dual_numbers<autodiff_order>(sum);
+    push_dual_numbers<autodiff_order, validate_io>(sum);
     
     for (eigen_idx_t n = 0; n < n_inputs; ++n)
       push_inputs(input(n).dual_numbers());
     
-    return var<autodiff_order, strict_smoothness, validate_io>(next_node_idx_ - 1);
+    return var<autodiff_order, strict_smoothness, validate_io>(commit_node<autodiff_order>());
     
   }
 
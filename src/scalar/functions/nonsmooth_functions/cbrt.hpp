@@ -3,6 +3,8 @@
 
 #include <math.h>
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_var_node.hpp>
 #include <src/autodiff/validation.hpp>
 
@@ -22,6 +24,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(input)>(&cbrt);
 
     double val = std::cbrt(input.first_val());
     
@@ -43,7 +46,7 @@ namespace nomad {
       throw nomad_output_partial_error("cbrt");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -5,6 +5,8 @@
 #include <type_traits>
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_var_node.hpp>
 #include <src/var/derived/binary_var_node.hpp>
 #include <src/autodiff/validation.hpp>
@@ -27,6 +29,7 @@ namespace nomad {
     const unsigned int n_inputs = 2;
     
     create_node<binary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2)>(&fdim);
     
     double x = v1.first_val();
     double y = v2.first_val();
@@ -55,7 +58,7 @@ namespace nomad {
       throw nomad_output_partial_error("fdim");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -73,6 +76,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(x), decltype(v2)>(&fdim, x);
     
     double y = v2.first_val();
     
@@ -93,7 +97,7 @@ namespace nomad {
       throw nomad_output_partial_error("fdim");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -111,6 +115,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(y)>(&fdim, y);
     
     double x = v1.first_val();
     
@@ -131,7 +136,7 @@ namespace nomad {
       throw nomad_output_partial_error("fdim");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -5,6 +5,8 @@
 #include <type_traits>
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_var_node.hpp>
 #include <src/autodiff/validation.hpp>
 
@@ -22,6 +24,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(input)>(&floor);
 
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(ceil(input.first_val()));
@@ -31,7 +34,7 @@ namespace nomad {
       
     push_inputs(input.dual_numbers());
 
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
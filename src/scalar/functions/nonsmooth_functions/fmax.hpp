@@ -4,6 +4,7 @@
 #include <math.h>
 #include <type_traits>
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
 #include <src/autodiff/validation.hpp>
 
 namespace nomad {
@@ -18,7 +19,7 @@ namespace nomad {
       validate_input(v1.first_val(), "fmax");
       validate_input(v2.first_val(), "fmax");
     }
-    return v1.first_val() > v2.first_val() ? v1 : v2;
+    return record_guard(guard_greater, v1, v2, v1.first_val() > v2.first_val()) ? v1 : v2;
   }
   
   template <short AutodiffOrder, bool StrictSmoothness, bool ValidateIO>
@@ -29,7 +30,7 @@ namespace nomad {
       validate_input(x, "fmax");
       validate_input(v2.first_val(), "fmax");
     }
-    return x > v2.first_val() ? var<AutodiffOrder, StrictSmoothness, ValidateIO>(x) : v2;
+    return record_guard(guard_greater, x, v2, x > v2.first_val()) ? var<AutodiffOrder, StrictSmoothness, ValidateIO>(x) : v2;
   }
   
   template <short AutodiffOrder, bool StrictSmoothness, bool ValidateIO>
@@ -40,7 +41,7 @@ namespace nomad {
       validate_input(v1.first_val(), "fmax");
       validate_input(y, "fmax");
     }
-    return v1.first_val() > y ? v1 : var<AutodiffOrder, StrictSmoothness, ValidateIO>(y);
+    return record_guard(guard_greater, v1, y, v1.first_val() > y) ? v1 : var<AutodiffOrder, StrictSmoothness, ValidateIO>(y);
   }
 
 }
@@ -5,6 +5,8 @@
 #include <type_traits>
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_var_node.hpp>
 #include <src/var/derived/binary_var_node.hpp>
 #include <src/autodiff/validation.hpp>
@@ -27,6 +29,7 @@ namespace nomad {
     const unsigned int n_inputs = 2;
     
     create_node<binary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2)>(&fmod);
     
     double x = v1.first_val();
     double y = v2.first_val();
@@ -49,7 +52,7 @@ namespace nomad {
       throw nomad_output_partial_error("fmod");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -67,6 +70,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(x), decltype(v2)>(&fmod, x);
     
     double y = v2.first_val();
     
@@ -84,7 +88,7 @@ namespace nomad {
       throw nomad_output_partial_error("fmod");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -102,6 +106,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(y)>(&fmod, y);
     
     double x = v1.first_val();
     
@@ -119,7 +124,7 @@ namespace nomad {
       throw nomad_output_partial_error("fmod");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -3,6 +3,8 @@
 
 #include <math.h>
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_var_node.hpp>
 #include <src/var/derived/binary_var_node.hpp>
 #include <src/autodiff/validation.hpp>
@@ -27,6 +29,7 @@ namespace nomad {
     const unsigned int n_inputs = 2;
     
     create_node<binary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2)>(&atan2);
 
     double y = v1.first_val();
     double x = v2.first_val();
@@ -69,7 +72,7 @@ namespace nomad {
       throw nomad_output_partial_error("atan2");
     }
 
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -87,6 +90,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(y), decltype(v2)>(&atan2, y);
     
     double x = v2.first_val();
     try {
@@ -107,7 +111,7 @@ namespace nomad {
       throw nomad_output_partial_error("atan2");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -125,6 +129,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(x)>(&atan2, x);
     
     double y = v1.first_val();
     
@@ -146,7 +151,7 @@ namespace nomad {
       throw nomad_output_partial_error("atan2");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -3,6 +3,8 @@
 
 #include <math.h>
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/binary_var_node.hpp>
 #include <src/autodiff/validation.hpp>
 
@@ -26,6 +28,7 @@ namespace nomad {
     const unsigned int n_inputs = 2;
     
     create_node<binary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2)>(&binary_prod_cubes);
 
     double x = v1.first_val();
     double y = v2.first_val();
@@ -59,7 +62,7 @@ namespace nomad {
       throw nomad_output_partial_error("binary_prod_cubes");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
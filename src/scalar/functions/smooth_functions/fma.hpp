@@ -3,6 +3,8 @@
 
 #include <math.h>
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/autodiff/validation.hpp>
 
 namespace nomad {
@@ -27,6 +29,7 @@ namespace nomad {
     const unsigned int n_inputs = 3;
  
     create_node<var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2), decltype(v3)>(&fma);
     
     double x = v1.first_val();
     double y = v2.first_val();
@@ -61,7 +64,7 @@ namespace nomad {
       throw nomad_output_partial_error("fma");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -3,6 +3,8 @@
 
 #include <math.h>
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_var_node.hpp>
 #include <src/var/derived/binary_var_node.hpp>
 #include <src/autodiff/validation.hpp>
@@ -27,6 +29,7 @@ namespace nomad {
     const unsigned int n_inputs = 2;
     
     create_node<binary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2)>(&hypot);
 
     push_inputs(v1.dual_numbers());
     push_inputs(v2.dual_numbers());
@@ -110,7 +113,7 @@ namespace nomad {
       throw nomad_output_partial_error("hypot");
     }
 
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -128,6 +131,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(x), decltype(v2)>(&hypot, x);
     
     push_inputs(v2.dual_numbers());
     
@@ -189,7 +193,7 @@ namespace nomad {
       throw nomad_output_partial_error("hypot");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -207,6 +211,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(y)>(&hypot, y);
     
     push_inputs(v1.dual_numbers());
     
@@ -268,7 +273,7 @@ namespace nomad {
       throw nomad_output_partial_error("hypot");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
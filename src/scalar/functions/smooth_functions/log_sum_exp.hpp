@@ -3,6 +3,8 @@
 
 #include <math.h>
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_var_node.hpp>
 #include <src/var/derived/binary_var_node.hpp>
 #include <src/autodiff/validation.hpp>
@@ -30,6 +32,7 @@ namespace nomad {
     const unsigned int n_inputs = 2;
       
     create_node<binary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2)>(&log_sum_exp);
 
     double x = v1.first_val();
     double y = v2.first_val();
@@ -95,7 +98,7 @@ namespace nomad {
       throw nomad_output_partial_error("log_sum_exp");
     }
 
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -113,6 +116,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(x), decltype(v2)>(&log_sum_exp, x);
     
     double y = v2.first_val();
     try {
@@ -162,7 +166,7 @@ namespace nomad {
       throw nomad_output_partial_error("log_sum_exp");
     }
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -180,6 +184,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(y)>(&log_sum_exp, y);
     
     double x = v1.first_val();
     try {
@@ -229,7 +234,7 @@ namespace nomad {
       throw nomad_output_partial_error("log_sum_exp");
     }
       
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
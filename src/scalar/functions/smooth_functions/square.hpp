@@ -2,6 +2,8 @@
 #define nomad__src__scalar__functions__smooth_functions__square_hpp
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/square_var_node.hpp>
 #include <src/autodiff/validation.hpp>
 
@@ -18,6 +20,7 @@ namespace nomad {
     if (ValidateIO) validate_input(input.first_val(), "square");
       
     create_node<square_var_node<AutodiffOrder>>(1);
+    record_replay<decltype(input)>(&square);
     
     double val = input.first_val();
 
@@ -29,7 +32,7 @@ namespace nomad {
       
     push_inputs(input.dual_numbers());
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -2,6 +2,8 @@
 #define nomad__src__scalar__functions__smooth_functions__trinary_prod_cubes_hpp
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/autodiff/validation.hpp>
 
 namespace nomad {
@@ -26,6 +28,7 @@ namespace nomad {
     const unsigned int n_inputs = 3;
 
     create_node<var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2), decltype(v3)>(&trinary_prod_cubes);
     
     double x = v1.first_val();
     double y = v2.first_val();
@@ -72,7 +75,7 @@ namespace nomad {
       throw nomad_output_partial_error("trinary_prod_cubes");
     }
 
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -2,6 +2,7 @@
 #define nomad__src__scalar__operators__nonsmooth_operators__operator_less_than_hpp
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
 #include <src/autodiff/validation.hpp>
 
 namespace nomad {
@@ -14,7 +15,7 @@ namespace nomad {
       validate_input(v1.first_val(), "operator<");
       validate_input(v2.first_val(), "operator<");
     }
-    return v1.first_val() < v2.first_val();
+    return record_guard(guard_less, v1, v2, v1.first_val() < v2.first_val());
   }
   
   template <short AutodiffOrder, bool StrictSmoothness, bool ValidateIO>
@@ -25,7 +26,7 @@ namespace nomad {
       validate_input(x, "operator<");
       validate_input(v2.first_val(), "operator<");
     }
-    return x < v2.first_val();
+    return record_guard(guard_less, x, v2, x < v2.first_val());
   }
   
   template <short AutodiffOrder, bool StrictSmoothness, bool ValidateIO>
@@ -36,7 +37,7 @@ namespace nomad {
       validate_input(v1.first_val(), "operator<");
       validate_input(y, "operator<");
     }
-    return v1.first_val()< y;
+    return record_guard(guard_less, v1, y, v1.first_val() < y);
   }
 
 }
@@ -2,6 +2,7 @@
 #define nomad__src__scalar__operators__nonsmooth_operators__operator_unary_not_hpp
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
 #include <src/autodiff/validation.hpp>
 
 namespace nomad {
@@ -10,7 +11,7 @@ namespace nomad {
   inline typename std::enable_if<!StrictSmoothness, bool >::type
     operator!(const var<AutodiffOrder, StrictSmoothness, ValidateIO>& input) {
     if (ValidateIO) validate_input(input.first_val(), "operator!");
-    return !(input.first_val());
+    return record_guard(guard_equal, input, 0.0, !(input.first_val()));
   }
 
 }
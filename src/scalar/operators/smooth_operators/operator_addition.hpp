@@ -2,6 +2,8 @@
 #define nomad__src__scalar__operators__smooth_operators__operator_addition_hpp
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_plus_var_node.hpp>
 #include <src/var/derived/binary_sum_var_node.hpp>
 #include <src/autodiff/validation.hpp>
@@ -19,6 +21,7 @@ namespace nomad {
     }
       
     create_node<binary_sum_var_node<AutodiffOrder>>(2);
+    record_replay<decltype(v1), decltype(v2)>(&operator+);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(v1.first_val() + v2.first_val());
@@ -29,7 +32,7 @@ namespace nomad {
     push_inputs(v1.dual_numbers());
     push_inputs(v2.dual_numbers());
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -44,6 +47,7 @@ namespace nomad {
     }
       
     create_node<unary_plus_var_node<AutodiffOrder>>(1);
+    record_replay<decltype(x), decltype(v2)>(&operator+, x);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(x + v2.first_val());
@@ -53,7 +57,7 @@ namespace nomad {
       
     push_inputs(v2.dual_numbers());
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -68,6 +72,7 @@ namespace nomad {
     }
       
     create_node<unary_plus_var_node<AutodiffOrder>>(1);
+    record_replay<decltype(v1), decltype(y)>(&operator+, y);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(v1.first_val() + y);
@@ -77,7 +82,7 @@ namespace nomad {
       
     push_inputs(v1.dual_numbers());
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -2,6 +2,8 @@
 #define nomad__src__scalar__operators__smooth_operators__operator_division_hpp
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_var_node.hpp>
 #include <src/var/derived/binary_var_node.hpp>
 #include <src/autodiff/validation.hpp>
@@ -22,6 +24,7 @@ namespace nomad {
     const unsigned int n_inputs = 2;
     
     create_node<binary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2)>(&operator/);
     
     double x = v1.first_val();
     double y_inv = 1.0 / v2.first_val();
@@ -55,7 +58,7 @@ namespace nomad {
       push_partials<ValidateIO>(-6 * val * y_inv_n);
     }
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -73,6 +76,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(x), decltype(v2)>(&operator/, x);
     
     double y_inv = 1.0 / v2.first_val();
     double val = x * y_inv;
@@ -89,7 +93,7 @@ namespace nomad {
     if (AutodiffOrder >= 2) push_partials<ValidateIO>(val *= - 2 * y_inv);
     if (AutodiffOrder >= 3) push_partials<ValidateIO>(val *= -3 * y_inv);
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -107,6 +111,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(y)>(&operator/, y);
     
     double x = v1.first_val();
     double y_inv = 1.0 / y;
@@ -121,7 +126,7 @@ namespace nomad {
     
     if (AutodiffOrder >= 1) push_partials<ValidateIO>(y_inv);
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -2,6 +2,8 @@
 #define nomad__src__scalar__operators__smooth_operators__operator_division_assignment_hpp
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_var_node.hpp>
 #include <src/var/derived/binary_var_node.hpp>
 #include <src/autodiff/validation.hpp>
@@ -22,6 +24,7 @@ namespace nomad {
     const unsigned int n_inputs = 2;
     
     create_node<binary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2)>(&operator/=);
     
     double x = v1.first_val();
     double y_inv = 1.0 / v2.first_val();
@@ -55,7 +58,7 @@ namespace nomad {
       push_partials<ValidateIO>(-6 * val * y_inv_n);
     }
     
-    v1.set_node(next_node_idx_ - 1);
+    v1.set_node(commit_node<AutodiffOrder>());
     return v1;
     
   }
@@ -74,6 +77,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(y)>(&operator/=, y);
     
     double x = v1.first_val();
     double y_inv = 1.0 / y;
@@ -88,7 +92,7 @@ namespace nomad {
     
     if (AutodiffOrder >= 1) push_partials<ValidateIO>(y_inv);
     
-    v1.set_node(next_node_idx_ - 1);
+    v1.set_node(commit_node<AutodiffOrder>());
     return v1;
     
   }
@@ -2,6 +2,8 @@
 #define nomad__src__scalar__operators__smooth_operators__operator_multiplication_hpp
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_var_node.hpp>
 #include <src/var/derived/multiply_var_node.hpp>
 #include <src/autodiff/validation.hpp>
@@ -19,6 +21,7 @@ namespace nomad {
     }
       
     create_node<multiply_var_node<AutodiffOrder>>(2);
+    record_replay<decltype(v1), decltype(v2)>(&operator*);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(v1.first_val() * v2.first_val());
@@ -29,7 +32,7 @@ namespace nomad {
     push_inputs(v1.dual_numbers());
     push_inputs(v2.dual_numbers());
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -47,6 +50,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2)>(&operator*, v1);
 
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(v1 * v2.first_val());
@@ -58,7 +62,7 @@ namespace nomad {
     
     if (AutodiffOrder >= 1) push_partials<ValidateIO>(v1);
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -76,6 +80,7 @@ namespace nomad {
     const unsigned int n_inputs = 1;
     
     create_node<unary_var_node<AutodiffOrder, partials_order>>(n_inputs);
+    record_replay<decltype(v1), decltype(v2)>(&operator*, v2);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(v1.first_val() * v2);
@@ -87,7 +92,7 @@ namespace nomad {
     
     if (AutodiffOrder >= 1) push_partials<ValidateIO>(v2);
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
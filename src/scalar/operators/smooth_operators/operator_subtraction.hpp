@@ -2,6 +2,8 @@
 #define nomad__src__scalar__operators__smooth_operators__operator_subtraction_hpp
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_minus_var_node.hpp>
 #include <src/var/derived/unary_plus_var_node.hpp>
 #include <src/var/derived/binary_minus_var_node.hpp>
@@ -20,6 +22,7 @@ namespace nomad {
     }
       
     create_node<binary_minus_var_node<AutodiffOrder>>(2);
+    record_replay<decltype(v1), decltype(v2)>(&operator-);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(v1.first_val() - v2.first_val());
@@ -30,7 +33,7 @@ namespace nomad {
     push_inputs(v1.dual_numbers());
     push_inputs(v2.dual_numbers());
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -45,6 +48,7 @@ namespace nomad {
     }
       
     create_node<unary_minus_var_node<AutodiffOrder>>(1);
+    record_replay<decltype(x), decltype(v2)>(&operator-, x);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(x - v2.first_val());
@@ -54,7 +58,7 @@ namespace nomad {
       
     push_inputs(v2.dual_numbers());
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
   
@@ -69,6 +73,7 @@ namespace nomad {
     }
       
     create_node<unary_plus_var_node<AutodiffOrder>>(1);
+    record_replay<decltype(v1), decltype(y)>(&operator-, y);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(v1.first_val() - y);
@@ -78,7 +83,7 @@ namespace nomad {
       
     push_inputs(v1.dual_numbers());
 
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -2,6 +2,8 @@
 #define nomad__src__scalar__operators__smooth_operators__operator_subtraction_assignment_hpp
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_minus_var_node.hpp>
 #include <src/var/derived/unary_plus_var_node.hpp>
 #include <src/var/derived/binary_minus_var_node.hpp>
@@ -20,6 +22,7 @@ namespace nomad {
     }
       
     create_node<binary_minus_var_node<AutodiffOrder>>(2);
+    record_replay<decltype(v1), decltype(v2)>(&operator-=);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(v1.first_val() - v2.first_val());
@@ -30,7 +33,7 @@ namespace nomad {
     push_inputs(v1.dual_numbers());
     push_inputs(v2.dual_numbers());
     
-    v1.set_node(next_node_idx_ - 1);
+    v1.set_node(commit_node<AutodiffOrder>());
     return v1;
     
   }
@@ -46,6 +49,7 @@ namespace nomad {
     }
       
     create_node<unary_plus_var_node<AutodiffOrder>>(1);
+    record_replay<decltype(v1), decltype(y)>(&operator-=, y);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(v1.first_val() - y);
@@ -55,7 +59,7 @@ namespace nomad {
       
     push_inputs(v1.dual_numbers());
     
-    v1.set_node(next_node_idx_ - 1);
+    v1.set_node(commit_node<AutodiffOrder>());
     return v1;
     
   }
@@ -2,6 +2,8 @@
 #define nomad__src__scalar__operators__smooth_operators__operator_unary_decrement_hpp
 
 #include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
 #include <src/var/derived/unary_plus_var_node.hpp>
 #include <src/autodiff/validation.hpp>
 
@@ -14,6 +16,7 @@ namespace nomad {
     if (ValidateIO) validate_input(v1.first_val(), "operator--");
       
     create_node<unary_plus_var_node<AutodiffOrder>>(1);
+    record_replay<decltype(v1)>(&operator--);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(v1.first_val() - 1.0);
@@ -23,7 +26,7 @@ namespace nomad {
       
     push_inputs(v1.dual_numbers());
 
-    v1.set_node(next_node_idx_ - 1);
+    v1.set_node(commit_node<AutodiffOrder>());
     return v1;
     
   }
@@ -35,6 +38,7 @@ namespace nomad {
     if (ValidateIO) validate_input(v1.first_val(), "operator--");
       
     create_node<unary_plus_var_node<AutodiffOrder>>(1);
+    record_replay<decltype(v1), int>(&operator--);
     
     try {
       push_dual_numbers<AutodiffOrder, ValidateIO>(v1.first_val() - 1.0);
@@ -44,7 +48,7 @@ namespace nomad {
       
     push_inputs(v1.dual_numbers());
     
-    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(next_node_idx_ - 1);
+    return var<AutodiffOrder, StrictSmoothness, ValidateIO>(commit_node<AutodiffOrder>());
     
   }
 
@@ -0,0 +1,78 @@
+#ifndef nomad__src__svar__autodiff_hpp
+#define nomad__src__svar__autodiff_hpp
+
+#include <limits>
+#include <string>
+#include <type_traits>
+
+#include <Eigen/Core>
+
+#include <src/autodiff/exceptions.hpp>
+#include <src/autodiff/typedefs.hpp>
+#include <src/svar/svar.hpp>
+
+namespace nomad {
+
+  // Evaluates a functional on svars, the first N of which it builds from
+  // doubles being its inputs
+  template <typename F>
+  typename F::var_type evaluate_svar(const F& functional, const Eigen::VectorXd& x) {
+    typedef typename F::var_type T_svar;
+
+    if (x.size() != T_svar::n_inputs())
+      throw nomad_error("Nomad svar functional with " + std::to_string(T_svar::n_inputs())
+                        + " inputs evaluated at a point with " + std::to_string(x.size()));
+
+    next_svar_input_ = 0;
+
+    try {
+      T_svar f_svar = functional(x);
+      next_svar_input_ = std::numeric_limits<int>::max();
+      return f_svar;
+    } catch (...) {
+      next_svar_input_ = std::numeric_limits<int>::max();
+      throw;
+    }
+  }
+
+  template <typename F>
+  typename std::enable_if<is_svar<typename F::var_type>::value && F::var_type::order() >= 1, void >::type
+  gradient(const F& functional,
+           const Eigen::VectorXd& x,
+           double& f,
+           Eigen::VectorXd& g) {
+
+    auto f_svar = evaluate_svar(functional, x);
+
+    f = f_svar.first_val();
+
+    for (eigen_idx_t i = 0; i < x.size(); ++i)
+    g(i) = f_svar.grad(i);
+
+  }
+
+  template <typename F>
+  typename std::enable_if<is_svar<typename F::var_type>::value && F::var_type::order() >= 2, void >::type
+  hessian(const F& functional,
+          const Eigen::VectorXd& x,
+          double& f,
+          Eigen::VectorXd& g,
+          Eigen::MatrixXd& H) {
+
+    auto f_svar = evaluate_svar(functional, x);
+
+    f = f_svar.first_val();
+
+    for (eigen_idx_t i = 0; i < x.size(); ++i)
+    g(i) = f_svar.grad(i);
+
+    int k = 0;
+    for (eigen_idx_t j = 0; j < x.size(); ++j)
+      for (eigen_idx_t i = 0; i <= j; ++i, ++k)
+        H(i, j) = H(j, i) = f_svar.hessian(k);
+
+  }
+
+}
+
+#endif
@@ -0,0 +1,336 @@
+#ifndef nomad__src__svar__functions_hpp
+#define nomad__src__svar__functions_hpp
+
+#include <cmath>
+
+#include <src/svar/svar.hpp>
+#include <src/scalar/functions/smooth_functions/polygamma.hpp>
+
+namespace nomad {
+
+  // Exponential and logarithmic
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> exp(const svar<N, AutodiffOrder>& a) {
+    const double val = std::exp(a.first_val());
+    return chain(a, val, val, val);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> exp2(const svar<N, AutodiffOrder>& a) {
+    const double log2 = 0.69314718055994531;
+    const double val = std::exp2(a.first_val());
+    return chain(a, val, log2 * val, log2 * log2 * val);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> expm1(const svar<N, AutodiffOrder>& a) {
+    const double val = std::expm1(a.first_val());
+    return chain(a, val, val + 1, val + 1);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> log(const svar<N, AutodiffOrder>& a) {
+    const double x_inv = 1.0 / a.first_val();
+    return chain(a, std::log(a.first_val()), x_inv, -x_inv * x_inv);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> log2(const svar<N, AutodiffOrder>& a) {
+    const double x_inv = 1.0 / a.first_val();
+    const double c = 1.4426950408889634;
+    return chain(a, std::log2(a.first_val()), c * x_inv, -c * x_inv * x_inv);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> log10(const svar<N, AutodiffOrder>& a) {
+    const double x_inv = 1.0 / a.first_val();
+    const double c = 0.43429448190325182;
+    return chain(a, std::log10(a.first_val()), c * x_inv, -c * x_inv * x_inv);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> log1p(const svar<N, AutodiffOrder>& a) {
+    const double x_inv = 1.0 / (1 + a.first_val());
+    return chain(a, std::log1p(a.first_val()), x_inv, -x_inv * x_inv);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> inv_logit(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    const double s = x > 0 ? 1.0 / (1.0 + std::exp(-x)) : std::exp(x) / (1.0 + std::exp(x));
+    const double ds = s * (1 - s);
+    return chain(a, s, ds, ds * (1 - 2 * s));
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> log1p_exp(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    const double s = x > 0 ? 1.0 / (1.0 + std::exp(-x)) : std::exp(x) / (1.0 + std::exp(x));
+    const double val = x > 0 ? x + std::log1p(std::exp(-x)) : std::log1p(std::exp(x));
+    return chain(a, val, s, s * (1 - s));
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> inv_cloglog(const svar<N, AutodiffOrder>& a) {
+    const double e = std::exp(a.first_val());
+    const double ee = std::exp(-e);
+    return chain(a, 1 - ee, ee * e, -ee * e * (e - 1));
+  }
+
+  // Powers
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> square(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    return chain(a, x * x, 2 * x, 2.0);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> sqrt(const svar<N, AutodiffOrder>& a) {
+    const double val = std::sqrt(a.first_val());
+    const double x_inv = 1.0 / a.first_val();
+    return chain(a, val, 0.5 * val * x_inv, -0.25 * val * x_inv * x_inv);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> inv_sqrt(const svar<N, AutodiffOrder>& a) {
+    const double x_inv = 1.0 / a.first_val();
+    const double val = std::sqrt(x_inv);
+    return chain(a, val, -0.5 * val * x_inv, 0.75 * val * x_inv * x_inv);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> inv(const svar<N, AutodiffOrder>& a) {
+    const double val = 1.0 / a.first_val();
+    return chain(a, val, -val * val, 2 * val * val * val);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> inv_square(const svar<N, AutodiffOrder>& a) {
+    const double x_inv = 1.0 / a.first_val();
+    const double val = x_inv * x_inv;
+    return chain(a, val, -2 * val * x_inv, 6 * val * x_inv * x_inv);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> pow(const svar<N, AutodiffOrder>& a,
+                                    const svar<N, AutodiffOrder>& b) {
+    const double x = a.first_val();
+    const double y = b.first_val();
+    const double val = std::pow(x, y);
+    const double lx = std::log(x);
+    return chain(a, b, val, y * val / x, lx * val,
+                 y * (y - 1) * val / (x * x), (1 + y * lx) * val / x, lx * lx * val);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> pow(double x, const svar<N, AutodiffOrder>& b) {
+    const double val = std::pow(x, b.first_val());
+    const double lx = std::log(x);
+    return chain(b, val, lx * val, lx * lx * val);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> pow(const svar<N, AutodiffOrder>& a, double y) {
+    const double x = a.first_val();
+    const double val = std::pow(x, y);
+    return chain(a, val, y * val / x, y * (y - 1) * val / (x * x));
+  }
+
+  // Trigonometric and hyperbolic
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> sin(const svar<N, AutodiffOrder>& a) {
+    const double s = std::sin(a.first_val());
+    return chain(a, s, std::cos(a.first_val()), -s);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> cos(const svar<N, AutodiffOrder>& a) {
+    const double c = std::cos(a.first_val());
+    return chain(a, c, -std::sin(a.first_val()), -c);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> tan(const svar<N, AutodiffOrder>& a) {
+    const double t = std::tan(a.first_val());
+    const double sec2 = 1 + t * t;
+    return chain(a, t, sec2, 2 * t * sec2);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> asin(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    const double d1 = 1.0 / (1 - x * x);
+    const double d2 = std::sqrt(d1);
+    return chain(a, std::asin(x), d2, x * d1 * d2);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> acos(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    const double d1 = 1.0 / (1 - x * x);
+    const double d2 = std::sqrt(d1);
+    return chain(a, std::acos(x), -d2, -x * d1 * d2);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> atan(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    const double d1 = 1.0 / (1 + x * x);
+    return chain(a, std::atan(x), d1, -2 * x * d1 * d1);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> sinh(const svar<N, AutodiffOrder>& a) {
+    const double s = std::sinh(a.first_val());
+    return chain(a, s, std::cosh(a.first_val()), s);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> cosh(const svar<N, AutodiffOrder>& a) {
+    const double c = std::cosh(a.first_val());
+    return chain(a, c, std::sinh(a.first_val()), c);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> tanh(const svar<N, AutodiffOrder>& a) {
+    const double t = std::tanh(a.first_val());
+    const double sech2 = 1 - t * t;
+    return chain(a, t, sech2, -2 * t * sech2);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> asinh(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    const double d1 = 1.0 / (x * x + 1);
+    const double d2 = std::sqrt(d1);
+    return chain(a, std::asinh(x), d2, -x * d1 * d2);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> acosh(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    const double d1 = 1.0 / (x * x - 1);
+    const double d2 = std::sqrt(d1);
+    return chain(a, std::acosh(x), d2, -x * d1 * d2);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> atanh(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    const double d1 = 1.0 / (1 - x * x);
+    return chain(a, std::atanh(x), d1, 2 * x * d1 * d1);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> atan2(const svar<N, AutodiffOrder>& a,
+                                      const svar<N, AutodiffOrder>& b) {
+    const double y = a.first_val();
+    const double x = b.first_val();
+    const double d = 1.0 / (x * x + y * y);
+    const double p = 2 * x * y * d * d;
+    return chain(a, b, std::atan2(y, x), x * d, -y * d, -p, (y * y - x * x) * d * d, p);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> atan2(double y, const svar<N, AutodiffOrder>& b) {
+    const double x = b.first_val();
+    const double d = 1.0 / (x * x + y * y);
+    return chain(b, std::atan2(y, x), -y * d, 2 * x * y * d * d);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> atan2(const svar<N, AutodiffOrder>& a, double x) {
+    const double y = a.first_val();
+    const double d = 1.0 / (x * x + y * y);
+    return chain(a, std::atan2(y, x), x * d, -2 * x * y * d * d);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> hypot(const svar<N, AutodiffOrder>& a,
+                                      const svar<N, AutodiffOrder>& b) {
+    const double x = a.first_val();
+    const double y = b.first_val();
+    const double val = std::hypot(x, y);
+    const double d3 = 1.0 / (val * val * val);
+    return chain(a, b, val, x / val, y / val, y * y * d3, -x * y * d3, x * x * d3);
+  }
+
+  // Probability
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> erf(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    const double C = 1.1283791670955126 * std::exp(-x * x);
+    return chain(a, std::erf(x), C, -2 * x * C);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> erfc(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    const double C = -1.1283791670955126 * std::exp(-x * x);
+    return chain(a, std::erfc(x), C, -2 * x * C);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> Phi(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    double val = 1;
+    if (x < -40)
+      val = 0;
+    else if (x < 0)
+      val = 0.5 * std::erfc(-0.70710678118654752 * x);
+    else if (x < 40)
+      val = 0.5 * (1.0 + std::erf(0.70710678118654752 * x));
+    const double C = 0.3989422804014327 * std::exp(-0.5 * x * x);
+    return chain(a, val, C, -x * C);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> lgamma(const svar<N, AutodiffOrder>& a) {
+    const double x = a.first_val();
+    return chain(a, std::lgamma(x), digamma(x), AutodiffOrder >= 2 ? trigamma(x) : 0.0);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> log_sum_exp(const svar<N, AutodiffOrder>& a,
+                                            const svar<N, AutodiffOrder>& b) {
+    const double x = a.first_val();
+    const double y = b.first_val();
+    const double val = x > y ? x + std::log1p(std::exp(y - x)) : y + std::log1p(std::exp(x - y));
+    const double p = std::exp(x - val);
+    const double q = std::exp(y - val);
+    return chain(a, b, val, p, q, p * q, -p * q, p * q);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> fma(const svar<N, AutodiffOrder>& a,
+                                    const svar<N, AutodiffOrder>& b,
+                                    const svar<N, AutodiffOrder>& c) {
+    return a * b + c;
+  }
+
+  // Piecewise, with the piece chosen at every evaluation
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> fabs(const svar<N, AutodiffOrder>& a) {
+    return a.first_val() < 0 ? -a : a;
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> fmax(const svar<N, AutodiffOrder>& a,
+                                     const svar<N, AutodiffOrder>& b) {
+    return a.first_val() < b.first_val() ? b : a;
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> fmin(const svar<N, AutodiffOrder>& a,
+                                     const svar<N, AutodiffOrder>& b) {
+    return b.first_val() < a.first_val() ? b : a;
+  }
+
+}
+
+#endif
@@ -0,0 +1,185 @@
+#ifndef nomad__src__svar__operators_hpp
+#define nomad__src__svar__operators_hpp
+
+#include <src/svar/svar.hpp>
+
+namespace nomad {
+
+  // Arithmetic
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator+(const svar<N, AutodiffOrder>& a) {
+    return a;
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator-(const svar<N, AutodiffOrder>& a) {
+    return linear(a, -a.first_val(), -1.0);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator+(const svar<N, AutodiffOrder>& a,
+                                          const svar<N, AutodiffOrder>& b) {
+    return linear(a, b, a.first_val() + b.first_val(), 1.0, 1.0);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator+(double x, const svar<N, AutodiffOrder>& b) {
+    return linear(b, x + b.first_val(), 1.0);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator+(const svar<N, AutodiffOrder>& a, double y) {
+    return linear(a, a.first_val() + y, 1.0);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator-(const svar<N, AutodiffOrder>& a,
+                                          const svar<N, AutodiffOrder>& b) {
+    return linear(a, b, a.first_val() - b.first_val(), 1.0, -1.0);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator-(double x, const svar<N, AutodiffOrder>& b) {
+    return linear(b, x - b.first_val(), -1.0);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator-(const svar<N, AutodiffOrder>& a, double y) {
+    return linear(a, a.first_val() - y, 1.0);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator*(const svar<N, AutodiffOrder>& a,
+                                          const svar<N, AutodiffOrder>& b) {
+    return chain(a, b, a.first_val() * b.first_val(),
+                 b.first_val(), a.first_val(), 0.0, 1.0, 0.0);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator*(double x, const svar<N, AutodiffOrder>& b) {
+    return linear(b, x * b.first_val(), x);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator*(const svar<N, AutodiffOrder>& a, double y) {
+    return linear(a, a.first_val() * y, y);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator/(const svar<N, AutodiffOrder>& a,
+                                          const svar<N, AutodiffOrder>& b) {
+    const double y_inv = 1.0 / b.first_val();
+    const double val = a.first_val() * y_inv;
+    return chain(a, b, val, y_inv, -val * y_inv,
+                 0.0, -y_inv * y_inv, 2 * val * y_inv * y_inv);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator/(double x, const svar<N, AutodiffOrder>& b) {
+    const double y_inv = 1.0 / b.first_val();
+    const double val = x * y_inv;
+    return chain(b, val, -val * y_inv, 2 * val * y_inv * y_inv);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator/(const svar<N, AutodiffOrder>& a, double y) {
+    return linear(a, a.first_val() / y, 1.0 / y);
+  }
+
+  // Assignment
+
+  template <int N, short AutodiffOrder, typename T>
+  inline svar<N, AutodiffOrder>& operator+=(svar<N, AutodiffOrder>& a, const T& b) {
+    return a = a + b;
+  }
+
+  template <int N, short AutodiffOrder, typename T>
+  inline svar<N, AutodiffOrder>& operator-=(svar<N, AutodiffOrder>& a, const T& b) {
+    return a = a - b;
+  }
+
+  template <int N, short AutodiffOrder, typename T>
+  inline svar<N, AutodiffOrder>& operator*=(svar<N, AutodiffOrder>& a, const T& b) {
+    return a = a * b;
+  }
+
+  template <int N, short AutodiffOrder, typename T>
+  inline svar<N, AutodiffOrder>& operator/=(svar<N, AutodiffOrder>& a, const T& b) {
+    return a = a / b;
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder>& operator++(svar<N, AutodiffOrder>& a) {
+    return a = a + 1.0;
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder>& operator--(svar<N, AutodiffOrder>& a) {
+    return a = a - 1.0;
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator++(svar<N, AutodiffOrder>& a, int) {
+    svar<N, AutodiffOrder> previous = a;
+    a = a + 1.0;
+    return previous;
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> operator--(svar<N, AutodiffOrder>& a, int) {
+    svar<N, AutodiffOrder> previous = a;
+    a = a - 1.0;
+    return previous;
+  }
+
+  // Comparison, which can branch freely since nothing is recorded
+
+  template <int N, short AutodiffOrder>
+  inline double svar_value(const svar<N, AutodiffOrder>& a) { return a.first_val(); }
+
+  inline double svar_value(double x) { return x; }
+
+  template <typename T1, typename T2>
+  struct svar_comparison: public std::enable_if<
+    (is_svar<T1>::value && (is_svar<T2>::value || std::is_arithmetic<T2>::value)) ||
+    (std::is_arithmetic<T1>::value && is_svar<T2>::value), bool> { };
+
+  template <typename T1, typename T2>
+  inline typename svar_comparison<T1, T2>::type operator<(const T1& a, const T2& b) {
+    return svar_value(a) < svar_value(b);
+  }
+
+  template <typename T1, typename T2>
+  inline typename svar_comparison<T1, T2>::type operator<=(const T1& a, const T2& b) {
+    return svar_value(a) <= svar_value(b);
+  }
+
+  template <typename T1, typename T2>
+  inline typename svar_comparison<T1, T2>::type operator>(const T1& a, const T2& b) {
+    return svar_value(a) > svar_value(b);
+  }
+
+  template <typename T1, typename T2>
+  inline typename svar_comparison<T1, T2>::type operator>=(const T1& a, const T2& b) {
+    return svar_value(a) >= svar_value(b);
+  }
+
+  template <typename T1, typename T2>
+  inline typename svar_comparison<T1, T2>::type operator==(const T1& a, const T2& b) {
+    return svar_value(a) == svar_value(b);
+  }
+
+  template <typename T1, typename T2>
+  inline typename svar_comparison<T1, T2>::type operator!=(const T1& a, const T2& b) {
+    return svar_value(a) != svar_value(b);
+  }
+
+  template <int N, short AutodiffOrder>
+  inline bool operator!(const svar<N, AutodiffOrder>& a) {
+    return !a.first_val();
+  }
+
+}
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef nomad__src__svar__svar_hpp
+#define nomad__src__svar__svar_hpp
+
+#include <limits>
+#include <type_traits>
+
+namespace nomad {
+
+  // Index of the next input seeded by an svar built from a double.  The
+  // static drivers start it at zero, so that, as with the first d nodes on
+  // the stack, the first N svars a functional builds from doubles are its
+  // inputs and any built after them are constants.
+  thread_local int next_svar_input_ = std::numeric_limits<int>::max();
+
+  // A scalar carrying its value along with its gradient, and for second
+  // order its packed Hessian, with respect to a fixed number of inputs.
+  // Every operation updates the derivatives in place with loops of
+  // compile-time length, so functionals with a few inputs are evaluated
+  // without touching the stacks and their derivative propagation can be
+  // inlined and unrolled entirely.  The Hessian is packed by column, with
+  // element (i, j), i <= j, at j * (j + 1) / 2 + i.
+  template <int N, short AutodiffOrder>
+  class svar {
+  public:
+
+    static_assert(N > 0, "An svar needs at least one input");
+    static_assert(AutodiffOrder == 1 || AutodiffOrder == 2,
+                  "An svar carries first or second order derivatives");
+
+    constexpr static short order() { return AutodiffOrder; }
+    constexpr static int n_inputs() { return N; }
+    constexpr static int n_hessian() { return AutodiffOrder >= 2 ? N * (N + 1) / 2 : 0; }
+
+    svar(): val_(0) { clear(); }
+
+    svar(double val): val_(val) {
+      clear();
+      if (next_svar_input_ < N) grad_[next_svar_input_++] = 1;
+    }
+
+    // A result of an operation, with derivatives still to be filled
+    static svar result(double val) {
+      return svar(val, result_tag());
+    }
+
+    double first_val() const { return val_; }
+
+    double& grad(int i) { return grad_[i]; }
+    double grad(int i) const { return grad_[i]; }
+
+    double& hessian(int k) { return hessian_[k]; }
+    double hessian(int k) const { return hessian_[k]; }
+
+  private:
+
+    struct result_tag {};
+
+    svar(double val, result_tag): val_(val) {}
+
+    void clear() {
+      for (int i = 0; i < N; ++i) grad_[i] = 0;
+      for (int k = 0; k < n_hessian(); ++k) hessian_[k] = 0;
+    }
+
+    double val_;
+    double grad_[N];
+    double hessian_[AutodiffOrder >= 2 ? N * (N + 1) / 2 : 1];
+
+  };
+
+  template <typename>
+  struct is_svar : public std::false_type { };
+
+  template <int N, short AutodiffOrder>
+  struct is_svar< svar<N, AutodiffOrder> > : public std::true_type { };
+
+  // Result of a function of one svar with the given first and second
+  // derivatives at its value
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> chain(const svar<N, AutodiffOrder>& a,
+                                      double val, double d1, double d2) {
+    svar<N, AutodiffOrder> r = svar<N, AutodiffOrder>::result(val);
+
+    for (int i = 0; i < N; ++i)
+      r.grad(i) = d1 * a.grad(i);
+
+    if (AutodiffOrder >= 2) {
+      int k = 0;
+      for (int j = 0; j < N; ++j)
+        for (int i = 0; i <= j; ++i, ++k)
+          r.hessian(k) = d1 * a.hessian(k) + d2 * a.grad(i) * a.grad(j);
+    }
+
+    return r;
+  }
+
+  // Result of a function of two svars with the given first derivatives
+  // and second derivatives (a, a), (a, b), and (b, b) at their values
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> chain(const svar<N, AutodiffOrder>& a,
+                                      const svar<N, AutodiffOrder>& b,
+                                      double val, double da, double db,
+                                      double daa, double dab, double dbb) {
+    svar<N, AutodiffOrder> r = svar<N, AutodiffOrder>::result(val);
+
+    for (int i = 0; i < N; ++i)
+      r.grad(i) = da * a.grad(i) + db * b.grad(i);
+
+    if (AutodiffOrder >= 2) {
+      int k = 0;
+      for (int j = 0; j < N; ++j)
+        for (int i = 0; i <= j; ++i, ++k)
+          r.hessian(k) =   da * a.hessian(k) + db * b.hessian(k)
+                         + daa * a.grad(i) * a.grad(j) + dbb * b.grad(i) * b.grad(j)
+                         + dab * (a.grad(i) * b.grad(j) + b.grad(i) * a.grad(j));
+    }
+
+    return r;
+  }
+
+  // Linear combination of two svars, with no curvature terms
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> linear(const svar<N, AutodiffOrder>& a,
+                                       const svar<N, AutodiffOrder>& b,
+                                       double val, double da, double db) {
+    svar<N, AutodiffOrder> r = svar<N, AutodiffOrder>::result(val);
+
+    for (int i = 0; i < N; ++i)
+      r.grad(i) = da * a.grad(i) + db * b.grad(i);
+
+    for (int k = 0; k < r.n_hessian(); ++k)
+      r.hessian(k) = da * a.hessian(k) + db * b.hessian(k);
+
+    return r;
+  }
+
+  template <int N, short AutodiffOrder>
+  inline svar<N, AutodiffOrder> linear(const svar<N, AutodiffOrder>& a,
+                                       double val, double da) {
+    svar<N, AutodiffOrder> r = svar<N, AutodiffOrder>::result(val);
+
+    for (int i = 0; i < N; ++i)
+      r.grad(i) = da * a.grad(i);
+
+    for (int k = 0; k < r.n_hessian(); ++k)
+      r.hessian(k) = da * a.hessian(k);
+
+    return r;
+  }
+
+}
+
+#endif
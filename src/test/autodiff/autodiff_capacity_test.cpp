@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/matrix/functions.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T>
+class capacity_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    std::vector<T> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+
+    T sum_x2 = 0.0;
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      sum_x2 += y[n] * y[n];
+    return sum_x2;
+  }
+  static std::string name() { return "capacity"; }
+};
+
+TEST(Autodiff, ReserveAndMeasure) {
+
+  const nomad::eigen_idx_t d = 250000;
+  Eigen::VectorXd x = Eigen::VectorXd::Constant(d, 0.5);
+
+  capacity_func<nomad::var1> func;
+  Eigen::VectorXd g(d);
+
+  nomad::autodiff_context context;
+  nomad::autodiff_context::scope bound(context);
+
+  // Measuring leaves the stacks of the calling thread untouched
+  nomad::stack_sizes sizes = nomad::measure_stacks(func, x);
+  EXPECT_EQ(0u, nomad::max_node_idx);
+  EXPECT_LT(2 * d, sizes.n_nodes);
+
+  nomad::reserve(sizes);
+
+  nomad::nomad_idx_t max_node_idx = nomad::max_node_idx;
+  nomad::nomad_idx_t max_partials_idx = nomad::max_partials_idx;
+  nomad::nomad_idx_t max_inputs_idx = nomad::max_inputs_idx;
+
+  // Recording into the reserved stacks never grows them
+  nomad::reset();
+  func(x);
+  nomad::stack_sizes usage = nomad::stack_usage();
+  EXPECT_EQ(sizes.n_nodes, usage.n_nodes);
+  EXPECT_EQ(sizes.n_partials, usage.n_partials);
+  EXPECT_EQ(sizes.n_inputs, usage.n_inputs);
+
+  nomad::gradient(func, x, g);
+  EXPECT_EQ(0, (g.array() != 1.0).count());
+
+  EXPECT_EQ(max_node_idx, nomad::max_node_idx);
+  EXPECT_EQ(max_partials_idx, nomad::max_partials_idx);
+  EXPECT_EQ(max_inputs_idx, nomad::max_inputs_idx);
+
+  // Shrinking after a reset returns all of the committed memory
+  EXPECT_LT(0u, nomad::committed_stack_bytes_);
+  nomad::shrink_to_fit();
+  EXPECT_EQ(0u, nomad::committed_stack_bytes_);
+
+  nomad::gradient(func, x, g);
+  EXPECT_EQ(0, (g.array() != 1.0).count());
+
+}
+
+TEST(Autodiff, MemoryCap) {
+
+  const nomad::eigen_idx_t d = 500000;
+  Eigen::VectorXd x = Eigen::VectorXd::Constant(d, 0.5);
+
+  capacity_func<nomad::var1> func;
+  Eigen::VectorXd g(d);
+
+  nomad::autodiff_context context;
+  nomad::autodiff_context::scope bound(context);
+
+  nomad::stack_memory_cap_ = std::size_t(16) << 20;
+  EXPECT_THROW(nomad::gradient(func, x, g), nomad::nomad_memory_error);
+  EXPECT_GE(nomad::stack_memory_cap_, nomad::committed_stack_bytes_);
+  EXPECT_EQ(1u, nomad::next_node_idx_);
+
+  // Smaller graphs fit under the cap once the failed graph is released
+  nomad::shrink_to_fit();
+  Eigen::VectorXd x_small = x.head(1000);
+  Eigen::VectorXd g_small(1000);
+  nomad::gradient(func, x_small, g_small);
+  EXPECT_EQ(0, (g_small.array() != 1.0).count());
+
+  nomad::stack_memory_cap_ = 0;
+  nomad::gradient(func, x, g);
+  EXPECT_EQ(0, (g.array() != 1.0).count());
+
+}
+
+TEST(Autodiff, HighWaterMark) {
+
+  const nomad::eigen_idx_t d = 200000;
+  Eigen::VectorXd x = Eigen::VectorXd::Constant(d, 0.5);
+
+  capacity_func<nomad::var1> func;
+
+  nomad::track_high_water_mark_ = true;
+
+  std::thread first([&]() {
+    Eigen::VectorXd g(d);
+    nomad::gradient(func, x, g);
+  });
+  first.join();
+
+  nomad::stack_sizes high_water = nomad::high_water_mark();
+  EXPECT_LT(2 * d, high_water.n_nodes);
+
+  // Stacks of later threads are committed to the high-water mark at once
+  nomad::nomad_idx_t max_node_idx = 0;
+  std::thread second([&]() {
+    nomad::var1 v = 1.0;
+    (void)v;
+    max_node_idx = nomad::max_node_idx;
+    nomad::reset();
+  });
+  second.join();
+
+  EXPECT_LE(high_water.n_nodes + 1, max_node_idx);
+
+  nomad::track_high_water_mark_ = false;
+
+}
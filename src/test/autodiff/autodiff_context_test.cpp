@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <src/autodiff/base_functor.hpp>
+#include <src/autodiff/first_order.hpp>
+#include <src/autodiff/second_order.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T>
+class context_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    std::vector<T> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+    
+    T v = y[0];
+    T sum_x2 = 0.0;
+    for (nomad::eigen_idx_t n = 1; n < x.size(); ++n)
+      sum_x2 += square(y[n]);
+    return 0.5 * sum_x2 * exp(-v) + 0.5 * square(v) / 9.0;
+  }
+  static std::string name() { return "context"; }
+};
+
+void context_grad(const Eigen::VectorXd& x, Eigen::VectorXd& g) {
+  double sum_x2 = 0;
+  for (nomad::eigen_idx_t n = 1; n < x.size(); ++n)
+    sum_x2 += x[n] * x[n];
+  g[0] = - 0.5 * sum_x2 * std::exp(-x[0]) + x[0] / 9.0;
+  for (nomad::eigen_idx_t n = 1; n < x.size(); ++n)
+    g[n] = x[n] * std::exp(-x[0]);
+}
+
+TEST(Autodiff, ContextScope) {
+  
+  using nomad::var1;
+  
+  nomad::reset();
+  var1 outer = nomad::exp(var1(0.5));
+  nomad::nomad_idx_t outer_nodes = nomad::next_node_idx_;
+  
+  {
+    nomad::autodiff_context context;
+    nomad::autodiff_context::scope bound(context);
+    
+    EXPECT_EQ(1U, nomad::next_node_idx_);
+    
+    var1 inner = var1(1.5) * var1(2.0);
+    EXPECT_FLOAT_EQ(3.0, inner.first_val());
+  }
+  
+  EXPECT_EQ(outer_nodes, nomad::next_node_idx_);
+  EXPECT_FLOAT_EQ(std::exp(0.5), outer.first_val());
+  
+  nomad::reset();
+  
+}
+
+TEST(Autodiff, ConcurrentGradients) {
+  
+  const int n_threads = 4;
+  const int n_calls = 50;
+  const nomad::eigen_idx_t d = 200;
+  
+  std::vector<int> n_failures(n_threads, 0);
+  std::vector<std::thread> threads;
+  
+  for (int t = 0; t < n_threads; ++t) {
+    threads.push_back(std::thread([t, &n_failures, n_calls, d]() {
+      
+      context_func<nomad::var2> func;
+      
+      Eigen::VectorXd x(d);
+      for (nomad::eigen_idx_t n = 0; n < d; ++n)
+        x[n] = 0.1 * (t + 1) + 0.01 * n;
+      
+      Eigen::VectorXd g_exact(d);
+      context_grad(x, g_exact);
+      
+      double f;
+      Eigen::VectorXd g(d);
+      
+      for (int n = 0; n < n_calls; ++n) {
+        nomad::gradient(func, x, f, g);
+        if ((g - g_exact).lpNorm<Eigen::Infinity>() > 1e-10) ++n_failures[t];
+      }
+      
+    }));
+  }
+  
+  for (int t = 0; t < n_threads; ++t) threads[t].join();
+  
+  for (int t = 0; t < n_threads; ++t)
+    EXPECT_EQ(0, n_failures[t]) << "Thread " << t;
+  
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <string>
+#include <vector>
+
+#include <src/autodiff/base_functor.hpp>
+#include <src/autodiff/first_order.hpp>
+#include <src/autodiff/second_order.hpp>
+#include <src/matrix/functions.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T>
+class chain_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    std::vector<T> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+
+    T sum_x2 = 0.0;
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      sum_x2 += square(y[n]) * y[0];
+    return sum_x2;
+  }
+  static std::string name() { return "chain"; }
+};
+
+template <typename T>
+class wide_sum_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    Eigen::Matrix<T, Eigen::Dynamic, 1> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y(n) = x[n];
+    return nomad::sum(y);
+  }
+  static std::string name() { return "wide_sum"; }
+};
+
+void chain_grad(const Eigen::VectorXd& x, Eigen::VectorXd& g) {
+  double sum_x2 = 0;
+  for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+    sum_x2 += x[n] * x[n];
+  for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+    g[n] = 2 * x[n] * x[0];
+  g[0] += sum_x2;
+}
+
+TEST(Autodiff, StackGrowth) {
+
+  const nomad::eigen_idx_t d = 200000;
+
+  Eigen::VectorXd x(d);
+  for (nomad::eigen_idx_t n = 0; n < d; ++n)
+    x[n] = 1e-3 * (n % 100);
+  x[0] = 0.5;
+
+  Eigen::VectorXd g_exact(d);
+  chain_grad(x, g_exact);
+
+  chain_func<nomad::var1> func;
+  Eigen::VectorXd g(d);
+
+  nomad::reset();
+  nomad::var1 first = 0.5;
+  nomad::var_node_base* first_node = &nomad::var_nodes_[first.node()];
+
+  // Growing the stacks leaves existing nodes in place
+  Eigen::VectorXd x_first = x;
+  x_first[0] = first.first_val();
+  chain_func<nomad::var1>()(x_first);
+
+  EXPECT_LT(nomad::base_node_size_, nomad::next_node_idx_);
+  EXPECT_EQ(first_node, &nomad::var_nodes_[first.node()]);
+  EXPECT_FLOAT_EQ(0.5, first.first_val());
+
+  // The second call records into the stacks committed by the first
+  for (int n = 0; n < 2; ++n) {
+    nomad::gradient(func, x, g);
+    EXPECT_LT((g - g_exact).lpNorm<Eigen::Infinity>(), 1e-8);
+  }
+
+  // Wider dual numbers fit in the stacks committed for a first order graph
+  chain_func<nomad::var3> func3;
+  Eigen::VectorXd g3(d);
+  nomad::gradient(func3, x, g3);
+  EXPECT_LT((g3 - g_exact).lpNorm<Eigen::Infinity>(), 1e-8);
+
+  Eigen::VectorXd x_small = x.head(5);
+  Eigen::VectorXd g_small(5);
+  Eigen::MatrixXd H(5, 5);
+  Eigen::VectorXd g_exact_small(5);
+  chain_grad(x_small, g_exact_small);
+
+  double f;
+  nomad::hessian(func3, x_small, f, g_small, H);
+  EXPECT_LT((g_small - g_exact_small).lpNorm<Eigen::Infinity>(), 1e-10);
+  EXPECT_FLOAT_EQ(2 * x_small[0] + 4 * x_small[0], H(0, 0));
+  EXPECT_FLOAT_EQ(2 * x_small[1], H(0, 1));
+  EXPECT_FLOAT_EQ(2 * x_small[0], H(1, 1));
+
+}
+
+TEST(Autodiff, LargeRecord) {
+
+  // The inputs of the final sum span several commits of the inputs stack
+  const nomad::eigen_idx_t d = 300000;
+
+  Eigen::VectorXd x = Eigen::VectorXd::Constant(d, 0.25);
+
+  wide_sum_func<nomad::var1> func;
+  double f;
+  Eigen::VectorXd g(d);
+
+  nomad::gradient(func, x, f, g);
+
+  EXPECT_FLOAT_EQ(0.25 * d, f);
+  EXPECT_EQ(0, (g.array() != 1.0).count());
+
+}
+
+TEST(Autodiff, StackAlignment) {
+
+  // Every stack starts on a chunk boundary so that huge pages can back it
+  nomad::reset();
+  nomad::var1 v = 1.0;
+  (void)v;
+
+  EXPECT_EQ(0u, reinterpret_cast<std::size_t>(nomad::var_nodes_) % nomad::stack_chunk_bytes);
+  EXPECT_EQ(0u, reinterpret_cast<std::size_t>(nomad::dual_numbers_) % nomad::stack_chunk_bytes);
+  EXPECT_EQ(0u, reinterpret_cast<std::size_t>(nomad::partials_) % nomad::stack_chunk_bytes);
+  EXPECT_EQ(0u, reinterpret_cast<std::size_t>(nomad::inputs_) % nomad::stack_chunk_bytes);
+
+  nomad::reset();
+
+}
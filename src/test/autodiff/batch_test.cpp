@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+// Refuses points whose first component is negative, and otherwise records a
+// graph whose size grows with that component so that the points are of
+// uneven cost
+template <typename T>
+class uneven_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    if (x[0] < 0) throw nomad::nomad_domain_error(x[0], "nonnegative", "uneven_func");
+
+    std::vector<T> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+
+    T sum = 0.0;
+    const int n_terms = 1 + static_cast<int>(50 * x[0]);
+    for (int m = 0; m < n_terms; ++m)
+      for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+        sum += cos(y[n] * (m + 1) * 0.01) * y[(n + 1) % x.size()];
+    return sum;
+  }
+  static std::string name() { return "uneven"; }
+};
+
+TEST(Autodiff, GradientBatch) {
+
+  const nomad::eigen_idx_t d = 4;
+  const nomad::eigen_idx_t m = 13;
+
+  Eigen::MatrixXd X = 0.5 * (Eigen::MatrixXd::Random(d, m).array() + 1);
+
+  nomad::thread_pool pool(3);
+  EXPECT_EQ(3u, pool.size());
+
+  Eigen::VectorXd f(m);
+  Eigen::MatrixXd G(d, m);
+  Eigen::MatrixXd H(d, d * m);
+
+  // The pool, and the stacks of its threads, are reused across batches
+  for (int iteration = 0; iteration < 2; ++iteration) {
+
+    nomad::gradient_batch(uneven_func<nomad::var1>(), X, f, G, pool);
+
+    for (nomad::eigen_idx_t k = 0; k < m; ++k) {
+      double f_k;
+      Eigen::VectorXd g_k(d);
+      nomad::gradient(uneven_func<nomad::var1>(), X.col(k), f_k, g_k);
+      EXPECT_EQ(f_k, f(k));
+      EXPECT_EQ(0, (g_k - G.col(k)).lpNorm<Eigen::Infinity>());
+    }
+
+    nomad::hessian_batch(uneven_func<nomad::var2>(), X, f, G, H, pool);
+
+    for (nomad::eigen_idx_t k = 0; k < m; ++k) {
+      double f_k;
+      Eigen::VectorXd g_k(d);
+      Eigen::MatrixXd H_k(d, d);
+      nomad::hessian(uneven_func<nomad::var2>(), X.col(k), f_k, g_k, H_k);
+      EXPECT_EQ(f_k, f(k));
+      EXPECT_EQ(0, (g_k - G.col(k)).lpNorm<Eigen::Infinity>());
+      EXPECT_EQ(0, (H_k - H.block(0, k * d, d, d)).lpNorm<Eigen::Infinity>());
+    }
+
+    X = X.reverse().eval();
+
+  }
+
+  // Without a pool the batch makes its own
+  Eigen::VectorXd f_own(m);
+  Eigen::MatrixXd G_own(d, m);
+  nomad::gradient_batch(uneven_func<nomad::var1>(), X, f_own, G_own, 2);
+  nomad::gradient_batch(uneven_func<nomad::var1>(), X, f, G, pool);
+  EXPECT_EQ(0, (f - f_own).lpNorm<Eigen::Infinity>());
+  EXPECT_EQ(0, (G - G_own).lpNorm<Eigen::Infinity>());
+
+  // Every other point is still evaluated when one fails, and the error of
+  // the first failing point is rethrown
+  X(0, 5) = -1;
+  X(0, 9) = -2;
+  G.setZero();
+
+  try {
+    nomad::gradient_batch(uneven_func<nomad::var1>(), X, f, G, pool);
+    FAIL();
+  } catch (nomad::nomad_domain_error& e) {
+    EXPECT_NE(std::string::npos, std::string(e.what()).find("-1.0"));
+  }
+
+  for (nomad::eigen_idx_t k = 0; k < m; ++k) {
+    if (k == 5 || k == 9) continue;
+    Eigen::VectorXd g_k(d);
+    nomad::gradient(uneven_func<nomad::var1>(), X.col(k), g_k);
+    EXPECT_EQ(0, (g_k - G.col(k)).lpNorm<Eigen::Infinity>());
+  }
+
+}
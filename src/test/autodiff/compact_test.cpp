@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+// Builds a helper vector of which only every other element reaches the
+// output, along with a discarded temporary
+template <typename T, bool WithHelpers>
+class helper_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    const nomad::eigen_idx_t d = x.size();
+
+    Eigen::Matrix<T, Eigen::Dynamic, 1> y(d);
+    for (nomad::eigen_idx_t n = 0; n < d; ++n)
+      y[n] = x[n];
+
+    T lp = 0.0;
+
+    for (nomad::eigen_idx_t n = 0; n < d; ++n) {
+      if (WithHelpers) {
+        T unused = exp(y[n]) * sin(y[n]);
+        (void)unused;
+      }
+      if (n % 2 == 0 || WithHelpers) {
+        T term = log1p(square(y[n])) * y[(n + 1) % d];
+        if (n % 2 == 0) lp += term;
+      }
+    }
+
+    return lp;
+  }
+  static std::string name() { return "helper"; }
+};
+
+template <typename T>
+using with_helpers = helper_func<T, true>;
+
+template <typename T>
+using without_helpers = helper_func<T, false>;
+
+TEST(Autodiff, Compact) {
+
+  const nomad::eigen_idx_t d = 6;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(d, -0.5, 1.5);
+
+  nomad::reset();
+  nomad::var2 f_var = with_helpers<nomad::var2>()(x);
+  const double f = f_var.first_val();
+  const nomad::nomad_idx_t n_nodes = nomad::next_node_idx_ - 1;
+
+  nomad::var2 f_compact = nomad::compact(f_var, d);
+  EXPECT_EQ(f, f_compact.first_val());
+  EXPECT_LT(nomad::next_node_idx_ - 1, n_nodes);
+  EXPECT_EQ(f_compact.node(), nomad::next_node_idx_ - 1);
+
+  for (nomad::eigen_idx_t i = 0; i < d; ++i)
+    EXPECT_EQ(x(i), nomad::var_nodes_[i + 1].first_val());
+
+  // A graph without dead nodes is left alone
+  const nomad::nomad_idx_t n_live = nomad::next_node_idx_ - 1;
+  EXPECT_EQ(f_compact.node(), nomad::compact(f_compact, d).node());
+  EXPECT_EQ(n_live, nomad::next_node_idx_ - 1);
+  nomad::reset();
+
+  // The drivers compact the graph before sweeping
+  Eigen::MatrixXd H(d, d);
+  Eigen::MatrixXd H_live(d, d);
+  nomad::hessian(with_helpers<nomad::var2>(), x, H);
+  nomad::hessian(without_helpers<nomad::var2>(), x, H_live);
+  EXPECT_LT((H - H_live).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  Eigen::MatrixXd grad_H(d, d * d);
+  Eigen::MatrixXd grad_H_live(d, d * d);
+  nomad::grad_hessian(with_helpers<nomad::var3>(), x, grad_H);
+  nomad::grad_hessian(without_helpers<nomad::var3>(), x, grad_H_live);
+  EXPECT_LT((grad_H - grad_H_live).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  nomad::recorded_point<nomad::var3> point(with_helpers<nomad::var3>(), x);
+  Eigen::MatrixXd H_point(d, d);
+  point.hessian(H_point);
+  EXPECT_LT((H_point - H_live).lpNorm<Eigen::Infinity>(), 1e-12);
+
+}
+
+template <typename T>
+class chain_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    T v = x[0];
+    T w = x[1];
+    T z = x[2];
+
+    // exp(-v) has two consumers, so only -v is fused into the exponential
+    T e = exp(-v);
+
+    return e * w + e + inv_sqrt(square(w) + 1.0) + log1p(exp(z)) * w
+           + 0.5 * square(v) / 9.0 + sin(cos(tan(0.25 * z)));
+  }
+  static std::string name() { return "chain"; }
+};
+
+TEST(Autodiff, CompactFusesUnaryChains) {
+
+  const nomad::eigen_idx_t d = 3;
+  Eigen::VectorXd x(d);
+  x << 0.3, -0.7, 1.1;
+
+  nomad::reset();
+  nomad::var3 f_var = chain_func<nomad::var3>()(x);
+  const nomad::nomad_idx_t n_nodes = nomad::next_node_idx_ - 1;
+
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  nomad::hessian_sweeps(f_var, d, g, H);
+  nomad::reset();
+
+  f_var = chain_func<nomad::var3>()(x);
+  nomad::var3 f_fused = nomad::compact(f_var, d);
+
+  // -v, square(w), square(w) + 1.0, exp(z), square(v), 0.5 * square(v),
+  // 0.25 * z, tan(0.25 * z), and cos(tan(0.25 * z)) are folded into their
+  // consumers, and the four partial sums of the result are flattened
+  EXPECT_EQ(n_nodes - 13, nomad::next_node_idx_ - 1);
+  EXPECT_EQ(f_var.first_val(), f_fused.first_val());
+
+  Eigen::VectorXd g_fused(d);
+  Eigen::MatrixXd H_fused(d, d);
+  nomad::hessian_sweeps(f_fused, d, g_fused, H_fused);
+  nomad::reset();
+
+  EXPECT_LT((g - g_fused).lpNorm<Eigen::Infinity>(), 1e-12);
+  EXPECT_LT((H - H_fused).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  Eigen::MatrixXd grad_H(d, d * d);
+  Eigen::MatrixXd grad_H_diff(d, d * d);
+  nomad::grad_hessian(chain_func<nomad::var3>(), x, grad_H);
+  nomad::finite_diff_grad_hessian(chain_func<nomad::var3>(), x, grad_H_diff);
+  EXPECT_LT((grad_H - grad_H_diff).lpNorm<Eigen::Infinity>(), 1e-4);
+
+  Eigen::MatrixXd H1(d, d);
+  nomad::hessian(chain_func<nomad::var2>(), x, H1);
+  EXPECT_LT((H - H1).lpNorm<Eigen::Infinity>(), 1e-12);
+
+}
+
+template <typename T>
+class sum_chain_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    T v = x[0];
+    T w = x[1];
+    T z = x[2];
+
+    // v * w has two consumers, so it stays a node of its own
+    T vw = v * w;
+    T s = 0.0;
+    s += vw;
+    s += square(z);
+    s += exp(w);
+
+    return s + vw * z + (v + w + z) + 2.0 * s;
+  }
+  static std::string name() { return "sum_chain"; }
+};
+
+TEST(Autodiff, CompactFlattensSums) {
+
+  const nomad::eigen_idx_t d = 3;
+  Eigen::VectorXd x(d);
+  x << 0.3, -0.7, 1.1;
+
+  nomad::reset();
+  nomad::var3 f_var = sum_chain_func<nomad::var3>()(x);
+  const nomad::nomad_idx_t n_nodes = nomad::next_node_idx_ - 1;
+
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  nomad::hessian_sweeps(f_var, d, g, H);
+  nomad::reset();
+
+  f_var = sum_chain_func<nomad::var3>()(x);
+  nomad::var3 f_flat = nomad::compact(f_var, d);
+
+  // The first two sums of s, v + w, v + w + z, and the two partial sums
+  // of the result are flattened into their consumers, while s itself has
+  // two consumers and stays
+  EXPECT_EQ(n_nodes - 6, nomad::next_node_idx_ - 1);
+  EXPECT_EQ(f_var.first_val(), f_flat.first_val());
+
+  Eigen::VectorXd g_flat(d);
+  Eigen::MatrixXd H_flat(d, d);
+  nomad::hessian_sweeps(f_flat, d, g_flat, H_flat);
+  nomad::reset();
+
+  EXPECT_LT((g - g_flat).lpNorm<Eigen::Infinity>(), 1e-12);
+  EXPECT_LT((H - H_flat).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  Eigen::MatrixXd grad_H(d, d * d);
+  Eigen::MatrixXd grad_H_diff(d, d * d);
+  nomad::grad_hessian(sum_chain_func<nomad::var3>(), x, grad_H);
+  nomad::finite_diff_grad_hessian(sum_chain_func<nomad::var3>(), x, grad_H_diff);
+  EXPECT_LT((grad_H - grad_H_diff).lpNorm<Eigen::Infinity>(), 1e-4);
+
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T>
+class chain_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    std::vector<T> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+
+    T sum = 0.0;
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      sum += square(y[n]) * exp(-y[0]);
+    for (nomad::eigen_idx_t n = 1; n < x.size(); ++n)
+      sum += log(1.0 + square(y[n] - y[n - 1])) - y[n] / (2.0 + y[0]);
+    return sum;
+  }
+  static std::string name() { return "chain"; }
+};
+
+TEST(Autodiff, DirectionLanes) {
+
+  // Enough inputs to leave the last block of directions partially filled
+  const nomad::eigen_idx_t d = 2 * nomad::direction_lanes + 3;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(d, -0.5, 1.5);
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  nomad::hessian(chain_func<nomad::var2>(), x, f, g, H);
+
+  // Every block of directions matches a single direction sweep
+  Eigen::VectorXd H_dot_v(d);
+  for (nomad::eigen_idx_t i = 0; i < d; ++i) {
+    nomad::hessian_dot_vector(chain_func<nomad::var2>(), x,
+                              Eigen::VectorXd::Unit(d, i), H_dot_v);
+    EXPECT_LT((H.row(i).transpose() - H_dot_v).lpNorm<Eigen::Infinity>(), 1e-12);
+  }
+
+  Eigen::MatrixXd M = Eigen::MatrixXd::Random(d, d);
+  double trace_m_times_h;
+  nomad::trace_matrix_times_hessian(chain_func<nomad::var2>(), x, M, trace_m_times_h);
+  EXPECT_NEAR((M * H).trace(), trace_m_times_h, 1e-10);
+
+  // Each third order block shares one second order direction
+  Eigen::MatrixXd H3(d, d);
+  Eigen::MatrixXd grad_H(d, d * d);
+  nomad::grad_hessian(chain_func<nomad::var3>(), x, f, g, H3, grad_H);
+  EXPECT_LT((H3 - H).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  Eigen::VectorXd grad_trace(d);
+  for (nomad::eigen_idx_t i = 0; i < d; ++i) {
+    Eigen::MatrixXd E = Eigen::MatrixXd::Zero(d, d);
+    E(i, i) = 1;
+    nomad::grad_trace_matrix_times_hessian(chain_func<nomad::var3>(), x, E, f, g, H3, grad_trace);
+    for (nomad::eigen_idx_t k = 0; k < d; ++k)
+      EXPECT_NEAR(grad_trace(k), grad_H(k, i * d + i), 1e-10);
+  }
+
+}
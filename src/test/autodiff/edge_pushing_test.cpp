@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/matrix/functions.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T>
+class block_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    Eigen::Matrix<T, Eigen::Dynamic, 1> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+
+    // Pairs of inputs interact only with each other and with the first input
+    T sum = 0.0;
+    for (nomad::eigen_idx_t n = 1; n + 1 < x.size(); n += 2)
+      sum += exp(y[n] * y[n + 1]) + square(y[n] - y[0]) * y[n + 1] + (-y[n]) / (+y[n + 1] + 3.0);
+
+    // Repeated inputs, a dot product, and a linear tail
+    return sum + y[0] * y[0] + dot(y, y) + log(1.0 + square(y[x.size() - 1])) + y[1] - y[2];
+  }
+  static std::string name() { return "block"; }
+};
+
+TEST(Autodiff, EdgePushing) {
+
+  const nomad::eigen_idx_t d = 9;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(d, -0.75, 1.25);
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  nomad::hessian(block_func<nomad::var2>(), x, f, g, H);
+
+  double f_ep;
+  Eigen::VectorXd g_ep(d);
+  Eigen::SparseMatrix<double> H_ep;
+  nomad::hessian_edge_pushing(block_func<nomad::var2>(), x, f_ep, g_ep, H_ep);
+
+  EXPECT_EQ(f, f_ep);
+  EXPECT_LT((g - g_ep).lpNorm<Eigen::Infinity>(), 1e-12);
+  EXPECT_LT((H - Eigen::MatrixXd(H_ep)).lpNorm<Eigen::Infinity>(), 1e-10);
+
+  // Only the structurally non-zero entries are stored
+  EXPECT_GT(d * d, H_ep.nonZeros());
+  EXPECT_EQ(0, H_ep.coeff(1, 3));
+
+  Eigen::MatrixXd H_dense(d, d);
+  nomad::hessian_edge_pushing(block_func<nomad::var3>(), x, H_dense);
+  EXPECT_LT((H - H_dense).lpNorm<Eigen::Infinity>(), 1e-10);
+
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T>
+class arrow_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    std::vector<T> y(x.data(), x.data() + x.size());
+
+    // Neighbouring inputs interact, and every input interacts with the last
+    T sum = 0.0;
+    for (std::size_t n = 0; n + 2 < y.size(); ++n)
+      sum += exp(y[n] * y[n + 1]) + 2.0 * y[n] - (+y[n + 1]);
+
+    // Linear nodes, including a discarded one, add no entries
+    T unused = y[0] * y[1];
+    (void)unused;
+    return sum + square(y[0] - y[2]) + y[y.size() - 1] * (y[1] + y[3] + y[4]);
+  }
+  static std::string name() { return "arrow"; }
+};
+
+template <typename T>
+class linear_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    std::vector<T> y(x.data(), x.data() + x.size());
+    return -(y[0] + 3.0 * y[1]) - (y[2] - y[0]);
+  }
+  static std::string name() { return "linear"; }
+};
+
+TEST(Autodiff, HessianSparsity) {
+
+  const nomad::eigen_idx_t d = 7;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(d, -0.75, 1.25);
+
+  nomad::clear_hessian_sparsity_cache();
+
+  nomad::hessian_pattern p = nomad::hessian_sparsity(arrow_func<nomad::var2>(), x);
+  EXPECT_EQ(static_cast<nomad::nomad_idx_t>(d), p.n);
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  nomad::hessian(arrow_func<nomad::var2>(), x, f, g, H);
+
+  nomad::nomad_idx_t expected_nonzeros = 0;
+  for (nomad::eigen_idx_t i = 0; i < d; ++i) {
+    for (nomad::eigen_idx_t j = 0; j < d; ++j) {
+      if (H(i, j) != 0) {
+        EXPECT_TRUE(p.contains(i, j)) << i << ", " << j;
+      }
+      EXPECT_EQ(p.contains(i, j), p.contains(j, i));
+      expected_nonzeros += p.contains(i, j);
+    }
+  }
+
+  EXPECT_FALSE(p.contains(1, 4));
+  EXPECT_FALSE(p.contains(d - 1, d - 1));
+  EXPECT_TRUE(p.contains(d - 1, 3));
+  EXPECT_EQ(expected_nonzeros, p.nonzeros());
+
+  std::vector<nomad::nomad_idx_t> rows;
+  std::vector<nomad::nomad_idx_t> cols;
+  p.coo(rows, cols);
+  ASSERT_EQ(p.nonzeros(), rows.size());
+  for (std::size_t n = 0; n < rows.size(); ++n)
+    EXPECT_TRUE(p.contains(rows[n], cols[n]));
+
+  // Recording the same graph at another point reuses the cached pattern
+  nomad::hessian_pattern q = nomad::hessian_sparsity(arrow_func<nomad::var3>(), 2 * x);
+  EXPECT_EQ(p.outer, q.outer);
+  EXPECT_EQ(p.inner, q.inner);
+  EXPECT_EQ(2u, nomad::hessian_pattern_cache_.size());
+  nomad::hessian_sparsity(arrow_func<nomad::var2>(), 2 * x);
+  EXPECT_EQ(2u, nomad::hessian_pattern_cache_.size());
+
+  EXPECT_EQ(0u, nomad::hessian_sparsity(linear_func<nomad::var2>(), x).nonzeros());
+
+  // A cached entry whose structure differs from the recorded graph, as after
+  // a collision of signatures, is recomputed rather than trusted
+  for (auto& entry: nomad::hessian_pattern_cache_) {
+    entry.second.nodes[0] ^= 1;
+    entry.second.pattern = nomad::hessian_pattern();
+  }
+
+  q = nomad::hessian_sparsity(arrow_func<nomad::var2>(), x);
+  EXPECT_EQ(p.outer, q.outer);
+  EXPECT_EQ(p.inner, q.inner);
+
+  // The cache keeps only the most recently used structures
+  for (std::size_t n = 0; n < 2 * nomad::hessian_pattern_cache_capacity; ++n)
+    nomad::hessian_sparsity(arrow_func<nomad::var2>(), Eigen::VectorXd::Ones(6 + n));
+  EXPECT_EQ(nomad::hessian_pattern_cache_capacity, nomad::hessian_pattern_cache_.size());
+
+}
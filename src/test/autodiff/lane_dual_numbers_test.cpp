@@ -0,0 +1,93 @@
+#define NOMAD_DUAL_NUMBER_LAYOUT lane_dual_numbers
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T>
+class cubic_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    std::vector<T> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+
+    T sum_x2 = 0.0;
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      sum_x2 += square(y[n]);
+    return sum_x2 * y[0];
+  }
+  static std::string name() { return "cubic"; }
+};
+
+TEST(Autodiff, LaneDualNumbers) {
+
+  const nomad::eigen_idx_t d = 4;
+  Eigen::VectorXd x(d);
+  x << 0.5, -1.25, 2.0, 0.75;
+
+  // f = x_0 * sum_n x_n^2
+  double sum_x2 = x.squaredNorm();
+
+  Eigen::VectorXd g_exact = 2 * x[0] * x;
+  g_exact[0] += sum_x2;
+
+  Eigen::MatrixXd H_exact = 2 * x[0] * Eigen::MatrixXd::Identity(d, d);
+  H_exact.row(0) += 2 * x.transpose();
+  H_exact.col(0) += 2 * x;
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  Eigen::MatrixXd grad_H(d, d * d);
+
+  nomad::gradient(cubic_func<nomad::var1>(), x, f, g);
+  EXPECT_FLOAT_EQ(x[0] * sum_x2, f);
+  EXPECT_LT((g - g_exact).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  nomad::hessian(cubic_func<nomad::var2>(), x, f, g, H);
+  EXPECT_LT((g - g_exact).lpNorm<Eigen::Infinity>(), 1e-12);
+  EXPECT_LT((H - H_exact).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  nomad::grad_hessian(cubic_func<nomad::var3>(), x, f, g, H, grad_H);
+  EXPECT_LT((g - g_exact).lpNorm<Eigen::Infinity>(), 1e-12);
+  EXPECT_LT((H - H_exact).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  for (nomad::eigen_idx_t i = 0; i < d; ++i) {
+    Eigen::MatrixXd dH_exact = Eigen::MatrixXd::Zero(d, d);
+    if (i == 0) {
+      dH_exact = 2 * Eigen::MatrixXd::Identity(d, d);
+      dH_exact(0, 0) = 6;
+    } else {
+      dH_exact(0, i) = 2;
+      dH_exact(i, 0) = 2;
+    }
+    EXPECT_LT((grad_H.block(0, i * d, d, d) - dH_exact).lpNorm<Eigen::Infinity>(), 1e-12);
+  }
+
+}
+
+TEST(Autodiff, LaneDualNumbersLayout) {
+
+  nomad::reset();
+  nomad::var3 v = 1.5;
+
+  // Each lane is its own 64-byte aligned array indexed by the node
+  EXPECT_EQ(0u, (nomad::dual_lane_stride_ * sizeof(double)) % 64);
+  EXPECT_EQ(0u, reinterpret_cast<std::size_t>(nomad::dual_numbers_) % 64);
+
+  nomad::nomad_idx_t idx = v.dual_numbers();
+  EXPECT_EQ(v.node(), idx);
+  EXPECT_EQ(&nomad::dual_numbers_[idx], &v.first_val());
+  EXPECT_EQ(&nomad::dual_numbers_[nomad::dual_lane_stride_ + idx], &v.first_grad());
+  EXPECT_EQ(&nomad::dual_numbers_[7 * nomad::dual_lane_stride_ + idx], &v.fourth_grad());
+  EXPECT_EQ(1.5, v.first_val());
+
+  nomad::reset();
+
+}
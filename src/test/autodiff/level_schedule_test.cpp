@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+#include <src/var/accumulator.hpp>
+
+// A sum of many independent terms, each a short chain over a few of the
+// inputs, with enough terms for its levels to be split between threads
+template <typename T>
+class terms_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    const nomad::eigen_idx_t d = x.size();
+
+    std::vector<T> y(d);
+    for (nomad::eigen_idx_t n = 0; n < d; ++n)
+      y[n] = x[n];
+
+    nomad::accumulator<T> sum;
+    for (int n = 0; n < 6000; ++n) {
+      const T& a = y[n % d];
+      const T& b = y[(3 * n + 1) % d];
+      sum += log(1.0 + square(a - 0.001 * n)) * exp(-0.5 * b) + sin(a * b);
+    }
+    return sum.sum();
+  }
+  static std::string name() { return "terms"; }
+};
+
+TEST(Autodiff, LevelSchedule) {
+
+  const nomad::eigen_idx_t d = 7;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(d, -0.5, 1.0);
+
+  double f;
+  Eigen::VectorXd g(d);
+  nomad::gradient(terms_func<nomad::var1>(), x, f, g);
+
+  // Every thread count gathers the same sums
+  nomad::reset();
+  nomad::var1 f_var = terms_func<nomad::var1>()(x);
+
+  // The terms sit side by side in a few wide levels
+  nomad::level_schedule<1> schedule(f_var.node());
+  EXPECT_LT(1u, schedule.n_levels());
+  EXPECT_GT(10u, schedule.n_levels());
+
+  Eigen::VectorXd g_one(d);
+  nomad::first_order_reverse_adj(f_var, schedule, 1);
+  for (nomad::eigen_idx_t i = 0; i < d; ++i)
+    g_one(i) = nomad::var_nodes_[i + 1].first_grad();
+
+  EXPECT_LT((g - g_one).lpNorm<Eigen::Infinity>(), 1e-10 * g.lpNorm<Eigen::Infinity>());
+
+  const std::size_t n_threads[] = {2, 3, 4};
+
+  for (std::size_t n: n_threads) {
+    nomad::first_order_reverse_adj(f_var, schedule, n);
+    for (nomad::eigen_idx_t i = 0; i < d; ++i)
+      EXPECT_EQ(g_one(i), nomad::var_nodes_[i + 1].first_grad());
+  }
+
+  EXPECT_THROW(nomad::first_order_reverse_adj(nomad::var1(nomad::next_node_idx_ - 2), schedule, 2),
+               nomad::nomad_error);
+
+  nomad::reset();
+
+  // Tapes keep their schedule across replays
+  nomad::tape<nomad::var1> t;
+  t.record(terms_func<nomad::var1>(), x);
+
+  for (int replay = 0; replay < 2; ++replay) {
+    Eigen::VectorXd y = x.reverse() * (1 + replay);
+
+    double f_tape;
+    Eigen::VectorXd g_tape(d);
+    nomad::gradient(t, y, f_tape, g_tape, 3);
+
+    nomad::gradient(terms_func<nomad::var1>(), y, f, g);
+    EXPECT_FLOAT_EQ(f, f_tape);
+    EXPECT_LT((g - g_tape).lpNorm<Eigen::Infinity>(), 1e-10 * g.lpNorm<Eigen::Infinity>());
+  }
+
+  EXPECT_EQ(1u, t.recordings());
+
+}
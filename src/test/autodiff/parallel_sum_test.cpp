@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+// The log density of a Student-t likelihood over its observations, summed
+// by parallel_sum on NThreads threads, or term by term when NThreads is zero
+template <typename T, std::size_t NThreads>
+class student_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    std::vector<T> theta(3);
+    theta[0] = x[0];
+    T log_sigma = x[1];
+    theta[2] = x[2];
+    theta[1] = exp(log_sigma);
+
+    std::vector<double> y(40);
+    for (std::size_t n = 0; n < y.size(); ++n)
+      y[n] = 0.1 * n - 1.5;
+
+    T lp = -square(theta[0]) + theta[1] * theta[2];
+
+    if (NThreads) {
+      lp += nomad::parallel_sum(term, theta, y, NThreads);
+    } else {
+      for (std::size_t n = 0; n < y.size(); ++n)
+        lp += term(theta, y[n]);
+    }
+
+    return lp;
+  }
+
+  static T term(const std::vector<T>& theta, const double& y) {
+    if (y > 100) throw nomad::nomad_domain_error(y, "at most 100", "student_func");
+    T z = (y - theta[0]) / theta[1];
+    return -0.5 * (theta[2] + 1.0) * log1p(square(z) / theta[2]) - log(theta[1]);
+  }
+
+  static std::string name() { return "student"; }
+};
+
+TEST(Autodiff, ParallelSum) {
+
+  Eigen::VectorXd x(3);
+  x << 0.2, -0.3, 4.0;
+
+  const nomad::eigen_idx_t d = x.size();
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  Eigen::MatrixXd grad_H(d, d * d);
+
+  nomad::grad_hessian(student_func<nomad::var3, 0>(), x, f, g, H, grad_H);
+
+  double f_sum;
+  Eigen::VectorXd g_sum(d);
+  Eigen::MatrixXd H_sum(d, d);
+  Eigen::MatrixXd grad_H_sum(d, d * d);
+
+  nomad::grad_hessian(student_func<nomad::var3, 3>(), x, f_sum, g_sum, H_sum, grad_H_sum);
+  EXPECT_FLOAT_EQ(f, f_sum);
+  EXPECT_LT((g - g_sum).lpNorm<Eigen::Infinity>(), 1e-10);
+  EXPECT_LT((H - H_sum).lpNorm<Eigen::Infinity>(), 1e-10);
+  EXPECT_LT((grad_H - grad_H_sum).lpNorm<Eigen::Infinity>(), 1e-10);
+
+  nomad::hessian(student_func<nomad::var2, 2>(), x, f_sum, g_sum, H_sum);
+  EXPECT_FLOAT_EQ(f, f_sum);
+  EXPECT_LT((g - g_sum).lpNorm<Eigen::Infinity>(), 1e-10);
+  EXPECT_LT((H - H_sum).lpNorm<Eigen::Infinity>(), 1e-10);
+
+  nomad::gradient(student_func<nomad::var1, 4>(), x, f_sum, g_sum);
+  EXPECT_FLOAT_EQ(f, f_sum);
+  EXPECT_LT((g - g_sum).lpNorm<Eigen::Infinity>(), 1e-10);
+
+  // The graph built before the sum is untouched, and only one node is added
+  nomad::reset();
+  std::vector<nomad::var1> theta(2);
+  theta[0] = 0.5;
+  theta[1] = 2.0;
+  const nomad::nomad_idx_t n_nodes = nomad::next_node_idx_;
+
+  std::vector<double> y(10, 1.0);
+  nomad::var1 s = nomad::parallel_sum(
+    [](const std::vector<nomad::var1>& t, const double& y_n) { return t[0] * t[1] * y_n; },
+    theta, y, 3);
+
+  EXPECT_EQ(n_nodes + 1, nomad::next_node_idx_);
+  EXPECT_FLOAT_EQ(10.0, s.first_val());
+
+  nomad::first_order_reverse_adj(s);
+  EXPECT_FLOAT_EQ(20.0, theta[0].first_grad());
+  EXPECT_FLOAT_EQ(5.0, theta[1].first_grad());
+
+  // While a tape records the terms are kept, so the graph can be replayed
+  nomad::reset();
+  nomad::tape<nomad::var1> t;
+  t.record(student_func<nomad::var1, 2>(), x);
+
+  Eigen::VectorXd z = 1.5 * x;
+  nomad::gradient(t, z, f_sum, g_sum);
+  nomad::gradient(student_func<nomad::var1, 0>(), z, f, g);
+  EXPECT_FLOAT_EQ(f, f_sum);
+  EXPECT_LT((g - g_sum).lpNorm<Eigen::Infinity>(), 1e-10);
+  EXPECT_EQ(1u, t.recordings());
+
+  // An error in any shard is rethrown on the calling thread
+  y[7] = 1000;
+  nomad::reset();
+  std::vector<nomad::var1> theta_t(3, 1.0);
+  EXPECT_THROW(nomad::parallel_sum(student_func<nomad::var1, 2>::term, theta_t, y, 3),
+               nomad::nomad_domain_error);
+
+}
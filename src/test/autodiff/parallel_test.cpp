@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T>
+class coupled_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    std::vector<T> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+
+    T sum = 0.0;
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      sum += square(y[n]) * exp(-0.5 * y[0]);
+    for (nomad::eigen_idx_t n = 1; n < x.size(); ++n)
+      sum += log(1.0 + square(y[n] - y[n - 1])) * sin(y[n / 2]);
+    return sum;
+  }
+  static std::string name() { return "coupled"; }
+};
+
+TEST(Autodiff, ParallelHessian) {
+
+  // Enough inputs to leave the last block of directions partially filled,
+  // and fewer blocks than some of the thread counts
+  const nomad::eigen_idx_t d = 2 * nomad::direction_lanes + 3;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(d, -0.5, 1.5);
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  nomad::hessian(coupled_func<nomad::var2>(), x, f, g, H);
+
+  // Every thread sweeps its rows exactly as a single thread would
+  const std::size_t n_threads[] = {0, 2, 3, 5};
+
+  for (std::size_t n: n_threads) {
+    double f_n;
+    Eigen::VectorXd g_n(d);
+    Eigen::MatrixXd H_n = Eigen::MatrixXd::Zero(d, d);
+    nomad::hessian(coupled_func<nomad::var2>(), x, f_n, g_n, H_n, n);
+    EXPECT_EQ(f, f_n);
+    EXPECT_EQ(0, (g - g_n).lpNorm<Eigen::Infinity>());
+    EXPECT_EQ(0, (H - H_n).lpNorm<Eigen::Infinity>());
+  }
+
+  // The graph stays bound to the calling thread
+  EXPECT_EQ(1u, nomad::next_node_idx_);
+
+  // Tapes share their replayed graph in the same way
+  nomad::tape<nomad::var2> t;
+  t.record(coupled_func<nomad::var2>(), x);
+
+  Eigen::MatrixXd H_tape = Eigen::MatrixXd::Zero(d, d);
+  nomad::hessian(t, x, f, g, H_tape, 4);
+  EXPECT_LT((H - H_tape).lpNorm<Eigen::Infinity>(), 1e-12);
+
+}
+
+TEST(Autodiff, ParallelThirdOrder) {
+
+  const nomad::eigen_idx_t d = nomad::direction_lanes + 5;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(d, -0.75, 1.25);
+  Eigen::MatrixXd M = Eigen::MatrixXd::Random(d, d);
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  Eigen::MatrixXd grad_H(d, d * d);
+  nomad::grad_hessian(coupled_func<nomad::var3>(), x, f, g, H, grad_H);
+
+  Eigen::VectorXd grad_trace(d);
+  nomad::grad_trace_matrix_times_hessian(coupled_func<nomad::var3>(), x, M,
+                                         f, g, H, grad_trace);
+
+  const std::size_t n_threads[] = {2, 3, 7};
+
+  for (std::size_t n: n_threads) {
+
+    Eigen::MatrixXd H_n = Eigen::MatrixXd::Zero(d, d);
+    Eigen::MatrixXd grad_H_n = Eigen::MatrixXd::Zero(d, d * d);
+    nomad::grad_hessian(coupled_func<nomad::var3>(), x, f, g, H_n, grad_H_n, n);
+    EXPECT_LT((H - H_n).lpNorm<Eigen::Infinity>(), 1e-12);
+    EXPECT_LT((grad_H - grad_H_n).lpNorm<Eigen::Infinity>(), 1e-12);
+
+    // The terms of the gradient are summed in the same order whatever the
+    // number of threads
+    Eigen::VectorXd grad_trace_n(d);
+    nomad::grad_trace_matrix_times_hessian(coupled_func<nomad::var3>(), x, M,
+                                           f, g, H_n, grad_trace_n, n);
+    EXPECT_LT((H - H_n).lpNorm<Eigen::Infinity>(), 1e-12);
+    EXPECT_LT((grad_trace - grad_trace_n).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  }
+
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <future>
+#include <string>
+#include <vector>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+// Refuses points whose first component is negative
+template <typename T>
+class chain_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    if (x[0] < 0) throw nomad::nomad_domain_error(x[0], "nonnegative", "chain_func");
+
+    std::vector<T> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+
+    T sum = 0.0;
+    for (int m = 0; m < 200; ++m)
+      for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+        sum += sin(y[n] * (m + 1) * 0.01) * y[(n + 1) % x.size()];
+    return sum;
+  }
+  static std::string name() { return "chain"; }
+};
+
+TEST(Autodiff, GradientPipeline) {
+
+  const nomad::eigen_idx_t d = 5;
+  const int n_points = 12;
+
+  Eigen::MatrixXd X = Eigen::MatrixXd::Random(d, n_points).cwiseAbs();
+  X(0, 4) = -1;
+
+  Eigen::VectorXd f(n_points);
+  Eigen::MatrixXd G(d, n_points);
+  for (int k = 0; k < n_points; ++k) {
+    if (k == 4) continue;
+    Eigen::VectorXd g(d);
+    nomad::gradient(chain_func<nomad::var1>(), X.col(k), f(k), g);
+    G.col(k) = g;
+  }
+
+  // The graph of the calling thread is left alone
+  nomad::reset();
+  nomad::var1 a = 2.0;
+  const nomad::nomad_idx_t n_nodes = nomad::next_node_idx_;
+
+  std::vector<std::future<nomad::gradient_result>> results;
+
+  {
+    nomad::gradient_pipeline<chain_func<nomad::var1>> pipeline((chain_func<nomad::var1>()));
+
+    for (int k = 0; k < n_points / 2; ++k)
+      results.push_back(nomad::gradient_async(pipeline, X.col(k)));
+
+    // Each point can be consumed while later ones are in flight
+    for (int k = n_points / 2; k < n_points; ++k) {
+      results.push_back(nomad::gradient_async(pipeline, X.col(k)));
+
+      const int j = k - n_points / 2;
+
+      if (j == 4) {
+        EXPECT_THROW(results[j].get(), nomad::nomad_domain_error);
+        continue;
+      }
+
+      nomad::gradient_result r = results[j].get();
+      EXPECT_EQ(f(j), r.f);
+      EXPECT_EQ(0, (G.col(j) - r.g).lpNorm<Eigen::Infinity>());
+    }
+
+  }
+
+  // Points still in flight are finished before the pipeline is destroyed
+  for (int k = n_points / 2; k < n_points; ++k) {
+    nomad::gradient_result r = results[k].get();
+    EXPECT_EQ(f(k), r.f);
+    EXPECT_EQ(0, (G.col(k) - r.g).lpNorm<Eigen::Infinity>());
+  }
+
+  EXPECT_EQ(n_nodes, nomad::next_node_idx_);
+  EXPECT_EQ(2.0, a.first_val());
+
+}
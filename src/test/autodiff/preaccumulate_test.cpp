@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+// A normal likelihood whose per-observation terms are preaccumulated when
+// Preaccumulate is set
+template <typename T, bool Preaccumulate>
+class likelihood_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    T mu = x[0];
+    T log_sigma = x[1];
+    T nu = x[2];
+    T sigma = exp(log_sigma);
+
+    T lp = 0.0;
+
+    for (int n = 0; n < 8; ++n) {
+      const double y = 0.3 * n - 1.0;
+
+      T lp_n;
+      {
+        if (Preaccumulate) {
+          nomad::preaccumulate guard(lp_n);
+          lp_n = term(y, mu, sigma, nu);
+        } else {
+          lp_n = term(y, mu, sigma, nu);
+        }
+      }
+
+      lp += lp_n;
+    }
+
+    return lp;
+  }
+
+  static T term(double y, const T& mu, const T& sigma, const T& nu) {
+    T z = (y - mu) / sigma;
+    T unused = exp(z) * sin(nu);
+    (void)unused;
+    return -0.5 * (nu + 1.0) * log1p(square(z) / nu) - log(sigma) + 0.1 * z * square(nu);
+  }
+
+  static std::string name() { return "likelihood"; }
+};
+
+// Preaccumulates regions within a preaccumulated region
+template <typename T>
+class nested_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    T a = x[0];
+    T b = x[1];
+
+    T outer;
+    {
+      nomad::preaccumulate outer_guard(outer);
+
+      T inner;
+      {
+        nomad::preaccumulate inner_guard(inner);
+        inner = exp(a * b) + square(b);
+      }
+
+      outer = inner * cos(a) + inner;
+    }
+
+    return outer * b;
+  }
+  static std::string name() { return "nested"; }
+};
+
+template <typename T>
+class nested_plain_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    T a = x[0];
+    T b = x[1];
+    T inner = exp(a * b) + square(b);
+    return (inner * cos(a) + inner) * b;
+  }
+  static std::string name() { return "nested_plain"; }
+};
+
+template <typename F, typename G>
+void test_preaccumulated(const Eigen::VectorXd& x) {
+
+  const nomad::eigen_idx_t d = x.size();
+
+  double f;
+  double f_plain;
+  Eigen::VectorXd g(d);
+  Eigen::VectorXd g_plain(d);
+  nomad::gradient(typename F::template rebind<nomad::var1>(), x, f, g);
+  nomad::gradient(typename G::template rebind<nomad::var1>(), x, f_plain, g_plain);
+  EXPECT_FLOAT_EQ(f_plain, f);
+  EXPECT_LT((g_plain - g).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  Eigen::MatrixXd H(d, d);
+  Eigen::MatrixXd H_plain(d, d);
+  nomad::hessian(typename F::template rebind<nomad::var2>(), x, f, g, H);
+  nomad::hessian(typename G::template rebind<nomad::var2>(), x, f_plain, g_plain, H_plain);
+  EXPECT_LT((g_plain - g).lpNorm<Eigen::Infinity>(), 1e-12);
+  EXPECT_LT((H_plain - H).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  Eigen::MatrixXd grad_H(d, d * d);
+  Eigen::MatrixXd grad_H_plain(d, d * d);
+  nomad::grad_hessian(typename F::template rebind<nomad::var3>(), x, grad_H);
+  nomad::grad_hessian(typename G::template rebind<nomad::var3>(), x, grad_H_plain);
+  EXPECT_LT((grad_H_plain - grad_H).lpNorm<Eigen::Infinity>(), 1e-10);
+
+}
+
+template <bool Preaccumulate>
+struct likelihood {
+  template <typename T> using rebind = likelihood_func<T, Preaccumulate>;
+};
+
+struct nested {
+  template <typename T> using rebind = nested_func<T>;
+};
+
+struct nested_plain {
+  template <typename T> using rebind = nested_plain_func<T>;
+};
+
+TEST(Autodiff, Preaccumulate) {
+
+  Eigen::VectorXd x(3);
+  x << 0.2, -0.3, 2.5;
+
+  nomad::reset();
+  likelihood_func<nomad::var3, false>()(x);
+  const nomad::nomad_idx_t n_nodes = nomad::next_node_idx_ - 1;
+  nomad::reset();
+  likelihood_func<nomad::var3, true>()(x);
+  const nomad::nomad_idx_t n_preaccumulated = nomad::next_node_idx_ - 1;
+  nomad::reset();
+
+  // Besides the three inputs, sigma, and the zero leaf, each of the eight
+  // terms becomes a single node added to lp
+  EXPECT_EQ(5u + 8u * 2u, n_preaccumulated);
+  EXPECT_LT(n_preaccumulated, n_nodes);
+
+  test_preaccumulated<likelihood<true>, likelihood<false>>(x);
+
+  Eigen::VectorXd y(2);
+  y << 0.4, -0.6;
+  test_preaccumulated<nested, nested_plain>(y);
+
+  // A tape keeps the region so that it can be replayed
+  nomad::tape<nomad::var2> t;
+  t.record(likelihood_func<nomad::var2, true>(), x);
+  EXPECT_TRUE(t.replayable());
+
+  x << -0.1, 0.35, 3.0;
+
+  double f;
+  double f_plain;
+  Eigen::VectorXd g(3);
+  Eigen::VectorXd g_plain(3);
+  Eigen::MatrixXd H(3, 3);
+  Eigen::MatrixXd H_plain(3, 3);
+  nomad::hessian(t, x, f, g, H);
+  nomad::hessian(likelihood_func<nomad::var2, false>(), x, f_plain, g_plain, H_plain);
+  EXPECT_FLOAT_EQ(f_plain, f);
+  EXPECT_LT((g_plain - g).lpNorm<Eigen::Infinity>(), 1e-12);
+  EXPECT_LT((H_plain - H).lpNorm<Eigen::Infinity>(), 1e-12);
+
+}
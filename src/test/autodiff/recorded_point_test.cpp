@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T>
+class coupled_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    T y0 = x[0];
+    T y1 = x[1];
+    T y2 = x[2];
+    T y3 = x[3];
+    return exp(y0 * y1) * sin(y2) + square(y3) * y0 / (1.0 + square(y1)) + log(y2 + y3);
+  }
+  static std::string name() { return "coupled"; }
+};
+
+TEST(Autodiff, RecordedPoint) {
+
+  const nomad::eigen_idx_t d = 4;
+  Eigen::VectorXd x(d);
+  x << 0.25, -0.5, 0.75, 1.5;
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  Eigen::MatrixXd grad_H(d, d * d);
+  nomad::grad_hessian(coupled_func<nomad::var3>(), x, f, g, H, grad_H);
+
+  nomad::recorded_point<nomad::var3> p(coupled_func<nomad::var3>(), x);
+
+  EXPECT_EQ(f, p.value());
+  EXPECT_LT((g - p.gradient()).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  // Queries in any order reuse the same recorded nodes
+  for (int r = 0; r < 2; ++r) {
+
+    Eigen::MatrixXd H_point(d, d);
+    p.hessian(H_point);
+    EXPECT_LT((H - H_point).lpNorm<Eigen::Infinity>(), 1e-12);
+
+    Eigen::VectorXd v = Eigen::VectorXd::LinSpaced(d, -1, 1 + r);
+    Eigen::VectorXd H_dot_v(d);
+    p.hvp(v, H_dot_v);
+    EXPECT_LT((H * v - H_dot_v).lpNorm<Eigen::Infinity>(), 1e-12);
+
+    Eigen::MatrixXd V = Eigen::MatrixXd::Random(d, 11);
+    Eigen::MatrixXd H_dot_V(d, 11);
+    p.hvp_block(V, H_dot_V);
+    EXPECT_LT((H * V - H_dot_V).lpNorm<Eigen::Infinity>(), 1e-12);
+
+    Eigen::VectorXd u = Eigen::VectorXd::Random(d);
+    Eigen::VectorXd w(d);
+    p.third_order_contract(u, v, w);
+
+    Eigen::VectorXd w_expected = Eigen::VectorXd::Zero(d);
+    for (nomad::eigen_idx_t i = 0; i < d; ++i)
+      w_expected += u(i) * grad_H.block(0, i * d, d, d) * v;
+    EXPECT_LT((w_expected - w).lpNorm<Eigen::Infinity>(), 1e-10);
+
+    EXPECT_LT((g - p.gradient()).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  }
+
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T>
+class banded_arrow_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    std::vector<T> y(x.data(), x.data() + x.size());
+
+    // A tridiagonal band and a dense last row and column
+    T sum = 0.0;
+    for (std::size_t n = 0; n + 2 < y.size(); ++n)
+      sum += exp(0.5 * y[n] * y[n + 1]) + square(y[n]) * y[y.size() - 1];
+    return sum + log(1.0 + square(y[y.size() - 1]));
+  }
+  static std::string name() { return "banded_arrow"; }
+};
+
+TEST(Autodiff, SparseHessian) {
+
+  const nomad::eigen_idx_t d = 40;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(d, -0.75, 1.25);
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  nomad::hessian(banded_arrow_func<nomad::var2>(), x, f, g, H);
+
+  nomad::hessian_pattern p = nomad::hessian_sparsity(banded_arrow_func<nomad::var2>(), x);
+
+  // Star colorings of a band plus an arrow need only a handful of colors
+  std::vector<nomad::nomad_idx_t> colors;
+  EXPECT_GE(5u, nomad::star_coloring(p, colors));
+
+  double f_sparse;
+  Eigen::VectorXd g_sparse(d);
+  Eigen::SparseMatrix<double> H_sparse;
+  nomad::sparse_hessian(banded_arrow_func<nomad::var2>(), x, p, f_sparse, g_sparse, H_sparse);
+
+  EXPECT_EQ(f, f_sparse);
+  EXPECT_LT((g - g_sparse).lpNorm<Eigen::Infinity>(), 1e-12);
+  EXPECT_LT((H - Eigen::MatrixXd(H_sparse)).lpNorm<Eigen::Infinity>(), 1e-10);
+  EXPECT_EQ(p.nonzeros(), static_cast<nomad::nomad_idx_t>(H_sparse.nonZeros()));
+
+  nomad::sparse_hessian(banded_arrow_func<nomad::var3>(), x, H_sparse);
+  EXPECT_LT((H - Eigen::MatrixXd(H_sparse)).lpNorm<Eigen::Infinity>(), 1e-10);
+
+  nomad::hessian_pattern too_small = nomad::hessian_sparsity(banded_arrow_func<nomad::var2>(), x.head(d - 1));
+  EXPECT_THROW(nomad::sparse_hessian(banded_arrow_func<nomad::var2>(), x, too_small, H_sparse),
+               nomad::nomad_error);
+
+}
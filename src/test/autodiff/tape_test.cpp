@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/matrix/functions.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T>
+class straight_line_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    Eigen::Matrix<T, Eigen::Dynamic, 1> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+
+    T z = exp(y[0] * y[1]) + pow(y[2], 2.5) - pow(1.5, y[3]) + 2.0 * sin(y[4]) / y[2];
+    z += log_sum_exp(y[0], 0.5) * atan2(y[1], y[3]) - fma(y[0], y[1], y[2]);
+    z *= 0.75;
+    z -= hypot(3.0, y[4]) + square(y[1] - 1.0) + inv_logit(-y[0]);
+    ++z;
+
+    T w = y[3];
+    w /= 2.0;
+    return z + w++ + dot(y, y) + sum(y) + log1p_exp(y[4]);
+  }
+  static std::string name() { return "straight_line"; }
+};
+
+// Control flow that depends on the inputs
+template <typename T>
+class branching_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    Eigen::Matrix<T, Eigen::Dynamic, 1> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+
+    T z = fmax(y[0], y[1]) * fmin(y[2], 0.5);
+    if (y[0] < y[2])
+      z += exp(y[0] * y[2]);
+    else
+      z -= square(y[0]);
+    return z;
+  }
+  static std::string name() { return "branching"; }
+};
+
+// A node created outside of the library functions, which cannot be replayed
+template <typename T>
+class opaque_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    Eigen::Matrix<T, Eigen::Dynamic, 1> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+    T z = y[0] * y[1];
+
+    nomad::create_node<nomad::var_node<T::order(), 1>>(1);
+    nomad::push_dual_numbers<T::order(), false>(3.0 * z.first_val());
+    nomad::push_inputs(z.dual_numbers());
+    nomad::push_partials<false>(3.0);
+
+    return exp(T(nomad::next_node_idx_ - 1));
+  }
+  static std::string name() { return "opaque"; }
+};
+
+TEST(Autodiff, TapeReplay) {
+
+  const nomad::eigen_idx_t d = 5;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(d, 0.25, 1.25);
+
+  nomad::tape<nomad::var2> t;
+  t.record(straight_line_func<nomad::var2>(), x);
+  EXPECT_TRUE(t.replayable());
+
+  for (int r = 0; r < 3; ++r) {
+
+    Eigen::VectorXd x_new = x + 0.1 * r * Eigen::VectorXd::Ones(d);
+
+    double f;
+    Eigen::VectorXd g(d);
+    Eigen::MatrixXd H(d, d);
+    nomad::hessian(straight_line_func<nomad::var2>(), x_new, f, g, H);
+
+    double f_tape;
+    Eigen::VectorXd g_tape(d);
+    nomad::gradient(t, x_new, f_tape, g_tape);
+    EXPECT_EQ(f, f_tape);
+    EXPECT_LT((g - g_tape).lpNorm<Eigen::Infinity>(), 1e-12);
+
+    // Repeated sweeps at the same point start from cleared adjoints
+    Eigen::MatrixXd H_tape(d, d);
+    nomad::hessian(t, x_new, f_tape, g_tape, H_tape);
+    EXPECT_EQ(f, f_tape);
+    EXPECT_LT((g - g_tape).lpNorm<Eigen::Infinity>(), 1e-12);
+    EXPECT_LT((H - H_tape).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  }
+
+  // The tape keeps its graph while other graphs are recorded on the thread
+  Eigen::VectorXd g(d);
+  nomad::gradient(straight_line_func<nomad::var2>(), x, g);
+  nomad::tape<nomad::var1> u;
+  u.record(opaque_func<nomad::var1>(), x);
+  EXPECT_FALSE(u.replayable());
+
+  double f;
+  Eigen::VectorXd g_tape(d);
+  nomad::gradient(t, x, f, g_tape);
+  EXPECT_LT((g - g_tape).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  // Graphs that cannot be replayed are recorded again
+  Eigen::VectorXd x_new = 2 * x;
+  nomad::gradient(u, x_new, f, g_tape);
+  EXPECT_FLOAT_EQ(std::exp(3 * x_new[0] * x_new[1]), f);
+  EXPECT_FLOAT_EQ(3 * x_new[1] * f, g_tape[0]);
+  EXPECT_EQ(0, g_tape[2]);
+
+}
+
+TEST(Autodiff, TapeReplayGuards) {
+
+  Eigen::VectorXd x(3);
+  x << 0.25, 0.5, 0.75;
+
+  typedef nomad::var<1, false, false> nonsmooth_var;
+  nomad::tape<nonsmooth_var> t;
+  t.record(branching_func<nonsmooth_var>(), x);
+  EXPECT_TRUE(t.replayable());
+  EXPECT_EQ(1u, t.recordings());
+
+  Eigen::VectorXd x_same(3);
+  x_same << 0.3, 0.6, 0.7;
+
+  Eigen::VectorXd x_flip(3);
+  x_flip << 0.8, 0.6, 0.25;
+
+  const Eigen::VectorXd points[] = { x_same, x_flip, x_flip, x };
+  const std::size_t recordings[] = { 1, 2, 2, 3 };
+
+  for (int r = 0; r < 4; ++r) {
+
+    double f;
+    Eigen::VectorXd g(3);
+    nomad::gradient(branching_func<nonsmooth_var>(), points[r], f, g);
+
+    double f_tape;
+    Eigen::VectorXd g_tape(3);
+    nomad::gradient(t, points[r], f_tape, g_tape);
+
+    EXPECT_EQ(recordings[r], t.recordings());
+    EXPECT_EQ(f, f_tape);
+    EXPECT_LT((g - g_tape).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  }
+
+}
@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/codegen/emit.hpp>
+#include <src/matrix/functions.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+
+template <typename T, int N>
+class funnel_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    T v = x[0];
+
+    T y[N];
+    for (int n = 0; n < N; ++n)
+      y[n] = x[n + 1];
+
+    T sum_x2 = 0.0;
+
+    for (int n = 0; n < N; ++n)
+      sum_x2 += square(y[n]);
+
+    T p1 = 0.5 * N * v;
+    T p2 = 0.5 * sum_x2 * exp(-v);
+    T p3 = 0.5 * square(v) / 9.0;
+
+    return p1 + p2 + p3;
+  }
+  static std::string name() { return "funnel"; }
+};
+
+template <typename T>
+class matrix_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    nomad::eigen_idx_t N = static_cast<nomad::eigen_idx_t>(std::sqrt(x.size()));
+
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> M(N, N);
+
+    int k = 0;
+    for (nomad::eigen_idx_t i = 0; i < N; ++i)
+      for (nomad::eigen_idx_t j = 0; j < N; ++j)
+        M(i, j) = x(k++);
+
+    return sum(multiply(M, M.transpose()));
+  }
+  static std::string name() { return "matrix"; }
+};
+
+template <typename T>
+class mixed_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    Eigen::Matrix<T, Eigen::Dynamic, 1> y(x.size());
+    for (nomad::eigen_idx_t n = 0; n < x.size(); ++n)
+      y[n] = x[n];
+
+    T z = exp(y[0] * y[1]) + pow(y[2], 2.5) - 2.0 * sin(y[3]) / y[2];
+    z += log1p_exp(y[0]) * atan2(y[1], y[3]) + hypot(y[3], 3.0) + inv_logit(-y[0]);
+    z *= sqrt(y[2]) * tanh(y[1]);
+    z -= log(y[3]) + cos(y[0]) / y[1] + fma(y[0], y[1], y[2]);
+    return z + log_sum_exp(y[0], y[1]) + square(y[1] - 1.0) + erf(y[0]) + dot(y, y);
+  }
+  static std::string name() { return "mixed"; }
+};
+
+#include <src/test/codegen/generated/funnel_grad.hpp>
+#include <src/test/codegen/generated/matrix_grad.hpp>
+#include <src/test/codegen/generated/mixed_grad.hpp>
+
+typedef double (*generated_gradient)(const double*, double*);
+typedef double (*generated_hvp)(const double*, const double*, double*, double*);
+
+template <typename F>
+void test_emitted_source(const F& functional,
+                         const std::string& header,
+                         generated_gradient gradient_source,
+                         generated_hvp hvp_source,
+                         const Eigen::VectorXd& x) {
+
+  SCOPED_TRACE(F::name());
+
+  // The checked-in header is what emit writes for the model today
+  nomad::tape<nomad::var2> t;
+  t.record(functional, x);
+
+  std::ostringstream emitted;
+  const std::string guard = "nomad__src__test__codegen__generated__"
+                            + header.substr(0, header.find('.')) + "_hpp";
+  nomad::codegen::emit(t, emitted, nomad::codegen::function_name(header), true, guard);
+
+  std::string path(__FILE__);
+  path = path.substr(0, path.find_last_of('/') + 1) + "generated/" + header;
+  std::ifstream file(path.c_str());
+  std::stringstream checked_in;
+  checked_in << file.rdbuf();
+  EXPECT_EQ(checked_in.str(), emitted.str());
+
+  const nomad::eigen_idx_t d = x.size();
+
+  for (int r = 0; r < 3; ++r) {
+
+    Eigen::VectorXd x_new = x + 0.1 * r * Eigen::VectorXd::Ones(d);
+
+    double f;
+    Eigen::VectorXd g(d);
+    nomad::gradient(functional, x_new, f, g);
+
+    Eigen::VectorXd g_source(d);
+    EXPECT_FLOAT_EQ(f, gradient_source(x_new.data(), g_source.data()));
+    EXPECT_LT((g - g_source).lpNorm<Eigen::Infinity>(), 1e-10);
+
+    Eigen::MatrixXd H(d, d);
+    nomad::hessian(functional, x_new, f, g, H);
+
+    Eigen::VectorXd v = Eigen::VectorXd::LinSpaced(d, -1, 1 + r);
+    Eigen::VectorXd H_dot_v(d);
+    EXPECT_FLOAT_EQ(f, hvp_source(x_new.data(), v.data(), g_source.data(), H_dot_v.data()));
+    EXPECT_LT((g - g_source).lpNorm<Eigen::Infinity>(), 1e-10);
+    EXPECT_LT((H * v - H_dot_v).lpNorm<Eigen::Infinity>(), 1e-10);
+
+  }
+
+}
+
+TEST(Codegen, EmitStraightLineSource) {
+
+  test_emitted_source(funnel_func<nomad::var2, 10>(), "funnel_grad.hpp",
+                      &funnel_grad, &funnel_grad_hvp,
+                      Eigen::VectorXd::LinSpaced(11, -0.5, 1.5));
+
+  test_emitted_source(matrix_func<nomad::var2>(), "matrix_grad.hpp",
+                      &matrix_grad, &matrix_grad_hvp,
+                      Eigen::VectorXd::LinSpaced(9, -1, 1));
+
+  Eigen::VectorXd x(4);
+  x << 0.25, 0.5, 0.75, 1.25;
+  test_emitted_source(mixed_func<nomad::var2>(), "mixed_grad.hpp",
+                      &mixed_grad, &mixed_grad_hvp, x);
+
+}
+
+TEST(Codegen, EmitRejectsBranchingTapes) {
+
+  typedef nomad::var<1, false, false> nonsmooth_var;
+
+  struct branching_func {
+    nonsmooth_var operator()(const Eigen::VectorXd& x) const {
+      nonsmooth_var y0 = x[0];
+      nonsmooth_var y1 = x[1];
+      return y0 < y1 ? y0 * y1 : exp(y0);
+    }
+  };
+
+  nomad::tape<nonsmooth_var> t;
+  t.record(branching_func(), Eigen::VectorXd::LinSpaced(2, 0, 1));
+
+  std::ostringstream emitted;
+  EXPECT_THROW(nomad::codegen::emit(t, emitted, "branching"), nomad::nomad_error);
+
+}
@@ -0,0 +1,337 @@
+#ifndef nomad__src__test__codegen__generated__funnel_grad_hpp
+#define nomad__src__test__codegen__generated__funnel_grad_hpp
+
+// Generated by nomad::codegen::emit from a recorded tape
+
+#include <cmath>
+#include <limits>
+
+inline double funnel_grad(const double* x, double* g) {
+  const double v1 = x[0];
+  const double v2 = x[1];
+  const double v3 = x[2];
+  const double v4 = x[3];
+  const double v5 = x[4];
+  const double v6 = x[5];
+  const double v7 = x[6];
+  const double v8 = x[7];
+  const double v9 = x[8];
+  const double v10 = x[9];
+  const double v11 = x[10];
+  const double v12 = 0.0;
+  const double v13 = v2 * v2;
+  const double v14 = v12 + v13;
+  const double v15 = v3 * v3;
+  const double v16 = v14 + v15;
+  const double v17 = v4 * v4;
+  const double v18 = v16 + v17;
+  const double v19 = v5 * v5;
+  const double v20 = v18 + v19;
+  const double v21 = v6 * v6;
+  const double v22 = v20 + v21;
+  const double v23 = v7 * v7;
+  const double v24 = v22 + v23;
+  const double v25 = v8 * v8;
+  const double v26 = v24 + v25;
+  const double v27 = v9 * v9;
+  const double v28 = v26 + v27;
+  const double v29 = v10 * v10;
+  const double v30 = v28 + v29;
+  const double v31 = v11 * v11;
+  const double v32 = v30 + v31;
+  const double v33 = 5.0 * v1;
+  const double v34 = -v1;
+  const double v35 = std::exp(v34);
+  const double v36 = 0.5 * v32;
+  const double v37 = v36 * v35;
+  const double v38 = v1 * v1;
+  const double v39 = 0.5 * v38;
+  const double v40 = v39 / 9.0;
+  const double v41 = v33 + v37;
+  const double v42 = v41 + v40;
+  double a42 = 1;
+  double a41 = a42;
+  double a40 = a42;
+  double a33 = a41;
+  double a37 = a41;
+  const double d40_0 = 1 / 9.0;
+  double a39 = a40 * d40_0;
+  const double d39_0 = 0.5;
+  double a38 = a39 * d39_0;
+  const double d38_0 = 2 * v1;
+  double a1 = a38 * d38_0;
+  const double d37_0 = v35;
+  const double d37_1 = v36;
+  double a36 = a37 * d37_0;
+  double a35 = a37 * d37_1;
+  const double d36_0 = 0.5;
+  double a32 = a36 * d36_0;
+  const double d35_0 = v35;
+  double a34 = a35 * d35_0;
+  a1 += -a34;
+  const double d33_0 = 5.0;
+  a1 += a33 * d33_0;
+  double a30 = a32;
+  double a31 = a32;
+  const double d31_0 = 2 * v11;
+  double a11 = a31 * d31_0;
+  double a28 = a30;
+  double a29 = a30;
+  const double d29_0 = 2 * v10;
+  double a10 = a29 * d29_0;
+  double a26 = a28;
+  double a27 = a28;
+  const double d27_0 = 2 * v9;
+  double a9 = a27 * d27_0;
+  double a24 = a26;
+  double a25 = a26;
+  const double d25_0 = 2 * v8;
+  double a8 = a25 * d25_0;
+  double a22 = a24;
+  double a23 = a24;
+  const double d23_0 = 2 * v7;
+  double a7 = a23 * d23_0;
+  double a20 = a22;
+  double a21 = a22;
+  const double d21_0 = 2 * v6;
+  double a6 = a21 * d21_0;
+  double a18 = a20;
+  double a19 = a20;
+  const double d19_0 = 2 * v5;
+  double a5 = a19 * d19_0;
+  double a16 = a18;
+  double a17 = a18;
+  const double d17_0 = 2 * v4;
+  double a4 = a17 * d17_0;
+  double a14 = a16;
+  double a15 = a16;
+  const double d15_0 = 2 * v3;
+  double a3 = a15 * d15_0;
+  double a13 = a14;
+  const double d13_0 = 2 * v2;
+  double a2 = a13 * d13_0;
+  g[0] = a1;
+  g[1] = a2;
+  g[2] = a3;
+  g[3] = a4;
+  g[4] = a5;
+  g[5] = a6;
+  g[6] = a7;
+  g[7] = a8;
+  g[8] = a9;
+  g[9] = a10;
+  g[10] = a11;
+  return v42;
+}
+
+inline double funnel_grad_hvp(const double* x, const double* v, double* g, double* hv) {
+  const double v1 = x[0];
+  const double t1 = v[0];
+  const double v2 = x[1];
+  const double t2 = v[1];
+  const double v3 = x[2];
+  const double t3 = v[2];
+  const double v4 = x[3];
+  const double t4 = v[3];
+  const double v5 = x[4];
+  const double t5 = v[4];
+  const double v6 = x[5];
+  const double t6 = v[5];
+  const double v7 = x[6];
+  const double t7 = v[6];
+  const double v8 = x[7];
+  const double t8 = v[7];
+  const double v9 = x[8];
+  const double t9 = v[8];
+  const double v10 = x[9];
+  const double t10 = v[9];
+  const double v11 = x[10];
+  const double t11 = v[10];
+  const double v12 = 0.0;
+  const double v13 = v2 * v2;
+  const double d13_0 = 2 * v2;
+  const double t13 = t2 * d13_0;
+  const double v14 = v12 + v13;
+  const double t14 = t13;
+  const double v15 = v3 * v3;
+  const double d15_0 = 2 * v3;
+  const double t15 = t3 * d15_0;
+  const double v16 = v14 + v15;
+  const double t16 = t14 + t15;
+  const double v17 = v4 * v4;
+  const double d17_0 = 2 * v4;
+  const double t17 = t4 * d17_0;
+  const double v18 = v16 + v17;
+  const double t18 = t16 + t17;
+  const double v19 = v5 * v5;
+  const double d19_0 = 2 * v5;
+  const double t19 = t5 * d19_0;
+  const double v20 = v18 + v19;
+  const double t20 = t18 + t19;
+  const double v21 = v6 * v6;
+  const double d21_0 = 2 * v6;
+  const double t21 = t6 * d21_0;
+  const double v22 = v20 + v21;
+  const double t22 = t20 + t21;
+  const double v23 = v7 * v7;
+  const double d23_0 = 2 * v7;
+  const double t23 = t7 * d23_0;
+  const double v24 = v22 + v23;
+  const double t24 = t22 + t23;
+  const double v25 = v8 * v8;
+  const double d25_0 = 2 * v8;
+  const double t25 = t8 * d25_0;
+  const double v26 = v24 + v25;
+  const double t26 = t24 + t25;
+  const double v27 = v9 * v9;
+  const double d27_0 = 2 * v9;
+  const double t27 = t9 * d27_0;
+  const double v28 = v26 + v27;
+  const double t28 = t26 + t27;
+  const double v29 = v10 * v10;
+  const double d29_0 = 2 * v10;
+  const double t29 = t10 * d29_0;
+  const double v30 = v28 + v29;
+  const double t30 = t28 + t29;
+  const double v31 = v11 * v11;
+  const double d31_0 = 2 * v11;
+  const double t31 = t11 * d31_0;
+  const double v32 = v30 + v31;
+  const double t32 = t30 + t31;
+  const double v33 = 5.0 * v1;
+  const double d33_0 = 5.0;
+  const double v34 = -v1;
+  const double t34 = -t1;
+  const double v35 = std::exp(v34);
+  const double d35_0 = v35;
+  const double t35 = t34 * d35_0;
+  const double v36 = 0.5 * v32;
+  const double d36_0 = 0.5;
+  const double t36 = t32 * d36_0;
+  const double v37 = v36 * v35;
+  const double d37_0 = v35;
+  const double d37_1 = v36;
+  const double v38 = v1 * v1;
+  const double d38_0 = 2 * v1;
+  const double v39 = 0.5 * v38;
+  const double d39_0 = 0.5;
+  const double v40 = v39 / 9.0;
+  const double d40_0 = 1 / 9.0;
+  const double v41 = v33 + v37;
+  const double v42 = v41 + v40;
+  double a42 = 1;
+  double a41 = a42;
+  double a40 = a42;
+  double a33 = a41;
+  double a37 = a41;
+  double a39 = a40 * d40_0;
+  double a38 = a39 * d39_0;
+  const double h38_0 = 2;
+  double a1 = a38 * d38_0;
+  double b1 = a38 * (t1 * h38_0);
+  double a36 = a37 * d37_0;
+  double b36 = a37 * (t35);
+  double a35 = a37 * d37_1;
+  double b35 = a37 * (t36);
+  double a32 = a36 * d36_0;
+  double b32 = b36 * d36_0;
+  const double h35_0 = v35;
+  double a34 = a35 * d35_0;
+  double b34 = b35 * d35_0 + a35 * (t34 * h35_0);
+  a1 += -a34;
+  b1 += -b34;
+  a1 += a33 * d33_0;
+  double a30 = a32;
+  double b30 = b32;
+  double a31 = a32;
+  double b31 = b32;
+  const double h31_0 = 2;
+  double a11 = a31 * d31_0;
+  double b11 = b31 * d31_0 + a31 * (t11 * h31_0);
+  double a28 = a30;
+  double b28 = b30;
+  double a29 = a30;
+  double b29 = b30;
+  const double h29_0 = 2;
+  double a10 = a29 * d29_0;
+  double b10 = b29 * d29_0 + a29 * (t10 * h29_0);
+  double a26 = a28;
+  double b26 = b28;
+  double a27 = a28;
+  double b27 = b28;
+  const double h27_0 = 2;
+  double a9 = a27 * d27_0;
+  double b9 = b27 * d27_0 + a27 * (t9 * h27_0);
+  double a24 = a26;
+  double b24 = b26;
+  double a25 = a26;
+  double b25 = b26;
+  const double h25_0 = 2;
+  double a8 = a25 * d25_0;
+  double b8 = b25 * d25_0 + a25 * (t8 * h25_0);
+  double a22 = a24;
+  double b22 = b24;
+  double a23 = a24;
+  double b23 = b24;
+  const double h23_0 = 2;
+  double a7 = a23 * d23_0;
+  double b7 = b23 * d23_0 + a23 * (t7 * h23_0);
+  double a20 = a22;
+  double b20 = b22;
+  double a21 = a22;
+  double b21 = b22;
+  const double h21_0 = 2;
+  double a6 = a21 * d21_0;
+  double b6 = b21 * d21_0 + a21 * (t6 * h21_0);
+  double a18 = a20;
+  double b18 = b20;
+  double a19 = a20;
+  double b19 = b20;
+  const double h19_0 = 2;
+  double a5 = a19 * d19_0;
+  double b5 = b19 * d19_0 + a19 * (t5 * h19_0);
+  double a16 = a18;
+  double b16 = b18;
+  double a17 = a18;
+  double b17 = b18;
+  const double h17_0 = 2;
+  double a4 = a17 * d17_0;
+  double b4 = b17 * d17_0 + a17 * (t4 * h17_0);
+  double a14 = a16;
+  double b14 = b16;
+  double a15 = a16;
+  double b15 = b16;
+  const double h15_0 = 2;
+  double a3 = a15 * d15_0;
+  double b3 = b15 * d15_0 + a15 * (t3 * h15_0);
+  double a13 = a14;
+  double b13 = b14;
+  const double h13_0 = 2;
+  double a2 = a13 * d13_0;
+  double b2 = b13 * d13_0 + a13 * (t2 * h13_0);
+  g[0] = a1;
+  g[1] = a2;
+  g[2] = a3;
+  g[3] = a4;
+  g[4] = a5;
+  g[5] = a6;
+  g[6] = a7;
+  g[7] = a8;
+  g[8] = a9;
+  g[9] = a10;
+  g[10] = a11;
+  hv[0] = b1;
+  hv[1] = b2;
+  hv[2] = b3;
+  hv[3] = b4;
+  hv[4] = b5;
+  hv[5] = b6;
+  hv[6] = b7;
+  hv[7] = b8;
+  hv[8] = b9;
+  hv[9] = b10;
+  hv[10] = b11;
+  return v42;
+}
+
+#endif
@@ -0,0 +1,273 @@
+#ifndef nomad__src__test__codegen__generated__matrix_grad_hpp
+#define nomad__src__test__codegen__generated__matrix_grad_hpp
+
+// Generated by nomad::codegen::emit from a recorded tape
+
+#include <cmath>
+#include <limits>
+
+inline double matrix_grad(const double* x, double* g) {
+  const double v1 = x[0];
+  const double v2 = x[1];
+  const double v3 = x[2];
+  const double v4 = x[3];
+  const double v5 = x[4];
+  const double v6 = x[5];
+  const double v7 = x[6];
+  const double v8 = x[7];
+  const double v9 = x[8];
+  const double v10 = v1 * v1 + v2 * v2 + v3 * v3;
+  const double v11 = v1 * v4 + v2 * v5 + v3 * v6;
+  const double v12 = v1 * v7 + v2 * v8 + v3 * v9;
+  const double v13 = v4 * v1 + v5 * v2 + v6 * v3;
+  const double v14 = v4 * v4 + v5 * v5 + v6 * v6;
+  const double v15 = v4 * v7 + v5 * v8 + v6 * v9;
+  const double v16 = v7 * v1 + v8 * v2 + v9 * v3;
+  const double v17 = v7 * v4 + v8 * v5 + v9 * v6;
+  const double v18 = v7 * v7 + v8 * v8 + v9 * v9;
+  const double v19 = v10 + v13 + v16 + v11 + v14 + v17 + v12 + v15 + v18;
+  double a19 = 1;
+  double a10 = a19;
+  double a13 = a19;
+  double a16 = a19;
+  double a11 = a19;
+  double a14 = a19;
+  double a17 = a19;
+  double a12 = a19;
+  double a15 = a19;
+  double a18 = a19;
+  double a7 = a18 * v7;
+  double a8 = a18 * v8;
+  double a9 = a18 * v9;
+  a7 += a18 * v7;
+  a8 += a18 * v8;
+  a9 += a18 * v9;
+  a7 += a17 * v4;
+  a8 += a17 * v5;
+  a9 += a17 * v6;
+  double a4 = a17 * v7;
+  double a5 = a17 * v8;
+  double a6 = a17 * v9;
+  a7 += a16 * v1;
+  a8 += a16 * v2;
+  a9 += a16 * v3;
+  double a1 = a16 * v7;
+  double a2 = a16 * v8;
+  double a3 = a16 * v9;
+  a4 += a15 * v7;
+  a5 += a15 * v8;
+  a6 += a15 * v9;
+  a7 += a15 * v4;
+  a8 += a15 * v5;
+  a9 += a15 * v6;
+  a4 += a14 * v4;
+  a5 += a14 * v5;
+  a6 += a14 * v6;
+  a4 += a14 * v4;
+  a5 += a14 * v5;
+  a6 += a14 * v6;
+  a4 += a13 * v1;
+  a5 += a13 * v2;
+  a6 += a13 * v3;
+  a1 += a13 * v4;
+  a2 += a13 * v5;
+  a3 += a13 * v6;
+  a1 += a12 * v7;
+  a2 += a12 * v8;
+  a3 += a12 * v9;
+  a7 += a12 * v1;
+  a8 += a12 * v2;
+  a9 += a12 * v3;
+  a1 += a11 * v4;
+  a2 += a11 * v5;
+  a3 += a11 * v6;
+  a4 += a11 * v1;
+  a5 += a11 * v2;
+  a6 += a11 * v3;
+  a1 += a10 * v1;
+  a2 += a10 * v2;
+  a3 += a10 * v3;
+  a1 += a10 * v1;
+  a2 += a10 * v2;
+  a3 += a10 * v3;
+  g[0] = a1;
+  g[1] = a2;
+  g[2] = a3;
+  g[3] = a4;
+  g[4] = a5;
+  g[5] = a6;
+  g[6] = a7;
+  g[7] = a8;
+  g[8] = a9;
+  return v19;
+}
+
+inline double matrix_grad_hvp(const double* x, const double* v, double* g, double* hv) {
+  const double v1 = x[0];
+  const double t1 = v[0];
+  const double v2 = x[1];
+  const double t2 = v[1];
+  const double v3 = x[2];
+  const double t3 = v[2];
+  const double v4 = x[3];
+  const double t4 = v[3];
+  const double v5 = x[4];
+  const double t5 = v[4];
+  const double v6 = x[5];
+  const double t6 = v[5];
+  const double v7 = x[6];
+  const double t7 = v[6];
+  const double v8 = x[7];
+  const double t8 = v[7];
+  const double v9 = x[8];
+  const double t9 = v[8];
+  const double v10 = v1 * v1 + v2 * v2 + v3 * v3;
+  const double v11 = v1 * v4 + v2 * v5 + v3 * v6;
+  const double v12 = v1 * v7 + v2 * v8 + v3 * v9;
+  const double v13 = v4 * v1 + v5 * v2 + v6 * v3;
+  const double v14 = v4 * v4 + v5 * v5 + v6 * v6;
+  const double v15 = v4 * v7 + v5 * v8 + v6 * v9;
+  const double v16 = v7 * v1 + v8 * v2 + v9 * v3;
+  const double v17 = v7 * v4 + v8 * v5 + v9 * v6;
+  const double v18 = v7 * v7 + v8 * v8 + v9 * v9;
+  const double v19 = v10 + v13 + v16 + v11 + v14 + v17 + v12 + v15 + v18;
+  double a19 = 1;
+  double a10 = a19;
+  double a13 = a19;
+  double a16 = a19;
+  double a11 = a19;
+  double a14 = a19;
+  double a17 = a19;
+  double a12 = a19;
+  double a15 = a19;
+  double a18 = a19;
+  double a7 = a18 * v7;
+  double b7 = a18 * (t7);
+  double a8 = a18 * v8;
+  double b8 = a18 * (t8);
+  double a9 = a18 * v9;
+  double b9 = a18 * (t9);
+  a7 += a18 * v7;
+  b7 += a18 * (t7);
+  a8 += a18 * v8;
+  b8 += a18 * (t8);
+  a9 += a18 * v9;
+  b9 += a18 * (t9);
+  a7 += a17 * v4;
+  b7 += a17 * (t4);
+  a8 += a17 * v5;
+  b8 += a17 * (t5);
+  a9 += a17 * v6;
+  b9 += a17 * (t6);
+  double a4 = a17 * v7;
+  double b4 = a17 * (t7);
+  double a5 = a17 * v8;
+  double b5 = a17 * (t8);
+  double a6 = a17 * v9;
+  double b6 = a17 * (t9);
+  a7 += a16 * v1;
+  b7 += a16 * (t1);
+  a8 += a16 * v2;
+  b8 += a16 * (t2);
+  a9 += a16 * v3;
+  b9 += a16 * (t3);
+  double a1 = a16 * v7;
+  double b1 = a16 * (t7);
+  double a2 = a16 * v8;
+  double b2 = a16 * (t8);
+  double a3 = a16 * v9;
+  double b3 = a16 * (t9);
+  a4 += a15 * v7;
+  b4 += a15 * (t7);
+  a5 += a15 * v8;
+  b5 += a15 * (t8);
+  a6 += a15 * v9;
+  b6 += a15 * (t9);
+  a7 += a15 * v4;
+  b7 += a15 * (t4);
+  a8 += a15 * v5;
+  b8 += a15 * (t5);
+  a9 += a15 * v6;
+  b9 += a15 * (t6);
+  a4 += a14 * v4;
+  b4 += a14 * (t4);
+  a5 += a14 * v5;
+  b5 += a14 * (t5);
+  a6 += a14 * v6;
+  b6 += a14 * (t6);
+  a4 += a14 * v4;
+  b4 += a14 * (t4);
+  a5 += a14 * v5;
+  b5 += a14 * (t5);
+  a6 += a14 * v6;
+  b6 += a14 * (t6);
+  a4 += a13 * v1;
+  b4 += a13 * (t1);
+  a5 += a13 * v2;
+  b5 += a13 * (t2);
+  a6 += a13 * v3;
+  b6 += a13 * (t3);
+  a1 += a13 * v4;
+  b1 += a13 * (t4);
+  a2 += a13 * v5;
+  b2 += a13 * (t5);
+  a3 += a13 * v6;
+  b3 += a13 * (t6);
+  a1 += a12 * v7;
+  b1 += a12 * (t7);
+  a2 += a12 * v8;
+  b2 += a12 * (t8);
+  a3 += a12 * v9;
+  b3 += a12 * (t9);
+  a7 += a12 * v1;
+  b7 += a12 * (t1);
+  a8 += a12 * v2;
+  b8 += a12 * (t2);
+  a9 += a12 * v3;
+  b9 += a12 * (t3);
+  a1 += a11 * v4;
+  b1 += a11 * (t4);
+  a2 += a11 * v5;
+  b2 += a11 * (t5);
+  a3 += a11 * v6;
+  b3 += a11 * (t6);
+  a4 += a11 * v1;
+  b4 += a11 * (t1);
+  a5 += a11 * v2;
+  b5 += a11 * (t2);
+  a6 += a11 * v3;
+  b6 += a11 * (t3);
+  a1 += a10 * v1;
+  b1 += a10 * (t1);
+  a2 += a10 * v2;
+  b2 += a10 * (t2);
+  a3 += a10 * v3;
+  b3 += a10 * (t3);
+  a1 += a10 * v1;
+  b1 += a10 * (t1);
+  a2 += a10 * v2;
+  b2 += a10 * (t2);
+  a3 += a10 * v3;
+  b3 += a10 * (t3);
+  g[0] = a1;
+  g[1] = a2;
+  g[2] = a3;
+  g[3] = a4;
+  g[4] = a5;
+  g[5] = a6;
+  g[6] = a7;
+  g[7] = a8;
+  g[8] = a9;
+  hv[0] = b1;
+  hv[1] = b2;
+  hv[2] = b3;
+  hv[3] = b4;
+  hv[4] = b5;
+  hv[5] = b6;
+  hv[6] = b7;
+  hv[7] = b8;
+  hv[8] = b9;
+  return v19;
+}
+
+#endif
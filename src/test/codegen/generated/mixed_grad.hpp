@@ -0,0 +1,406 @@
+#ifndef nomad__src__test__codegen__generated__mixed_grad_hpp
+#define nomad__src__test__codegen__generated__mixed_grad_hpp
+
+// Generated by nomad::codegen::emit from a recorded tape
+
+#include <cmath>
+#include <limits>
+
+inline double mixed_grad(const double* x, double* g) {
+  const double v1 = x[0];
+  const double v2 = x[1];
+  const double v3 = x[2];
+  const double v4 = x[3];
+  const double v5 = std::sin(v4);
+  const double v6 = 2.0 * v5;
+  const double v7 = v6 / v3;
+  const double v8 = std::pow(v3, 2.5);
+  const double v9 = v1 * v2;
+  const double v10 = std::exp(v9);
+  const double v11 = v10 + v8;
+  const double v12 = v11 - v7;
+  const double v13 = -v1;
+  const double v14 = (v13 > 0 ? 1 / (1 + std::exp(-v13)) : std::exp(v13) / (1 + std::exp(v13)));
+  const double v15 = std::hypot(v4, 3.0);
+  const double v16 = std::atan2(v2, v4);
+  const double v17 = (v1 > 0 ? v1 + std::log1p(std::exp(-v1)) : std::log1p(std::exp(v1)));
+  const double v18 = v17 * v16;
+  const double v19 = v18 + v15;
+  const double v20 = v19 + v14;
+  const double v21 = v12 + v20;
+  const double v22 = std::tanh(v2);
+  const double v23 = std::sqrt(v3);
+  const double v24 = v23 * v22;
+  const double v25 = v21 * v24;
+  const double v26 = v1 * v2 + v3;
+  const double v27 = std::cos(v1);
+  const double v28 = v27 / v2;
+  const double v29 = std::log(v4);
+  const double v30 = v29 + v28;
+  const double v31 = v30 + v26;
+  const double v32 = v25 - v31;
+  const double v33 = v1 * v1 + v2 * v2 + v3 * v3 + v4 * v4;
+  const double v34 = std::erf(v1);
+  const double v35 = v2 - 1.0;
+  const double v36 = v35 * v35;
+  const double v37 = (v1 > v2 ? v1 + std::log(std::exp(v2 - v1) + 1) : v2 + std::log(std::exp(v1 - v2) + 1));
+  const double v38 = v32 + v37;
+  const double v39 = v38 + v36;
+  const double v40 = v39 + v34;
+  const double v41 = v40 + v33;
+  double a41 = 1;
+  double a40 = a41;
+  double a33 = a41;
+  double a39 = a40;
+  double a34 = a40;
+  double a38 = a39;
+  double a36 = a39;
+  double a32 = a38;
+  double a37 = a38;
+  const double d37_0 = std::exp(v1 - v37);
+  const double d37_1 = std::exp(v2 - v37);
+  double a1 = a37 * d37_0;
+  double a2 = a37 * d37_1;
+  const double d36_0 = 2 * v35;
+  double a35 = a36 * d36_0;
+  a2 += a35;
+  const double d34_0 = 1.1283791670955126 * std::exp(-v1 * v1);
+  a1 += a34 * d34_0;
+  a1 += a33 * v1;
+  a2 += a33 * v2;
+  double a3 = a33 * v3;
+  double a4 = a33 * v4;
+  a1 += a33 * v1;
+  a2 += a33 * v2;
+  a3 += a33 * v3;
+  a4 += a33 * v4;
+  double a25 = a32;
+  double a31 = -a32;
+  double a30 = a31;
+  double a26 = a31;
+  double a29 = a30;
+  double a28 = a30;
+  const double d29_0 = 1 / v4;
+  a4 += a29 * d29_0;
+  const double d28_0 = 1 / v2;
+  const double d28_1 = -v28 / v2;
+  double a27 = a28 * d28_0;
+  a2 += a28 * d28_1;
+  const double d27_0 = -std::sin(v1);
+  a1 += a27 * d27_0;
+  const double d26_0 = v2;
+  const double d26_1 = v1;
+  a1 += a26 * d26_0;
+  a2 += a26 * d26_1;
+  a3 += a26;
+  const double d25_0 = v24;
+  const double d25_1 = v21;
+  double a21 = a25 * d25_0;
+  double a24 = a25 * d25_1;
+  const double d24_0 = v22;
+  const double d24_1 = v23;
+  double a23 = a24 * d24_0;
+  double a22 = a24 * d24_1;
+  const double d23_0 = 0.5 / v23;
+  a3 += a23 * d23_0;
+  const double d22_0 = 1 - v22 * v22;
+  a2 += a22 * d22_0;
+  double a12 = a21;
+  double a20 = a21;
+  double a19 = a20;
+  double a14 = a20;
+  double a18 = a19;
+  double a15 = a19;
+  const double d18_0 = v16;
+  const double d18_1 = v17;
+  double a17 = a18 * d18_0;
+  double a16 = a18 * d18_1;
+  const double d17_0 = 1 / (1 + std::exp(-v1));
+  a1 += a17 * d17_0;
+  const double d16_0 = v4 / (v2 * v2 + v4 * v4);
+  const double d16_1 = -v2 / (v2 * v2 + v4 * v4);
+  a2 += a16 * d16_0;
+  a4 += a16 * d16_1;
+  const double d15_0 = v4 / v15;
+  a4 += a15 * d15_0;
+  const double d14_0 = v14 * (1 - v14);
+  double a13 = a14 * d14_0;
+  a1 += -a13;
+  double a11 = a12;
+  double a7 = -a12;
+  double a10 = a11;
+  double a8 = a11;
+  const double d10_0 = v10;
+  double a9 = a10 * d10_0;
+  const double d9_0 = v2;
+  const double d9_1 = v1;
+  a1 += a9 * d9_0;
+  a2 += a9 * d9_1;
+  const double d8_0 = 2.5 * v8 / v3;
+  a3 += a8 * d8_0;
+  const double d7_0 = 1 / v3;
+  const double d7_1 = -v7 / v3;
+  double a6 = a7 * d7_0;
+  a3 += a7 * d7_1;
+  const double d6_0 = 2.0;
+  double a5 = a6 * d6_0;
+  const double d5_0 = std::cos(v4);
+  a4 += a5 * d5_0;
+  g[0] = a1;
+  g[1] = a2;
+  g[2] = a3;
+  g[3] = a4;
+  return v41;
+}
+
+inline double mixed_grad_hvp(const double* x, const double* v, double* g, double* hv) {
+  const double v1 = x[0];
+  const double t1 = v[0];
+  const double v2 = x[1];
+  const double t2 = v[1];
+  const double v3 = x[2];
+  const double t3 = v[2];
+  const double v4 = x[3];
+  const double t4 = v[3];
+  const double v5 = std::sin(v4);
+  const double d5_0 = std::cos(v4);
+  const double t5 = t4 * d5_0;
+  const double v6 = 2.0 * v5;
+  const double d6_0 = 2.0;
+  const double t6 = t5 * d6_0;
+  const double v7 = v6 / v3;
+  const double d7_0 = 1 / v3;
+  const double d7_1 = -v7 / v3;
+  const double t7 = t6 * d7_0 + t3 * d7_1;
+  const double v8 = std::pow(v3, 2.5);
+  const double d8_0 = 2.5 * v8 / v3;
+  const double t8 = t3 * d8_0;
+  const double v9 = v1 * v2;
+  const double d9_0 = v2;
+  const double d9_1 = v1;
+  const double t9 = t1 * d9_0 + t2 * d9_1;
+  const double v10 = std::exp(v9);
+  const double d10_0 = v10;
+  const double t10 = t9 * d10_0;
+  const double v11 = v10 + v8;
+  const double t11 = t10 + t8;
+  const double v12 = v11 - v7;
+  const double t12 = t11 - t7;
+  const double v13 = -v1;
+  const double t13 = -t1;
+  const double v14 = (v13 > 0 ? 1 / (1 + std::exp(-v13)) : std::exp(v13) / (1 + std::exp(v13)));
+  const double d14_0 = v14 * (1 - v14);
+  const double t14 = t13 * d14_0;
+  const double v15 = std::hypot(v4, 3.0);
+  const double d15_0 = v4 / v15;
+  const double t15 = t4 * d15_0;
+  const double v16 = std::atan2(v2, v4);
+  const double d16_0 = v4 / (v2 * v2 + v4 * v4);
+  const double d16_1 = -v2 / (v2 * v2 + v4 * v4);
+  const double t16 = t2 * d16_0 + t4 * d16_1;
+  const double v17 = (v1 > 0 ? v1 + std::log1p(std::exp(-v1)) : std::log1p(std::exp(v1)));
+  const double d17_0 = 1 / (1 + std::exp(-v1));
+  const double t17 = t1 * d17_0;
+  const double v18 = v17 * v16;
+  const double d18_0 = v16;
+  const double d18_1 = v17;
+  const double t18 = t17 * d18_0 + t16 * d18_1;
+  const double v19 = v18 + v15;
+  const double t19 = t18 + t15;
+  const double v20 = v19 + v14;
+  const double t20 = t19 + t14;
+  const double v21 = v12 + v20;
+  const double t21 = t12 + t20;
+  const double v22 = std::tanh(v2);
+  const double d22_0 = 1 - v22 * v22;
+  const double t22 = t2 * d22_0;
+  const double v23 = std::sqrt(v3);
+  const double d23_0 = 0.5 / v23;
+  const double t23 = t3 * d23_0;
+  const double v24 = v23 * v22;
+  const double d24_0 = v22;
+  const double d24_1 = v23;
+  const double t24 = t23 * d24_0 + t22 * d24_1;
+  const double v25 = v21 * v24;
+  const double d25_0 = v24;
+  const double d25_1 = v21;
+  const double v26 = v1 * v2 + v3;
+  const double d26_0 = v2;
+  const double d26_1 = v1;
+  const double v27 = std::cos(v1);
+  const double d27_0 = -std::sin(v1);
+  const double t27 = t1 * d27_0;
+  const double v28 = v27 / v2;
+  const double d28_0 = 1 / v2;
+  const double d28_1 = -v28 / v2;
+  const double v29 = std::log(v4);
+  const double d29_0 = 1 / v4;
+  const double v30 = v29 + v28;
+  const double v31 = v30 + v26;
+  const double v32 = v25 - v31;
+  const double v33 = v1 * v1 + v2 * v2 + v3 * v3 + v4 * v4;
+  const double v34 = std::erf(v1);
+  const double d34_0 = 1.1283791670955126 * std::exp(-v1 * v1);
+  const double v35 = v2 - 1.0;
+  const double t35 = t2;
+  const double v36 = v35 * v35;
+  const double d36_0 = 2 * v35;
+  const double v37 = (v1 > v2 ? v1 + std::log(std::exp(v2 - v1) + 1) : v2 + std::log(std::exp(v1 - v2) + 1));
+  const double d37_0 = std::exp(v1 - v37);
+  const double d37_1 = std::exp(v2 - v37);
+  const double v38 = v32 + v37;
+  const double v39 = v38 + v36;
+  const double v40 = v39 + v34;
+  const double v41 = v40 + v33;
+  double a41 = 1;
+  double a40 = a41;
+  double a33 = a41;
+  double a39 = a40;
+  double a34 = a40;
+  double a38 = a39;
+  double a36 = a39;
+  double a32 = a38;
+  double a37 = a38;
+  const double h37_0 = std::exp(v1 + v2 - 2 * v37);
+  const double h37_1 = -std::exp(v1 + v2 - 2 * v37);
+  const double h37_2 = std::exp(v1 + v2 - 2 * v37);
+  double a1 = a37 * d37_0;
+  double b1 = a37 * (t1 * h37_0 + t2 * h37_1);
+  double a2 = a37 * d37_1;
+  double b2 = a37 * (t1 * h37_1 + t2 * h37_2);
+  const double h36_0 = 2;
+  double a35 = a36 * d36_0;
+  double b35 = a36 * (t35 * h36_0);
+  a2 += a35;
+  b2 += b35;
+  const double h34_0 = -2.2567583341910252 * v1 * std::exp(-v1 * v1);
+  a1 += a34 * d34_0;
+  b1 += a34 * (t1 * h34_0);
+  a1 += a33 * v1;
+  b1 += a33 * (t1);
+  a2 += a33 * v2;
+  b2 += a33 * (t2);
+  double a3 = a33 * v3;
+  double b3 = a33 * (t3);
+  double a4 = a33 * v4;
+  double b4 = a33 * (t4);
+  a1 += a33 * v1;
+  b1 += a33 * (t1);
+  a2 += a33 * v2;
+  b2 += a33 * (t2);
+  a3 += a33 * v3;
+  b3 += a33 * (t3);
+  a4 += a33 * v4;
+  b4 += a33 * (t4);
+  double a25 = a32;
+  double a31 = -a32;
+  double a30 = a31;
+  double a26 = a31;
+  double a29 = a30;
+  double a28 = a30;
+  const double h29_0 = -1 / (v4 * v4);
+  a4 += a29 * d29_0;
+  b4 += a29 * (t4 * h29_0);
+  const double h28_1 = -1 / (v2 * v2);
+  const double h28_2 = 2 * v28 / (v2 * v2);
+  double a27 = a28 * d28_0;
+  double b27 = a28 * (t2 * h28_1);
+  a2 += a28 * d28_1;
+  b2 += a28 * (t27 * h28_1 + t2 * h28_2);
+  const double h27_0 = -v27;
+  a1 += a27 * d27_0;
+  b1 += b27 * d27_0 + a27 * (t1 * h27_0);
+  a1 += a26 * d26_0;
+  b1 += a26 * (t2);
+  a2 += a26 * d26_1;
+  b2 += a26 * (t1);
+  a3 += a26;
+  double a21 = a25 * d25_0;
+  double b21 = a25 * (t24);
+  double a24 = a25 * d25_1;
+  double b24 = a25 * (t21);
+  double a23 = a24 * d24_0;
+  double b23 = b24 * d24_0 + a24 * (t22);
+  double a22 = a24 * d24_1;
+  double b22 = b24 * d24_1 + a24 * (t23);
+  const double h23_0 = -0.25 / (v23 * v3);
+  a3 += a23 * d23_0;
+  b3 += b23 * d23_0 + a23 * (t3 * h23_0);
+  const double h22_0 = -2 * v22 * (1 - v22 * v22);
+  a2 += a22 * d22_0;
+  b2 += b22 * d22_0 + a22 * (t2 * h22_0);
+  double a12 = a21;
+  double b12 = b21;
+  double a20 = a21;
+  double b20 = b21;
+  double a19 = a20;
+  double b19 = b20;
+  double a14 = a20;
+  double b14 = b20;
+  double a18 = a19;
+  double b18 = b19;
+  double a15 = a19;
+  double b15 = b19;
+  double a17 = a18 * d18_0;
+  double b17 = b18 * d18_0 + a18 * (t16);
+  double a16 = a18 * d18_1;
+  double b16 = b18 * d18_1 + a18 * (t17);
+  const double h17_0 = 1 / ((1 + std::exp(-v1)) * (1 + std::exp(v1)));
+  a1 += a17 * d17_0;
+  b1 += b17 * d17_0 + a17 * (t1 * h17_0);
+  const double h16_0 = -2 * v2 * v4 / ((v2 * v2 + v4 * v4) * (v2 * v2 + v4 * v4));
+  const double h16_1 = (v2 * v2 - v4 * v4) / ((v2 * v2 + v4 * v4) * (v2 * v2 + v4 * v4));
+  const double h16_2 = 2 * v2 * v4 / ((v2 * v2 + v4 * v4) * (v2 * v2 + v4 * v4));
+  a2 += a16 * d16_0;
+  b2 += b16 * d16_0 + a16 * (t2 * h16_0 + t4 * h16_1);
+  a4 += a16 * d16_1;
+  b4 += b16 * d16_1 + a16 * (t2 * h16_1 + t4 * h16_2);
+  const double h15_0 = 3.0 * 3.0 / (v15 * v15 * v15);
+  a4 += a15 * d15_0;
+  b4 += b15 * d15_0 + a15 * (t4 * h15_0);
+  const double h14_0 = v14 * (1 - v14) * (1 - 2 * v14);
+  double a13 = a14 * d14_0;
+  double b13 = b14 * d14_0 + a14 * (t13 * h14_0);
+  a1 += -a13;
+  b1 += -b13;
+  double a11 = a12;
+  double b11 = b12;
+  double a7 = -a12;
+  double b7 = -b12;
+  double a10 = a11;
+  double b10 = b11;
+  double a8 = a11;
+  double b8 = b11;
+  const double h10_0 = v10;
+  double a9 = a10 * d10_0;
+  double b9 = b10 * d10_0 + a10 * (t9 * h10_0);
+  a1 += a9 * d9_0;
+  b1 += b9 * d9_0 + a9 * (t2);
+  a2 += a9 * d9_1;
+  b2 += b9 * d9_1 + a9 * (t1);
+  const double h8_0 = 2.5 * (2.5 - 1) * v8 / (v3 * v3);
+  a3 += a8 * d8_0;
+  b3 += b8 * d8_0 + a8 * (t3 * h8_0);
+  const double h7_1 = -1 / (v3 * v3);
+  const double h7_2 = 2 * v7 / (v3 * v3);
+  double a6 = a7 * d7_0;
+  double b6 = b7 * d7_0 + a7 * (t3 * h7_1);
+  a3 += a7 * d7_1;
+  b3 += b7 * d7_1 + a7 * (t6 * h7_1 + t3 * h7_2);
+  double a5 = a6 * d6_0;
+  double b5 = b6 * d6_0;
+  const double h5_0 = -v5;
+  a4 += a5 * d5_0;
+  b4 += b5 * d5_0 + a5 * (t4 * h5_0);
+  g[0] = a1;
+  g[1] = a2;
+  g[2] = a3;
+  g[3] = a4;
+  hv[0] = b1;
+  hv[1] = b2;
+  hv[2] = b3;
+  hv[3] = b4;
+  return v41;
+}
+
+#endif
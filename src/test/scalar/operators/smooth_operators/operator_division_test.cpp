@@ -71,6 +71,19 @@ public:
   static std::string name() { return "operator_division_dv"; }
 };
 
+// The denominator is not a leaf, so that its own higher-order tangents
+// flow through the third-order sweeps of the quotient
+template <typename T>
+class operator_division_vv_nested_grad_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    T v1 = x[0];
+    T v2 = x[1];
+    return v1 / (v2 * v2);
+  }
+  static std::string name() { return "operator_division_vv_nested"; }
+};
+
 TEST(ScalarSmoothOperators, OperatorDivision) {
 
   nomad::eigen_idx_t d = 2;
@@ -84,6 +97,7 @@ TEST(ScalarSmoothOperators, OperatorDivision) {
   nomad::tests::test_validation<operator_division_dv_eval_func>(x1);
   
   nomad::tests::test_derivatives<operator_division_vv_grad_func>(x1);
+  nomad::tests::test_derivatives<operator_division_vv_nested_grad_func>(x1);
   
   Eigen::VectorXd x2 = Eigen::VectorXd::Ones(1);
   x2 *= 0.576;
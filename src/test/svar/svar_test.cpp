@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+#include <src/svar/autodiff.hpp>
+#include <src/svar/functions.hpp>
+#include <src/svar/operators.hpp>
+
+template <typename T, int N>
+class funnel_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    T v = x[0];
+
+    T y[N];
+    for (int n = 0; n < N; ++n)
+      y[n] = x[n + 1];
+
+    T sum_x2 = 0.0;
+
+    for (int n = 0; n < N; ++n)
+      sum_x2 += square(y[n]);
+
+    T p1 = 0.5 * N * v;
+    T p2 = 0.5 * sum_x2 * exp(-v);
+    T p3 = 0.5 * square(v) / 9.0;
+
+    return p1 + p2 + p3;
+  }
+  static std::string name() { return "funnel"; }
+};
+
+template <typename T>
+class likelihood_term_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    T mu = x[0];
+    T log_sigma = x[1];
+    T alpha = x[2];
+    T beta = x[3];
+
+    T z = (1.5 - mu - alpha * beta) * exp(-log_sigma);
+    T lp = -0.5 * square(z) - log_sigma + log1p_exp(alpha) - inv_logit(beta);
+    lp += lgamma(2.0 + square(alpha)) + atan2(beta, mu) * tanh(mu / beta);
+    lp -= pow(1.0 + square(beta), 1.5) + hypot(alpha, log_sigma) + log_sum_exp(mu, beta);
+
+    if (mu < beta)
+      lp *= sqrt(2.0 + sin(alpha));
+    else
+      lp /= 2.0 - cos(alpha);
+
+    return lp + fmax(alpha, beta) * fabs(mu);
+  }
+  static std::string name() { return "likelihood_term"; }
+};
+
+template <template <typename> class F, typename T_svar>
+void test_svar_drivers(const Eigen::VectorXd& x) {
+
+  typedef nomad::var<2, false, false> nonsmooth_var2;
+  const nomad::eigen_idx_t d = x.size();
+
+  SCOPED_TRACE(F<T_svar>::name());
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  nomad::hessian(F<nonsmooth_var2>(), x, f, g, H);
+
+  double f_static;
+  Eigen::VectorXd g_static(d);
+  nomad::gradient(F<T_svar>(), x, f_static, g_static);
+  EXPECT_FLOAT_EQ(f, f_static);
+  EXPECT_LT((g - g_static).lpNorm<Eigen::Infinity>(), 1e-10);
+
+  Eigen::MatrixXd H_static(d, d);
+  nomad::hessian(F<T_svar>(), x, f_static, g_static, H_static);
+  EXPECT_FLOAT_EQ(f, f_static);
+  EXPECT_LT((g - g_static).lpNorm<Eigen::Infinity>(), 1e-10);
+  EXPECT_LT((H - H_static).lpNorm<Eigen::Infinity>(), 1e-10);
+
+}
+
+template <typename T>
+using funnel_10 = funnel_func<T, 10>;
+
+TEST(Svar, Drivers) {
+
+  test_svar_drivers<funnel_10, nomad::svar<11, 2> >(Eigen::VectorXd::LinSpaced(11, -0.5, 1.5));
+
+  Eigen::VectorXd x(4);
+  x << 0.25, -0.5, 0.75, 1.25;
+  test_svar_drivers<likelihood_term_func, nomad::svar<4, 2> >(x);
+
+  // Branches are taken afresh at every point
+  x << 1.5, -0.5, 0.75, -1.25;
+  test_svar_drivers<likelihood_term_func, nomad::svar<4, 2> >(x);
+
+  double f;
+  Eigen::VectorXd g(4);
+  nomad::gradient(likelihood_term_func<nomad::svar<4, 1> >(), x, f, g);
+
+  Eigen::VectorXd g_var(4);
+  nomad::gradient(likelihood_term_func<nomad::var<1, false, false> >(), x, g_var);
+  EXPECT_LT((g - g_var).lpNorm<Eigen::Infinity>(), 1e-10);
+
+  // Outside of the drivers svars built from doubles are constants
+  nomad::svar<2, 1> c = 3.0;
+  EXPECT_EQ(0, c.grad(0));
+  EXPECT_EQ(0, c.grad(1));
+
+  EXPECT_THROW(nomad::gradient(likelihood_term_func<nomad::svar<4, 1> >(),
+                               Eigen::VectorXd::Ones(3), f, g), nomad::nomad_error);
+
+}
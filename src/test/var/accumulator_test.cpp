@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <sstream>
+#include <string>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/codegen/emit.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+#include <src/var/accumulator.hpp>
+
+// The funnel of main.cpp, with its sums gathered by an accumulator when
+// Accumulate is set
+template <typename T, bool Accumulate>
+class funnel_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    const int N = static_cast<int>(x.size()) - 1;
+
+    T v = x[0];
+
+    Eigen::Matrix<T, Eigen::Dynamic, 1> y(N);
+    for (int n = 0; n < N; ++n)
+      y[n] = x[n + 1];
+
+    T sum_x2;
+
+    if (Accumulate) {
+      nomad::accumulator<T> acc;
+      for (int n = 0; n < N; ++n)
+        acc += square(y[n]);
+      sum_x2 = acc.sum();
+    } else {
+      sum_x2 = 0.0;
+      for (int n = 0; n < N; ++n)
+        sum_x2 += square(y[n]);
+    }
+
+    T p1 = 0.5 * N * v;
+    T p2 = 0.5 * sum_x2 * exp(-v);
+    T p3 = 0.5 * square(v) / 9.0;
+
+    return p1 + p2 + p3;
+  }
+  static std::string name() { return "funnel"; }
+};
+
+// A weighted sum with a constant, gathered by an accumulator when
+// Accumulate is set
+template <typename T, bool Accumulate>
+class combination_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    const nomad::eigen_idx_t d = x.size();
+
+    Eigen::Matrix<T, Eigen::Dynamic, 1> y(d);
+    for (nomad::eigen_idx_t n = 0; n < d; ++n)
+      y[n] = x[n];
+
+    if (Accumulate) {
+      nomad::accumulator<T> acc;
+      for (nomad::eigen_idx_t n = 0; n < d; ++n) {
+        acc.add(0.5 * (n + 1), exp(y[n]) * y[(n + 1) % d]);
+        acc -= sin(y[n]);
+        acc += 0.25;
+      }
+      return acc.sum();
+    }
+
+    T s = 0.0;
+    for (nomad::eigen_idx_t n = 0; n < d; ++n)
+      s = s + 0.5 * (n + 1) * (exp(y[n]) * y[(n + 1) % d]) - sin(y[n]) + 0.25;
+    return s;
+  }
+  static std::string name() { return "combination"; }
+};
+
+template <template <typename, bool> class F>
+void test_accumulator(const Eigen::VectorXd& x) {
+
+  const nomad::eigen_idx_t d = x.size();
+
+  double f;
+  Eigen::VectorXd g(d);
+  nomad::gradient(F<nomad::var1, true>(), x, f, g);
+
+  double f_chain;
+  Eigen::VectorXd g_chain(d);
+  nomad::gradient(F<nomad::var1, false>(), x, f_chain, g_chain);
+
+  EXPECT_FLOAT_EQ(f_chain, f);
+  EXPECT_LT((g_chain - g).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  Eigen::MatrixXd H(d, d);
+  Eigen::MatrixXd H_chain(d, d);
+  nomad::hessian(F<nomad::var2, true>(), x, f, g, H);
+  nomad::hessian(F<nomad::var2, false>(), x, f_chain, g_chain, H_chain);
+  EXPECT_LT((H_chain - H).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  Eigen::MatrixXd grad_H(d, d * d);
+  Eigen::MatrixXd grad_H_chain(d, d * d);
+  nomad::grad_hessian(F<nomad::var3, true>(), x, grad_H);
+  nomad::grad_hessian(F<nomad::var3, false>(), x, grad_H_chain);
+  EXPECT_LT((grad_H_chain - grad_H).lpNorm<Eigen::Infinity>(), 1e-10);
+
+  // Tapes replay the accumulated node at other points
+  nomad::tape<nomad::var2> t;
+  t.record(F<nomad::var2, true>(), x);
+  EXPECT_TRUE(t.replayable());
+
+  Eigen::VectorXd y = x.reverse();
+  nomad::hessian(t, y, f, g, H);
+  nomad::hessian(F<nomad::var2, false>(), y, f_chain, g_chain, H_chain);
+  EXPECT_FLOAT_EQ(f_chain, f);
+  EXPECT_LT((g_chain - g).lpNorm<Eigen::Infinity>(), 1e-12);
+  EXPECT_LT((H_chain - H).lpNorm<Eigen::Infinity>(), 1e-12);
+
+  std::ostringstream emitted;
+  EXPECT_NO_THROW(nomad::codegen::emit(t, emitted, F<nomad::var2, true>::name()));
+
+}
+
+TEST(Var, Accumulator) {
+
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(11, -0.5, 1.5);
+
+  nomad::reset();
+  funnel_func<nomad::var1, false>()(x);
+  const nomad::nomad_idx_t n_chain = nomad::next_node_idx_ - 1;
+  nomad::reset();
+  funnel_func<nomad::var1, true>()(x);
+  const nomad::nomad_idx_t n_accumulated = nomad::next_node_idx_ - 1;
+  nomad::reset();
+
+  // The chain of ten binary sums and its zero leaf are replaced by one
+  // multi_sum node
+  EXPECT_EQ(n_chain - 10, n_accumulated);
+
+  test_accumulator<funnel_func>(x);
+  test_accumulator<combination_func>(Eigen::VectorXd::LinSpaced(5, -0.75, 1.25));
+
+  // Doubles accumulate directly
+  nomad::accumulator<double> acc;
+  acc += 1.5;
+  acc -= 0.5;
+  acc.add(2, 0.25);
+  EXPECT_EQ(1.5, acc.sum());
+
+  // An accumulator without terms reads its constant
+  nomad::accumulator<nomad::var1> empty;
+  empty += 2.5;
+  EXPECT_EQ(2.5, empty.sum().first_val());
+  nomad::reset();
+
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/matrix/functions.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+#include <src/var/simplify.hpp>
+
+// The funnel of main.cpp written naively, recomputing shared terms
+template <typename T>
+class naive_funnel_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    const int N = static_cast<int>(x.size()) - 1;
+
+    T v = x[0];
+
+    Eigen::Matrix<T, Eigen::Dynamic, 1> y(N);
+    for (int n = 0; n < N; ++n)
+      y[n] = x[n + 1];
+
+    T sum_x2 = 0.0;
+
+    for (int n = 0; n < N; ++n)
+      sum_x2 += 0.5 * square(y[n]) * exp(-v);
+
+    T scale = 1.0;
+    T p1 = scale * (0.5 * N * v);
+    T p3 = 0.5 * square(v) / 9.0 + 0.0;
+
+    T c = 2.0;
+    T offset = log(c) * 3.0 - log(c * 1.0);
+
+    return p1 + sum_x2 + p3 * 1.0 + offset + sum(y) - sum(y);
+  }
+  static std::string name() { return "naive_funnel"; }
+};
+
+template <typename T_var>
+nomad::nomad_idx_t recorded_nodes(const Eigen::VectorXd& x) {
+  nomad::reset();
+  naive_funnel_func<T_var>()(x);
+  const nomad::nomad_idx_t n = nomad::next_node_idx_ - 1;
+  nomad::reset();
+  return n;
+}
+
+TEST(Var, SimplifiedRecording) {
+
+  const nomad::eigen_idx_t d = 6;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(d, -0.5, 1.5);
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  nomad::hessian(naive_funnel_func<nomad::var2>(), x, f, g, H);
+
+  const nomad::nomad_idx_t n_nodes = recorded_nodes<nomad::var2>(x);
+
+  {
+    nomad::simplified_recording simplified(d);
+
+    const nomad::nomad_idx_t n_simplified = recorded_nodes<nomad::var2>(x);
+    EXPECT_LT(n_simplified, n_nodes);
+    EXPECT_GT(simplified.n_folded(), 0u);
+    EXPECT_GT(simplified.n_elided(), 0u);
+    EXPECT_GT(simplified.n_merged(), 0u);
+
+    double f_simplified;
+    Eigen::VectorXd g_simplified(d);
+    Eigen::MatrixXd H_simplified(d, d);
+    nomad::hessian(naive_funnel_func<nomad::var2>(), x, f_simplified, g_simplified, H_simplified);
+
+    EXPECT_FLOAT_EQ(f, f_simplified);
+    EXPECT_LT((g - g_simplified).lpNorm<Eigen::Infinity>(), 1e-12);
+    EXPECT_LT((H - H_simplified).lpNorm<Eigen::Infinity>(), 1e-12);
+
+    Eigen::MatrixXd grad_H(d, d * d);
+    nomad::grad_hessian(naive_funnel_func<nomad::var3>(), x, grad_H);
+
+    Eigen::MatrixXd grad_H_plain(d, d * d);
+    {
+      nomad::unsimplified_recording plain;
+      nomad::grad_hessian(naive_funnel_func<nomad::var3>(), x, grad_H_plain);
+    }
+    EXPECT_LT((grad_H - grad_H_plain).lpNorm<Eigen::Infinity>(), 1e-12);
+  }
+
+  EXPECT_EQ(n_nodes, recorded_nodes<nomad::var2>(x));
+
+}
+
+TEST(Var, SimplifiedTapeReplay) {
+
+  const nomad::eigen_idx_t d = 5;
+  Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(d, -0.5, 1.5);
+
+  nomad::simplified_recording simplified(d);
+
+  nomad::tape<nomad::var2> t;
+  t.record(naive_funnel_func<nomad::var2>(), x);
+  EXPECT_TRUE(t.replayable());
+  EXPECT_GT(simplified.n_merged(), 0u);
+
+  Eigen::VectorXd y = Eigen::VectorXd::LinSpaced(d, 1.25, -0.75);
+
+  double f;
+  Eigen::VectorXd g(d);
+  Eigen::MatrixXd H(d, d);
+  nomad::hessian(t, y, f, g, H);
+  EXPECT_EQ(1u, t.recordings());
+
+  double f_plain;
+  Eigen::VectorXd g_plain(d);
+  Eigen::MatrixXd H_plain(d, d);
+  {
+    nomad::unsimplified_recording plain;
+    nomad::hessian(naive_funnel_func<nomad::var2>(), y, f_plain, g_plain, H_plain);
+  }
+
+  EXPECT_FLOAT_EQ(f_plain, f);
+  EXPECT_LT((g_plain - g).lpNorm<Eigen::Infinity>(), 1e-12);
+  EXPECT_LT((H_plain - H).lpNorm<Eigen::Infinity>(), 1e-12);
+
+}
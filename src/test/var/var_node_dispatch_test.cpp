@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include <src/autodiff/autodiff.hpp>
+#include <src/scalar/functions.hpp>
+#include <src/scalar/operators.hpp>
+#include <src/test/finite_difference.hpp>
+
+template <typename T>
+class mixed_func: public nomad::base_functor<T> {
+public:
+  T operator()(const Eigen::VectorXd& x) const {
+    T x1 = x[0];
+    T x2 = x[1];
+    T y = -x1 + x2 * x1 - square(x2) / x1;
+    return exp(y) + (+x2) - x1;
+  }
+  static std::string name() { return "mixed"; }
+};
+
+TEST(Var, NodeRecordSize) {
+  // A vptr-free record of three stack indices and a packed arity and opcode
+  EXPECT_EQ(4 * sizeof(nomad::nomad_idx_t), sizeof(nomad::var_node_base));
+  EXPECT_EQ(sizeof(nomad::var_node_base), sizeof(nomad::var_node<3, 3>));
+  EXPECT_EQ(sizeof(nomad::var_node_base), sizeof(nomad::unary_var_node<3, 3>));
+  EXPECT_EQ(sizeof(nomad::var_node_base), sizeof(nomad::multi_sum_var_node<3>));
+}
+
+TEST(Var, NodeOpcodes) {
+
+  nomad::reset();
+
+  nomad::var2 x1 = 1.5;
+  nomad::var2 x2 = 0.5;
+  nomad::var2 y = x1 + x2;
+  nomad::var2 z = exp(y);
+
+  EXPECT_EQ(nomad::var_node_opcode(nomad::generic_var_node_kind),
+            nomad::var_nodes_[x1.node()].opcode());
+  EXPECT_EQ(nomad::var_node_opcode(nomad::binary_sum_var_node_kind),
+            nomad::var_nodes_[y.node()].opcode());
+  EXPECT_EQ(nomad::var_node_opcode(nomad::unary_var_node_kind, 3),
+            nomad::var_nodes_[z.node()].opcode());
+  EXPECT_EQ(2u, nomad::var_nodes_[y.node()].n_inputs());
+
+  nomad::reset();
+
+}
+
+TEST(Var, NodeDispatch) {
+
+  // Every node kind in the graph is swept through the opcode switch
+  Eigen::VectorXd x(2);
+  x << 1.25, -0.75;
+
+  nomad::tests::test_derivatives<mixed_func>(x);
+
+}
+
+TEST(Var, NodeUnknownOpcode) {
+
+  nomad::reset();
+
+  nomad::var1 x1 = 1.5;
+  nomad::var1 y = exp(x1);
+
+  // A node whose opcode names no kind is refused rather than skipped
+  nomad::var_node_base& node = nomad::var_nodes_[y.node()];
+  node.relocate(node, node.dual_numbers(), node.partials(), node.inputs(), 0xff, node.n_inputs());
+
+  EXPECT_THROW(nomad::first_order_reverse_adj(y), nomad::nomad_error);
+
+  nomad::reset();
+
+}
@@ -0,0 +1,175 @@
+#ifndef nomad__src__var__accumulator_hpp
+#define nomad__src__var__accumulator_hpp
+
+#include <vector>
+
+#include <src/var/var.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/simplify.hpp>
+#include <src/var/derived/multi_sum_var_node.hpp>
+#include <src/matrix/functions/sum.hpp>
+#include <src/scalar/operators/smooth_operators/operator_addition.hpp>
+#include <src/scalar/operators/smooth_operators/operator_multiplication.hpp>
+#include <src/autodiff/validation.hpp>
+
+namespace nomad {
+
+  template<short AutodiffOrder, bool ValidateIO>
+  void replay_linear_combination(const replay_entry& entry) {
+    var_node_base& node = var_nodes_[entry.node];
+
+    double sum = 0;
+
+    for (nomad_idx_t n = 0; n < node.n_inputs(); ++n)
+      sum += node.first_partials(n) * var_node_base::first_val(node.input(n));
+
+    rewind_stacks(entry.node);
+    push_dual_numbers<AutodiffOrder, ValidateIO>(sum);
+  }
+
+  // Collects the terms of a sum and adds them all at once, so that a loop
+  // such as
+  //
+  //   accumulator<T> lp;
+  //   for (int n = 0; n < N; ++n) lp += square(y[n]);
+  //   return lp.sum();
+  //
+  // records a single node in place of a chain of N binary sums.
+  template <typename T>
+  class accumulator {
+  public:
+
+    accumulator(): sum_(0) {}
+
+    accumulator& operator+=(const T& x) { sum_ += x; return *this; }
+    accumulator& operator-=(const T& x) { sum_ -= x; return *this; }
+
+    // Adds the term w * x
+    accumulator& add(double w, const T& x) { sum_ += w * x; return *this; }
+
+    T sum() const { return sum_; }
+
+  private:
+    T sum_;
+  };
+
+  // For vars the terms are buffered and read by a single node: a sum when
+  // every weight is one, and otherwise a linear combination whose weights
+  // are stored as its partials.  Doubles are gathered into one constant.
+  // Each call to sum() records a new node.
+  template <short AutodiffOrder, bool StrictSmoothness, bool ValidateIO>
+  class accumulator<var<AutodiffOrder, StrictSmoothness, ValidateIO>> {
+  public:
+
+    typedef var<AutodiffOrder, StrictSmoothness, ValidateIO> var_type;
+
+    accumulator(): constant_(0), weighted_(false) {}
+
+    accumulator& operator+=(const var_type& x) { return add(1, x); }
+    accumulator& operator-=(const var_type& x) { return add(-1, x); }
+
+    accumulator& operator+=(double x) {
+      if (ValidateIO) validate_input(x, "accumulator");
+      constant_ += x;
+      return *this;
+    }
+
+    accumulator& operator-=(double x) { return *this += -x; }
+
+    // Adds the term w * x
+    accumulator& add(double w, const var_type& x) {
+      if (ValidateIO) {
+        validate_input(w, "accumulator");
+        validate_input(x.first_val(), "accumulator");
+      }
+      terms_.push_back(x.node());
+      weights_.push_back(w);
+      if (w != 1) weighted_ = true;
+      return *this;
+    }
+
+    var_type sum() const {
+
+      if (terms_.empty()) return var_type(constant_);
+
+      var_type s = terms_.size() == 1 && !weighted_ ? var_type(terms_[0])
+                   : weighted_ ? combination() : multi_sum();
+
+      return constant_ != 0 ? s + constant_ : s;
+
+    }
+
+  private:
+
+    var_type multi_sum() const {
+
+      const nomad_idx_t n_inputs = static_cast<nomad_idx_t>(terms_.size());
+
+      create_node<multi_sum_var_node<AutodiffOrder>>(n_inputs);
+      record_custom_replay(&replay_sum<AutodiffOrder, ValidateIO>);
+
+      double sum = 0;
+
+      for (nomad_idx_t n = 0; n < n_inputs; ++n)
+        sum += var_nodes_[terms_[n]].first_val();
+
+      try {
+        push_dual_numbers<AutodiffOrder, ValidateIO>(sum);
+      } catch (const nomad_error&) {
+        throw nomad_output_value_error("accumulator");
+      }
+
+      for (nomad_idx_t n = 0; n < n_inputs; ++n)
+        push_inputs(var_nodes_[terms_[n]].dual_numbers());
+
+      return var_type(commit_node<AutodiffOrder>());
+
+    }
+
+    var_type combination() const {
+
+      // Without partials the weights could not be replayed, so at zeroth
+      // order the terms are added one at a time
+      if (AutodiffOrder == 0) {
+        var_type s = weights_[0] * var_type(terms_[0]);
+        for (std::size_t n = 1; n < terms_.size(); ++n)
+          s = s + weights_[n] * var_type(terms_[n]);
+        return s;
+      }
+
+      const nomad_idx_t n_inputs = static_cast<nomad_idx_t>(terms_.size());
+
+      create_node<var_node<AutodiffOrder, 1>>(n_inputs);
+      record_custom_replay(&replay_linear_combination<AutodiffOrder, ValidateIO>);
+
+      double sum = 0;
+
+      for (nomad_idx_t n = 0; n < n_inputs; ++n)
+        sum += weights_[n] * var_nodes_[terms_[n]].first_val();
+
+      try {
+        push_dual_numbers<AutodiffOrder, ValidateIO>(sum);
+      } catch (const nomad_error&) {
+        throw nomad_output_value_error("accumulator");
+      }
+
+      for (nomad_idx_t n = 0; n < n_inputs; ++n)
+        push_inputs(var_nodes_[terms_[n]].dual_numbers());
+
+      for (nomad_idx_t n = 0; n < n_inputs; ++n)
+        push_partials<ValidateIO>(weights_[n]);
+
+      return var_type(commit_node<AutodiffOrder>());
+
+    }
+
+    std::vector<nomad_idx_t> terms_;
+    std::vector<double> weights_;
+    double constant_;
+    bool weighted_;
+
+  };
+
+}
+
+#endif
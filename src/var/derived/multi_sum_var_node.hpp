@@ -10,7 +10,7 @@ namespace nomad {
   public:
     
     static inline void* operator new(size_t /* ignore */) {
-      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes<AutodiffOrder>();
+      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes();
       // no partials
       if (unlikely(next_inputs_idx_ + next_inputs_delta > max_inputs_idx)) expand_inputs();
       return var_nodes_ + next_node_idx_;
@@ -18,13 +18,19 @@ namespace nomad {
     
     static inline void operator delete(void* /* ignore */) {}
     
-    multi_sum_var_node(nomad_idx_t n_inputs): var_node_base(n_inputs) {}
+    multi_sum_var_node(nomad_idx_t n_inputs):
+    var_node_base(n_inputs, var_node_opcode(multi_sum_var_node_kind)) {}
  
     inline nomad_idx_t n_first_partials() { return 0; }
     inline nomad_idx_t n_second_partials() { return 0; }
     inline nomad_idx_t n_third_partials() { return 0; }
     inline static nomad_idx_t n_partials(nomad_idx_t n_inputs) { (void)n_inputs; return 0; }
     
+    template<class F>
+    inline void local_partials(F& f) {
+      for (nomad_idx_t i = 0; i < n_inputs_; ++i) f(i, 1.0);
+    }
+    
     inline void first_order_forward_adj() {
       
       if (AutodiffOrder >= 1) {
@@ -52,71 +58,75 @@ namespace nomad {
       }
     }
     
+    template<class D>
     void second_order_forward_val() {
       
       if (AutodiffOrder >= 2) {
         
-        if (n_inputs_) second_val() = 0;
-        second_grad() = 0;
+        if (n_inputs_) second_val<D>() = 0;
+        second_grad<D>() = 0;
         
-        double v2 = 0;
+        typename D::second_type v2 = 0;
         
         for (nomad_idx_t i = 0; i < n_inputs_; ++i)
-          v2 += second_val(input(i));
-        second_val() += v2;
+          v2 += second_val<D>(input(i));
+        second_val<D>() += v2;
         
       }
       
     }
     
+    template<class D>
     void second_order_reverse_adj() {
       
       if (AutodiffOrder >= 2) {
         
-        const double g2 = second_grad();
+        const typename D::second_type g2 = second_grad<D>();
         
         for (nomad_idx_t i = 0; i < n_inputs_; ++i)
-          second_grad(input(i)) += g2;
+          second_grad<D>(input(i)) += g2;
       }
       
     }
     
+    template<class D>
     void third_order_forward_val() {
       
       if (AutodiffOrder >= 3) {
         
         if (n_inputs_) {
-          third_val() = 0;
-          fourth_val() = 0;
+          third_val<D>() = 0;
+          fourth_val<D>() = 0;
         }
         
-        third_grad() = 0;
-        fourth_grad() = 0;
+        third_grad<D>() = 0;
+        fourth_grad<D>() = 0;
         
-        double v3 = 0;
-        double v4 = 0;
+        typename D::third_type v3 = 0;
+        typename D::third_type v4 = 0;
         
         for (nomad_idx_t i = 0; i < n_inputs_; ++i) {
-          v3 += third_val(input(i));
-          v4 += fourth_val(input(i));
+          v3 += third_val<D>(input(i));
+          v4 += fourth_val<D>(input(i));
         }
-        third_val() = v3;
-        fourth_val() = v4;
+        third_val<D>() = v3;
+        fourth_val<D>() = v4;
         
       }
       
     } // third_order_forward_val
     
+    template<class D>
     void third_order_reverse_adj() {
       
       if (AutodiffOrder >= 3) {
         
-        const double g3 = third_grad();
-        const double g4 = fourth_grad();
+        const typename D::third_type g3 = third_grad<D>();
+        const typename D::third_type g4 = fourth_grad<D>();
         
         for (nomad_idx_t i = 0; i < n_inputs_; ++i) {
-          third_grad(input(i)) += g3;
-          fourth_grad(input(i)) += g4;
+          third_grad<D>(input(i)) += g3;
+          fourth_grad<D>(input(i)) += g4;
         }
         
       }
@@ -10,7 +10,7 @@ namespace nomad {
   public:
     
     static inline void* operator new(size_t /* ignore */) {
-      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes<AutodiffOrder>();
+      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes();
       // no partials
       if (unlikely(next_inputs_idx_ + next_inputs_delta > max_inputs_idx)) expand_inputs();
       return var_nodes_ + next_node_idx_;
@@ -18,7 +18,8 @@ namespace nomad {
     
     static inline void operator delete(void* /* ignore */) {}
     
-    multiply_var_node(): var_node_base(2) {}
+    multiply_var_node():
+    var_node_base(2, var_node_opcode(multiply_var_node_kind)) {}
  
     constexpr static bool dynamic_inputs() { return false; }
     
@@ -28,6 +29,15 @@ namespace nomad {
     inline static nomad_idx_t n_partials() { return 0; }
     inline static nomad_idx_t n_partials(nomad_idx_t n_inputs) { (void)n_inputs; return 0; }
     
+    template<class F>
+    inline void local_partials(F& f) {
+      f(0, first_val(input(1)));
+      f(1, first_val(input()));
+    }
+    
+    template<class F>
+    inline void local_second_partials(F& f) { f(0, 1, 1.0); }
+    
     inline void first_order_forward_adj() {
       if (AutodiffOrder >= 1) {
         first_grad() =   first_grad(input()) * first_val(input(1))
@@ -43,69 +53,73 @@ namespace nomad {
       }
     }
     
+    template<class D>
     void second_order_forward_val() {
       if (AutodiffOrder >= 2) {
-        second_val() =   second_val(input()) * first_val(input(1))
-                       + second_val(input(1)) * first_val(input());
-        second_grad() = 0;
+        second_val<D>() =   second_val<D>(input()) * first_val(input(1))
+                          + second_val<D>(input(1)) * first_val(input());
+        second_grad<D>() = 0;
       }
     }
     
+    template<class D>
     void second_order_reverse_adj() {
       if (AutodiffOrder >= 2) {
         const double g1 = first_grad();
-        const double g2 = second_grad();
-        second_grad(input())  +=   g2 * first_val(input(1))
-                                 + g1 * second_val(input(1));
-        second_grad(input(1)) +=   g2 * first_val(input())
-                                 + g1 * second_val(input());
+        const typename D::second_type g2 = second_grad<D>();
+        second_grad<D>(input())  +=   g2 * first_val(input(1))
+                                    + g1 * second_val<D>(input(1));
+        second_grad<D>(input(1)) +=   g2 * first_val(input())
+                                    + g1 * second_val<D>(input());
       }
     }
     
+    template<class D>
     void third_order_forward_val() {
       
       if (AutodiffOrder >= 3) {
         
-        third_val() = 0;
-        third_grad() = 0;
-        fourth_val() = 0;
-        fourth_grad() = 0;
+        third_val<D>() = 0;
+        third_grad<D>() = 0;
+        fourth_val<D>() = 0;
+        fourth_grad<D>() = 0;
         
-        third_val() +=   third_val(input())  * first_val(input(1))
-                       + third_val(input(1)) * first_val(input());
+        third_val<D>() +=   third_val<D>(input())  * first_val(input(1))
+                          + third_val<D>(input(1)) * first_val(input());
         
-        fourth_val() +=   fourth_val(input())  * first_val(input(1))
-                        + fourth_val(input(1)) * first_val(input())
-                        + third_val(input())   * second_val(input(1))
-                        + second_val(input())  * third_val(input(1));
+        fourth_val<D>() +=   fourth_val<D>(input())  * first_val(input(1))
+                           + fourth_val<D>(input(1)) * first_val(input())
+                           + third_val<D>(input())   * second_val<D>(input(1))
+                           + second_val<D>(input())  * third_val<D>(input(1));
         
       }
       
     } // third_order_forward_val
     
+    template<class D>
     void third_order_reverse_adj() {
       
       if (AutodiffOrder >= 3) {
         
         const double g1 = first_grad();
-        const double g2 = second_grad();
-        const double g3 = third_grad();
-        const double g4 = fourth_grad();
+        const typename D::second_type g2 = second_grad<D>();
+        const typename D::third_type g3 = third_grad<D>();
+        const typename D::third_type g4 = fourth_grad<D>();
         
-        third_grad(input())  +=  g3 * first_val(input(1))
-                               + g1 * third_val(input(1));
-        third_grad(input(1)) +=  g3 * first_val(input())
-                               + g1 * third_val(input());
+        third_grad<D>(input())  +=  g3 * first_val(input(1))
+                                  + g1 * third_val<D>(input(1));
+        third_grad<D>(input(1)) +=  g3 * first_val(input())
+                                  + g1 * third_val<D>(input());
         
-        fourth_grad(input())  +=   g4 * first_val(input(1))
-                                 + g3 * second_val(input(1))
-                                 + g2 * third_val(input(1))
-                                 + g1 * fourth_val(input(1));
+        fourth_grad<D>(input())  +=   g4 * first_val(input(1))
+                                    + g3 * second_val<D>(input(1))
+                                    + g2 * third_val<D>(input(1))
+                                    + g1 * fourth_val<D>(input(1));
         
-        fourth_grad(input(1)) +=   g4 * first_val(input())
-                                 + g3 * second_val(input())
-                                 + g2 * third_val(input())
-                                 + g1 * fourth_val(input());
+        fourth_grad<D>(input(1)) +=   g4 * first_val(input())
+                                    + g3 * second_val<D>(input())
+                                    + g2 * third_val<D>(input())
+                                    + g1 * fourth_val<D>(input());
         
       }
       
@@ -10,7 +10,7 @@ namespace nomad {
   public:
     
     static inline void* operator new(size_t /* ignore */) {
-      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes<AutodiffOrder>();
+      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes();
       // no partials
       if (unlikely(next_inputs_idx_ + next_inputs_delta > max_inputs_idx)) expand_inputs();
       return var_nodes_ + next_node_idx_;
@@ -18,7 +18,8 @@ namespace nomad {
     
     static inline void operator delete(void* /* ignore */) {}
   
-    square_var_node(): var_node_base(1) {}
+    square_var_node():
+    var_node_base(1, var_node_opcode(square_var_node_kind)) {}
     
     constexpr static bool dynamic_inputs() { return false; }
     
@@ -28,6 +29,12 @@ namespace nomad {
     inline static nomad_idx_t n_partials() { return 0; }
     inline static nomad_idx_t n_partials(nomad_idx_t n_inputs) { (void)n_inputs; return 0; }
     
+    template<class F>
+    inline void local_partials(F& f) { f(0, 2 * first_val(input())); }
+    
+    template<class F>
+    inline void local_second_partials(F& f) { f(0, 0, 2.0); }
+    
     inline void first_order_forward_adj() {
       if (AutodiffOrder >= 1) {
         first_grad() = 2 * first_grad(input()) * first_val(input());
@@ -40,42 +47,46 @@ namespace nomad {
       }
     }
     
+    template<class D>
     void second_order_forward_val() {
       if (AutodiffOrder >= 2) {
-        second_grad() = 0;
-        second_val() = 2 * second_val(input()) * first_val(input());
+        second_grad<D>() = 0;
+        second_val<D>() = 2 * second_val<D>(input()) * first_val(input());
       }
     }
     
+    template<class D>
     void second_order_reverse_adj() {
       if (AutodiffOrder >= 2) {
-        second_grad(input()) +=   2 * second_grad() * first_val(input())
-                                + 2 * first_grad() * second_val(input());
+        second_grad<D>(input()) +=   2 * second_grad<D>() * first_val(input())
+                                   + 2 * first_grad() * second_val<D>(input());
       }
     }
     
+    template<class D>
     void third_order_forward_val() {
       if (AutodiffOrder >= 3) {
-        third_grad() = 0;
-        fourth_grad() = 0;
-        third_val()  =   2 * third_val(input()) * first_val(input());
-        fourth_val() =   2 * fourth_val(input()) * first_val(input())
-                       + 2 * third_val(input())  * second_val(input());
+        third_grad<D>() = 0;
+        fourth_grad<D>() = 0;
+        third_val<D>()  =   2 * third_val<D>(input()) * first_val(input());
+        fourth_val<D>() =   2 * fourth_val<D>(input()) * first_val(input())
+                          + 2 * third_val<D>(input())  * second_val<D>(input());
       }
       
     } // third_order_forward_val
     
+    template<class D>
     void third_order_reverse_adj() {
       
       if (AutodiffOrder >= 3) {
         
-        third_grad(input()) +=   2 * third_grad() * first_val(input())
-                               + 2 * first_grad() * third_val(input());
+        third_grad<D>(input()) +=   2 * third_grad<D>() * first_val(input())
+                                  + 2 * first_grad() * third_val<D>(input());
         
-        fourth_grad(input()) +=   2 * fourth_grad() * first_val(input())
-                                + 2 * third_grad()  * second_val(input())
-                                + 2 * second_grad() * third_val(input())
-                                + 2 * first_grad()  * fourth_val(input());
+        fourth_grad<D>(input()) +=   2 * fourth_grad<D>() * first_val(input())
+                                   + 2 * third_grad<D>()  * second_val<D>(input())
+                                   + 2 * second_grad<D>() * third_val<D>(input())
+                                   + 2 * first_grad()  * fourth_val<D>(input());
         
       }
       
@@ -10,7 +10,7 @@ namespace nomad {
   public:
     
     static inline void* operator new(size_t /* ignore */) {
-      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes<AutodiffOrder>();
+      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes();
       // no partials
       if (unlikely(next_inputs_idx_ + next_inputs_delta > max_inputs_idx)) expand_inputs();
       return var_nodes_ + next_node_idx_;
@@ -18,7 +18,8 @@ namespace nomad {
     
     static inline void operator delete(void* /* ignore */) {}
     
-    unary_plus_var_node(): var_node_base(1) {}
+    unary_plus_var_node():
+    var_node_base(1, var_node_opcode(unary_plus_var_node_kind)) {}
 
     constexpr static bool dynamic_inputs() { return false; }
     
@@ -28,6 +29,9 @@ namespace nomad {
     inline static nomad_idx_t n_partials() { return 0; }
     inline static nomad_idx_t n_partials(unsigned int n_inputs) { (void)n_inputs; return 0; }
     
+    template<class F>
+    inline void local_partials(F& f) { f(0, 1.0); }
+    
     inline void first_order_forward_adj() {
       if (AutodiffOrder >= 1)
         first_grad() = first_grad(input());
@@ -37,30 +41,34 @@ namespace nomad {
       if (AutodiffOrder >= 1) first_grad(input()) += first_grad();
     }
     
+    template<class D>
     inline void second_order_forward_val() {
       if (AutodiffOrder >= 2) {
-        second_val() = second_val(input());
-        second_grad() = 0;
+        second_val<D>() = second_val<D>(input());
+        second_grad<D>() = 0;
       }
     }
     
+    template<class D>
     inline void second_order_reverse_adj() {
-      if (AutodiffOrder >= 2) second_grad(input()) += second_grad();
+      if (AutodiffOrder >= 2) second_grad<D>(input()) += second_grad<D>();
     }
     
+    template<class D>
     inline void third_order_forward_val() {
       if (AutodiffOrder >= 3) {
-        third_val() = third_val(input());
-        fourth_val() = fourth_val(input());
-        third_grad() = 0;
-        fourth_grad() = 0;
+        third_val<D>() = third_val<D>(input());
+        fourth_val<D>() = fourth_val<D>(input());
+        third_grad<D>() = 0;
+        fourth_grad<D>() = 0;
       }
     }
     
+    template<class D>
     inline void third_order_reverse_adj() {
       if (AutodiffOrder >= 3) {
-        third_grad(input()) += third_grad();
-        fourth_grad(input()) += fourth_grad();
+        third_grad<D>(input()) += third_grad<D>();
+        fourth_grad<D>(input()) += fourth_grad<D>();
       }
     }
     
@@ -0,0 +1,203 @@
+#ifndef nomad__src__var__replay_hpp
+#define nomad__src__var__replay_hpp
+
+#include <type_traits>
+#include <vector>
+
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/dual_number_layout.hpp>
+#include <src/var/var.hpp>
+#include <src/var/var_node.hpp>
+
+namespace nomad {
+
+  // While a tape records, each var function that creates a node logs how to
+  // create that node again: the function itself, type erased, along with a
+  // thunk that knows its signature and any double arguments it was called
+  // with.  Replaying an entry with the stacks positioned at the node calls
+  // the function on vars bound to the inputs of the node, which overwrites
+  // the value and partials of the node in place and leaves the stacks
+  // positioned at the next node.
+  struct replay_entry {
+    void (*replay)(const replay_entry& entry);
+    void (*function)();
+    nomad_idx_t node;
+    double constants[2];
+  };
+
+  thread_local std::vector<replay_entry>* replay_log_ = 0;
+
+  // Positions the stacks so that the next node created overwrites the given
+  // node, with the same dual numbers, partials, and inputs
+  inline void rewind_stacks(nomad_idx_t node_idx) {
+    var_node_base& node = var_nodes_[node_idx];
+    next_node_idx_ = node_idx;
+    next_dual_number_idx_ = node.dual_numbers();
+    next_partials_idx_ = node.partials();
+    next_inputs_idx_ = node.inputs();
+  }
+
+  // Node feeding the given input of a node
+  template <short AutodiffOrder>
+  inline nomad_idx_t input_node(nomad_idx_t node_idx, nomad_idx_t k) {
+    return dual_number_layout::node_slot<AutodiffOrder>(var_nodes_[node_idx].input(k)) + 1;
+  }
+
+  // Binds the arguments of a replayed call in order, taking vars from the
+  // inputs of the node and everything else from the logged constants
+  template <class V, nomad_idx_t K, nomad_idx_t C, class... Args>
+  struct replay_arguments;
+
+  template <class V, nomad_idx_t K, nomad_idx_t C>
+  struct replay_arguments<V, K, C> {
+    template <class F, class... Bound>
+    static inline void call(F f, const replay_entry& entry, Bound&... bound) {
+      (void)entry;
+      f(bound...);
+    }
+  };
+
+  template <class V, nomad_idx_t K, nomad_idx_t C, class Arg, class... Args>
+  struct replay_arguments<V, K, C, Arg, Args...> {
+
+    typedef typename std::decay<Arg>::type arg_type;
+
+    template <class F, class... Bound>
+    static inline void call(F f, const replay_entry& entry, Bound&... bound) {
+      bind(f, entry, std::is_same<arg_type, V>(), bound...);
+    }
+
+    template <class F, class... Bound>
+    static inline void bind(F f, const replay_entry& entry, std::true_type, Bound&... bound) {
+      V v(input_node<V::order()>(entry.node, K));
+      replay_arguments<V, K + 1, C, Args...>::call(f, entry, bound..., v);
+    }
+
+    template <class F, class... Bound>
+    static inline void bind(F f, const replay_entry& entry, std::false_type, Bound&... bound) {
+      arg_type c = static_cast<arg_type>(entry.constants[C]);
+      replay_arguments<V, K, C + 1, Args...>::call(f, entry, bound..., c);
+    }
+
+  };
+
+  template <class R, class... Args>
+  struct replay_call {
+    typedef R (*function_type)(Args...);
+    static void replay(const replay_entry& entry) {
+      replay_arguments<typename std::decay<R>::type, 0, 0, Args...>::call(
+        reinterpret_cast<function_type>(entry.function), entry);
+    }
+  };
+
+  // Signature of a var function with the given parameters, which returns
+  // its first var parameter by reference when that is modified in place
+  template <class Arg, class... Args>
+  struct replay_signature {
+
+    template <class T, class... Ts>
+    struct first_var {
+      typedef typename std::decay<T>::type decayed;
+      typedef typename std::conditional<is_var<decayed>::value, decayed,
+                                        typename first_var<Ts...>::type>::type type;
+    };
+
+    template <class T>
+    struct first_var<T> { typedef typename std::decay<T>::type type; };
+
+    typedef typename first_var<Arg, Args...>::type var_type;
+    typedef typename std::conditional<std::is_same<Arg, var_type&>::value,
+                                      var_type&, var_type>::type return_type;
+    typedef return_type (*type)(Arg, Args...);
+
+  };
+
+  // Logs the node just created by the var function with the given parameter
+  // types, along with the double arguments of the call in order
+  template <class... Args>
+  inline void record_replay(typename replay_signature<Args...>::type function,
+                            double c1 = 0, double c2 = 0) {
+    if (likely(!replay_log_)) return;
+    typedef typename replay_signature<Args...>::return_type return_type;
+    replay_entry entry = { &replay_call<return_type, Args...>::replay,
+                           reinterpret_cast<void (*)()>(function),
+                           next_node_idx_ - 1, { c1, c2 } };
+    replay_log_->push_back(entry);
+  }
+
+  // A comparison whose outcome decided the structure of a recorded graph,
+  // checked against the replayed values before any later node is replayed.
+  // Operands without a node are the logged constants.
+  enum replay_predicate {
+    guard_less, guard_less_equal, guard_greater, guard_greater_equal,
+    guard_equal, guard_not_equal
+  };
+
+  struct replay_guard {
+    nomad_idx_t node;
+    nomad_idx_t operands[2];
+    double constants[2];
+    replay_predicate predicate;
+    bool taken;
+
+    inline double operand(int k) const {
+      return operands[k] ? var_nodes_[operands[k]].first_val() : constants[k];
+    }
+
+    bool holds() const {
+      const double x = operand(0);
+      const double y = operand(1);
+      bool outcome = false;
+      switch (predicate) {
+        case guard_less:          outcome = x < y;  break;
+        case guard_less_equal:    outcome = x <= y; break;
+        case guard_greater:       outcome = x > y;  break;
+        case guard_greater_equal: outcome = x >= y; break;
+        case guard_equal:         outcome = x == y; break;
+        case guard_not_equal:     outcome = x != y; break;
+      }
+      return outcome == taken;
+    }
+  };
+
+  thread_local std::vector<replay_guard>* replay_guard_log_ = 0;
+
+  inline void guard_operand(double x, nomad_idx_t& node, double& constant) {
+    node = 0;
+    constant = x;
+  }
+
+  template <short AutodiffOrder, bool StrictSmoothness, bool ValidateIO>
+  inline void guard_operand(const var<AutodiffOrder, StrictSmoothness, ValidateIO>& v,
+                            nomad_idx_t& node, double& constant) {
+    node = v.node();
+    constant = 0;
+  }
+
+  // Logs the outcome of a comparison on the value of a var and returns it
+  template <class T1, class T2>
+  inline bool record_guard(replay_predicate predicate, const T1& x, const T2& y, bool taken) {
+    if (likely(!replay_guard_log_)) return taken;
+    replay_guard guard;
+    guard.node = next_node_idx_;
+    guard_operand(x, guard.operands[0], guard.constants[0]);
+    guard_operand(y, guard.operands[1], guard.constants[1]);
+    guard.predicate = predicate;
+    guard.taken = taken;
+    replay_guard_log_->push_back(guard);
+    return taken;
+  }
+
+  // Logs the node just created with a thunk that rebuilds the call itself,
+  // for functions whose arguments are not scalars.  The thunk positions the
+  // stacks itself, and is logged without a function so that the stacks are
+  // positioned again before the next node.
+  inline void record_custom_replay(void (*replay)(const replay_entry& entry)) {
+    if (likely(!replay_log_)) return;
+    replay_entry entry = { replay, 0, next_node_idx_ - 1, { 0, 0 } };
+    replay_log_->push_back(entry);
+  }
+
+}
+
+#endif
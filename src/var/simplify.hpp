@@ -0,0 +1,335 @@
+#ifndef nomad__src__var__simplify_hpp
+#define nomad__src__var__simplify_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <src/autodiff/autodiff_stack.hpp>
+#include <src/var/replay.hpp>
+#include <src/var/var_node.hpp>
+
+namespace nomad {
+
+  class simplified_recording;
+
+  thread_local simplified_recording* simplified_recording_ = 0;
+
+  // While in scope, every node created by a var function on the calling
+  // thread is simplified as soon as it is complete:
+  //
+  //  - a node whose inputs are all constants, the leaves created after the
+  //    first n_inputs, is folded into a constant leaf with its value;
+  //  - an identity, such as a sum with a zero constant or a product with a
+  //    unit constant, is elided in favor of its input;
+  //  - a node with the same kind, inputs, value, and partials as an earlier
+  //    node is elided in favor of that node.
+  //
+  // Every simplification keeps the value and derivatives of every node at
+  // the point of recording.  While a tape records, identities that only
+  // hold at that point are kept and nodes are merged only when they were
+  // logged with the same function and constants, so that the tape replays
+  // correctly at other points.
+  class simplified_recording {
+  public:
+
+    explicit simplified_recording(nomad_idx_t n_inputs):
+    n_inputs_(n_inputs), stack_(0), last_idx_(0), n_nodes_(0), generation_(1),
+    n_folded_(0), n_elided_(0), n_merged_(0),
+    enclosing_(simplified_recording_) {
+      simplified_recording_ = this;
+    }
+
+    ~simplified_recording() { simplified_recording_ = enclosing_; }
+
+    simplified_recording(const simplified_recording&) = delete;
+    simplified_recording& operator=(const simplified_recording&) = delete;
+
+    nomad_idx_t n_inputs() const { return n_inputs_; }
+
+    // Number of nodes folded, elided as identities, and merged so far
+    std::size_t n_folded() const { return n_folded_; }
+    std::size_t n_elided() const { return n_elided_; }
+    std::size_t n_merged() const { return n_merged_; }
+
+    // Simplifies the node just created, returning the node that stands for it
+    template <short AutodiffOrder>
+    nomad_idx_t commit(nomad_idx_t node_idx) {
+
+      // Nodes recorded since a reset, a rewind, or in another context
+      // invalidate the earlier nodes
+      if (var_nodes_ != stack_ || node_idx <= last_idx_) {
+        if (++generation_ == 0) {
+          for (std::size_t i = 0; i < slots_.size(); ++i) slots_[i].generation = 0;
+          generation_ = 1;
+        }
+        n_nodes_ = 0;
+        stack_ = var_nodes_;
+      }
+
+      var_node_base& node = var_nodes_[node_idx];
+      if (!node.n_inputs()) return node_idx;
+
+      const bool logged = replay_log_ && !replay_log_->empty()
+                          && replay_log_->back().node == node_idx;
+
+      if (inputs_constant<AutodiffOrder>(node_idx)) {
+        const double val = node.first_val();
+        discard(node_idx, logged);
+        create_node<var_node<AutodiffOrder, 0>>(0);
+        push_dual_numbers<AutodiffOrder, false>(val);
+        ++n_folded_;
+        last_idx_ = node_idx;
+        return node_idx;
+      }
+
+      const nomad_idx_t identity = identity_input<AutodiffOrder>(node_idx, replay_log_ != 0);
+
+      if (identity) {
+        discard(node_idx, logged);
+        ++n_elided_;
+        last_idx_ = node_idx - 1;
+        return identity;
+      }
+
+      const std::size_t key = hash(node_idx, logged);
+      const std::size_t entry = logged ? replay_log_->size() - 1 : no_entry;
+
+      if (2 * (n_nodes_ + 1) > slots_.size()) grow();
+
+      const std::size_t mask = slots_.size() - 1;
+
+      for (std::size_t i = key & mask; ; i = (i + 1) & mask) {
+        recorded_node& slot = slots_[i];
+
+        if (slot.generation != generation_) {
+          slot.key = key;
+          slot.node = node_idx;
+          slot.entry = entry;
+          slot.generation = generation_;
+          ++n_nodes_;
+          last_idx_ = node_idx;
+          return node_idx;
+        }
+
+        if (slot.key == key && same(slot, node_idx, entry)) {
+          discard(node_idx, logged);
+          ++n_merged_;
+          last_idx_ = node_idx - 1;
+          return slot.node;
+        }
+      }
+
+    }
+
+  private:
+
+    static const std::size_t no_entry = static_cast<std::size_t>(-1);
+
+    // Open addressing table of the nodes recorded so far, with the slots
+    // of earlier generations free
+    struct recorded_node {
+      std::size_t key;
+      std::size_t entry;
+      nomad_idx_t node;
+      unsigned int generation;
+    };
+
+    void grow() {
+      std::vector<recorded_node> slots(slots_.empty() ? 256 : 2 * slots_.size());
+      for (std::size_t i = 0; i < slots.size(); ++i) slots[i].generation = 0;
+
+      const std::size_t mask = slots.size() - 1;
+
+      for (std::size_t i = 0; i < slots_.size(); ++i) {
+        if (slots_[i].generation != generation_) continue;
+        std::size_t j = slots_[i].key & mask;
+        while (slots[j].generation == generation_) j = (j + 1) & mask;
+        slots[j] = slots_[i];
+      }
+
+      slots_.swap(slots);
+    }
+
+    inline nomad_idx_t n_node_partials(nomad_idx_t node_idx) const {
+      const nomad_idx_t end = node_idx + 1 < next_node_idx_ ?
+                              var_nodes_[node_idx + 1].partials() : next_partials_idx_;
+      return end - var_nodes_[node_idx].partials();
+    }
+
+    inline bool constant(nomad_idx_t node_idx) const {
+      return node_idx > n_inputs_ && var_nodes_[node_idx].n_inputs() == 0;
+    }
+
+    inline bool constant(nomad_idx_t node_idx, double val) const {
+      return constant(node_idx) && var_nodes_[node_idx].first_val() == val;
+    }
+
+    template <short AutodiffOrder>
+    bool inputs_constant(nomad_idx_t node_idx) const {
+      const nomad_idx_t n = var_nodes_[node_idx].n_inputs();
+      for (nomad_idx_t k = 0; k < n; ++k)
+        if (!constant(input_node<AutodiffOrder>(node_idx, k))) return false;
+      return n > 0;
+    }
+
+    // Input that the node reproduces, or zero when there is none
+    template <short AutodiffOrder>
+    nomad_idx_t identity_input(nomad_idx_t node_idx, bool recording_tape) const {
+
+      var_node_base& node = var_nodes_[node_idx];
+      const nomad_idx_t a = input_node<AutodiffOrder>(node_idx, 0);
+
+      switch (node.opcode()) {
+
+        case var_node_opcode(binary_sum_var_node_kind): {
+          const nomad_idx_t b = input_node<AutodiffOrder>(node_idx, 1);
+          if (constant(b, 0)) return a;
+          if (constant(a, 0)) return b;
+          return 0;
+        }
+
+        case var_node_opcode(binary_minus_var_node_kind):
+          return constant(input_node<AutodiffOrder>(node_idx, 1), 0) ? a : 0;
+
+        case var_node_opcode(multiply_var_node_kind): {
+          const nomad_idx_t b = input_node<AutodiffOrder>(node_idx, 1);
+          if (constant(b, 1)) return a;
+          if (constant(a, 1)) return b;
+          return 0;
+        }
+
+        default: break;
+
+      }
+
+      // A unary node reproducing the value of its input with a unit first
+      // partial and no higher partials, which only holds at this point
+      if (recording_tape || node.n_inputs() != 1) return 0;
+
+      const unsigned char kind = node.opcode() >> 2;
+      if (kind != unary_var_node_kind && kind != unary_plus_var_node_kind) return 0;
+      if (node.first_val() != var_nodes_[a].first_val()) return 0;
+
+      const nomad_idx_t n_partials = n_node_partials(node_idx);
+      if (kind == unary_var_node_kind && AutodiffOrder >= 1 && n_partials == 0) return 0;
+
+      for (nomad_idx_t k = 0; k < n_partials; ++k)
+        if (node.first_partials(k) != (k == 0 ? 1 : 0)) return 0;
+
+      return a;
+
+    }
+
+    std::size_t hash(nomad_idx_t node_idx, bool logged) const {
+      var_node_base& node = var_nodes_[node_idx];
+
+      std::size_t h = node.opcode();
+      combine(h, node.n_inputs());
+      for (nomad_idx_t k = 0; k < node.n_inputs(); ++k)
+        combine(h, node.input(k));
+      combine(h, bits(node.first_val()));
+
+      const nomad_idx_t n_partials = n_node_partials(node_idx);
+      for (nomad_idx_t k = 0; k < n_partials; ++k)
+        combine(h, bits(node.first_partials(k)));
+
+      if (logged) {
+        const replay_entry& e = replay_log_->back();
+        combine(h, reinterpret_cast<std::size_t>(e.replay));
+        combine(h, reinterpret_cast<std::size_t>(e.function));
+        combine(h, bits(e.constants[0]));
+        combine(h, bits(e.constants[1]));
+      }
+
+      return h ^ (h >> 32);
+    }
+
+    static inline void combine(std::size_t& h, std::size_t x) {
+      h = (h ^ x) * 0x9e3779b97f4a7c15ULL;
+    }
+
+    // Bits of a double, with both zeros alike since they compare equal
+    static inline std::size_t bits(double x) {
+      x += 0.0;
+      std::uint64_t b;
+      std::memcpy(&b, &x, sizeof(b));
+      return static_cast<std::size_t>(b);
+    }
+
+    bool same(const recorded_node& recorded, nomad_idx_t node_idx, std::size_t entry) const {
+      var_node_base& x = var_nodes_[recorded.node];
+      var_node_base& y = var_nodes_[node_idx];
+
+      if (x.opcode() != y.opcode() || x.n_inputs() != y.n_inputs()) return false;
+      if (x.first_val() != y.first_val()) return false;
+
+      for (nomad_idx_t k = 0; k < x.n_inputs(); ++k)
+        if (x.input(k) != y.input(k)) return false;
+
+      const nomad_idx_t n_partials = n_node_partials(node_idx);
+      if (n_node_partials(recorded.node) != n_partials) return false;
+
+      for (nomad_idx_t k = 0; k < n_partials; ++k)
+        if (x.first_partials(k) != y.first_partials(k)) return false;
+
+      if ((recorded.entry == no_entry) != (entry == no_entry)) return false;
+
+      if (entry != no_entry) {
+        const replay_entry& e = (*replay_log_)[recorded.entry];
+        const replay_entry& f = (*replay_log_)[entry];
+        if (e.replay != f.replay || e.function != f.function
+            || e.constants[0] != f.constants[0] || e.constants[1] != f.constants[1])
+          return false;
+      }
+
+      return true;
+    }
+
+    // Removes the node just created, along with its replay entry
+    static inline void discard(nomad_idx_t node_idx, bool logged) {
+      if (logged) replay_log_->pop_back();
+      rewind_stacks(node_idx);
+    }
+
+    nomad_idx_t n_inputs_;
+    var_node_base* stack_;
+    nomad_idx_t last_idx_;
+    std::vector<recorded_node> slots_;
+    std::size_t n_nodes_;
+    unsigned int generation_;
+
+    std::size_t n_folded_;
+    std::size_t n_elided_;
+    std::size_t n_merged_;
+
+    simplified_recording* enclosing_;
+
+  };
+
+  // Suspends simplification on the calling thread for the lifetime of the
+  // scope, for code that rebuilds recorded nodes in place
+  class unsimplified_recording {
+  public:
+    unsimplified_recording(): enclosing_(simplified_recording_) { simplified_recording_ = 0; }
+    ~unsimplified_recording() { simplified_recording_ = enclosing_; }
+
+    unsimplified_recording(const unsimplified_recording&) = delete;
+    unsimplified_recording& operator=(const unsimplified_recording&) = delete;
+
+  private:
+    simplified_recording* enclosing_;
+  };
+
+  // Index of the node just created by a var function, or of the node that
+  // stands for it while recording is simplified
+  template <short AutodiffOrder>
+  inline nomad_idx_t commit_node() {
+    if (likely(!simplified_recording_)) return next_node_idx_ - 1;
+    return simplified_recording_->commit<AutodiffOrder>(next_node_idx_ - 1);
+  }
+
+}
+
+#endif
@@ -5,9 +5,32 @@
 #include <string>
 
 #include <src/autodiff/autodiff_stack.hpp>
+#include <src/autodiff/direction_numbers.hpp>
+#include <src/autodiff/dual_number_layout.hpp>
 
 namespace nomad {
   
+  // Each node records its kind and the order of the partials it stores in a
+  // one byte opcode, which the sweeps in var_node_dispatch.hpp switch on in
+  // place of a virtual call
+  enum var_node_kind {
+    generic_var_node_kind,
+    unary_var_node_kind,
+    binary_var_node_kind,
+    binary_sum_var_node_kind,
+    binary_minus_var_node_kind,
+    dot_var_node_kind,
+    multi_sum_var_node_kind,
+    multiply_var_node_kind,
+    square_var_node_kind,
+    unary_minus_var_node_kind,
+    unary_plus_var_node_kind
+  };
+  
+  constexpr unsigned char var_node_opcode(var_node_kind kind, short partials_order = 0) {
+    return static_cast<unsigned char>((kind << 2) | partials_order);
+  }
+  
   class var_node_base {
   protected:
     
@@ -15,11 +38,12 @@ namespace nomad {
     nomad_idx_t partials_idx_;
     nomad_idx_t inputs_idx_;
     
-    nomad_idx_t n_inputs_;
+    nomad_idx_t n_inputs_: 24;
+    nomad_idx_t opcode_: 8;
     
   public:
     
-    var_node_base(): n_inputs_(0) {
+    explicit var_node_base(unsigned char opcode): n_inputs_(0), opcode_(opcode) {
 
       dual_numbers_idx_ = next_dual_number_idx_;
       partials_idx_ = next_partials_idx_;
@@ -29,8 +53,8 @@ namespace nomad {
     
     }
 
-    var_node_base(nomad_idx_t n_inputs):
-    n_inputs_(n_inputs) {
+    var_node_base(nomad_idx_t n_inputs, unsigned char opcode):
+    n_inputs_(n_inputs), opcode_(opcode) {
       
       dual_numbers_idx_ = next_dual_number_idx_;
       partials_idx_ = next_partials_idx_;
@@ -39,20 +63,33 @@ namespace nomad {
       next_node_idx_++;
     }
     
-    virtual ~var_node_base();
-    
-    var_node_base& operator=(const var_node_base& rhs) {
-      dual_numbers_idx_ = rhs.dual_numbers();
-      partials_idx_ = rhs.partials();
-      inputs_idx_ = rhs.inputs();
-      n_inputs_ = n_inputs();
-      return *this;
-    }
+    // Nodes are constructed in place on the node stack and never copied
+    var_node_base(const var_node_base&) = delete;
+    var_node_base& operator=(const var_node_base&) = delete;
 
     inline nomad_idx_t dual_numbers() const { return dual_numbers_idx_; }
     inline nomad_idx_t partials() const { return partials_idx_; }
     inline nomad_idx_t inputs() const { return inputs_idx_; }
     inline nomad_idx_t n_inputs() const { return n_inputs_; }
+    inline unsigned char opcode() const { return opcode_; }
+
+    // Copies the node into another slot of the node stack with its dual
+    // numbers, partials, and inputs at the given positions, see compact.hpp
+    inline void relocate(var_node_base& target, nomad_idx_t dual_numbers_idx,
+                         nomad_idx_t partials_idx, nomad_idx_t inputs_idx) const {
+      relocate(target, dual_numbers_idx, partials_idx, inputs_idx, opcode_, n_inputs_);
+    }
+
+    // As above, with the node taking on another kind and number of inputs
+    inline void relocate(var_node_base& target, nomad_idx_t dual_numbers_idx,
+                         nomad_idx_t partials_idx, nomad_idx_t inputs_idx,
+                         unsigned char opcode, nomad_idx_t n_inputs) const {
+      target.dual_numbers_idx_ = dual_numbers_idx;
+      target.partials_idx_ = partials_idx;
+      target.inputs_idx_ = inputs_idx;
+      target.n_inputs_ = n_inputs;
+      target.opcode_ = opcode;
+    }
     
     nomad_idx_t input() { return inputs_[inputs_idx_]; }
     nomad_idx_t input(unsigned int k) { return inputs_[inputs_idx_ + k]; }
@@ -63,41 +100,51 @@ namespace nomad {
     //nomad_idx_t begin() { return inputs_[inputs_idx_]; }
     //nomad_idx_t end() { return inputs_[inputs_idx_ + n_inputs_]; }
     
-    inline double& first_val()   { return dual_numbers_[dual_numbers_idx_];     }
-    inline double& first_grad()  { return dual_numbers_[dual_numbers_idx_ + 1]; }
-    inline double& second_val()  { return dual_numbers_[dual_numbers_idx_ + 2]; }
-    inline double& second_grad() { return dual_numbers_[dual_numbers_idx_ + 3]; }
-    inline double& third_val()   { return dual_numbers_[dual_numbers_idx_ + 4]; }
-    inline double& third_grad()  { return dual_numbers_[dual_numbers_idx_ + 5]; }
-    inline double& fourth_val()  { return dual_numbers_[dual_numbers_idx_ + 6]; }
-    inline double& fourth_grad() { return dual_numbers_[dual_numbers_idx_ + 7]; }
-    
-    inline static double& first_val(nomad_idx_t idx)   { return dual_numbers_[idx];     }
-    inline static double& first_grad(nomad_idx_t idx)  { return dual_numbers_[idx + 1]; }
-    inline static double& second_val(nomad_idx_t idx)  { return dual_numbers_[idx + 2]; }
-    inline static double& second_grad(nomad_idx_t idx) { return dual_numbers_[idx + 3]; }
-    inline static double& third_val(nomad_idx_t idx)   { return dual_numbers_[idx + 4]; }
-    inline static double& third_grad(nomad_idx_t idx)  { return dual_numbers_[idx + 5]; }
-    inline static double& fourth_val(nomad_idx_t idx)  { return dual_numbers_[idx + 6]; }
-    inline static double& fourth_grad(nomad_idx_t idx) { return dual_numbers_[idx + 7]; }
+    inline double& first_val()   { return dual_number_layout::lane<0>(dual_numbers_idx_); }
+    inline double& first_grad()  { return dual_number_layout::lane<1>(dual_numbers_idx_); }
+    inline double& second_val()  { return dual_number_layout::lane<2>(dual_numbers_idx_); }
+    inline double& second_grad() { return dual_number_layout::lane<3>(dual_numbers_idx_); }
+    inline double& third_val()   { return dual_number_layout::lane<4>(dual_numbers_idx_); }
+    inline double& third_grad()  { return dual_number_layout::lane<5>(dual_numbers_idx_); }
+    inline double& fourth_val()  { return dual_number_layout::lane<6>(dual_numbers_idx_); }
+    inline double& fourth_grad() { return dual_number_layout::lane<7>(dual_numbers_idx_); }
+    
+    inline static double& first_val(nomad_idx_t idx)   { return dual_number_layout::lane<0>(idx); }
+    inline static double& first_grad(nomad_idx_t idx)  { return dual_number_layout::lane<1>(idx); }
+    inline static double& second_val(nomad_idx_t idx)  { return dual_number_layout::lane<2>(idx); }
+    inline static double& second_grad(nomad_idx_t idx) { return dual_number_layout::lane<3>(idx); }
+    inline static double& third_val(nomad_idx_t idx)   { return dual_number_layout::lane<4>(idx); }
+    inline static double& third_grad(nomad_idx_t idx)  { return dual_number_layout::lane<5>(idx); }
+    inline static double& fourth_val(nomad_idx_t idx)  { return dual_number_layout::lane<6>(idx); }
+    inline static double& fourth_grad(nomad_idx_t idx) { return dual_number_layout::lane<7>(idx); }
+
+    // The higher-order sweeps read the tangents of one or several
+    // directions through a policy D, see direction_numbers.hpp
+    template<class D> inline typename D::second_type& second_val()  { return D::second_val(dual_numbers_idx_); }
+    template<class D> inline typename D::second_type& second_grad() { return D::second_grad(dual_numbers_idx_); }
+    template<class D> inline typename D::third_type& third_val()    { return D::third_val(dual_numbers_idx_); }
+    template<class D> inline typename D::third_type& third_grad()   { return D::third_grad(dual_numbers_idx_); }
+    template<class D> inline typename D::third_type& fourth_val()   { return D::fourth_val(dual_numbers_idx_); }
+    template<class D> inline typename D::third_type& fourth_grad()  { return D::fourth_grad(dual_numbers_idx_); }
+    
+    template<class D>
+    inline static typename D::second_type& second_val(nomad_idx_t idx)  { return D::second_val(idx); }
+    template<class D>
+    inline static typename D::second_type& second_grad(nomad_idx_t idx) { return D::second_grad(idx); }
+    template<class D>
+    inline static typename D::third_type& third_val(nomad_idx_t idx)    { return D::third_val(idx); }
+    template<class D>
+    inline static typename D::third_type& third_grad(nomad_idx_t idx)   { return D::third_grad(idx); }
+    template<class D>
+    inline static typename D::third_type& fourth_val(nomad_idx_t idx)   { return D::fourth_val(idx); }
+    template<class D>
+    inline static typename D::third_type& fourth_grad(nomad_idx_t idx)  { return D::fourth_grad(idx); }
 
     inline double* first_partials()  { return partials_ + partials_idx_; }
-    inline double* second_partials() { return partials_ + partials_idx_ + n_first_partials(); }
-    inline double* third_partials()  { return partials_ + partials_idx_ + n_first_partials() + n_second_partials(); }
 
     inline double first_partials(nomad_idx_t idx)  {
       return partials_[partials_idx_ + idx];
     }
-    inline double second_partials(nomad_idx_t idx) {
-      return partials_[partials_idx_ + n_first_partials() + idx];
-    }
-    inline double third_partials(nomad_idx_t idx)  {
-      return partials_[partials_idx_ + n_first_partials() + n_second_partials() + idx];
-    }
-    
-    inline virtual nomad_idx_t n_first_partials() { return 0; }
-    inline virtual nomad_idx_t n_second_partials() { return 0; }
-    inline virtual nomad_idx_t n_third_partials() { return 0; }
     
     inline static nomad_idx_t n_partials(unsigned int n_inputs) { (void)n_inputs; return 0; }
 
@@ -131,66 +178,61 @@ namespace nomad {
         *output << std::endl;
       }
       
-      if (n_partials(n_inputs_)) {
-        *output << prefix << "Partials stored at index = " << partials_idx_ << std::endl;
-        
-        if (n_first_partials()) *output << prefix << "First partials: " << std::endl;
-        for (nomad_idx_t i = 0; i < n_first_partials(); ++i)
-          *output << prefix << "  (" << i << ") " << first_partials()[i] << std::endl;
-        
-        if (n_second_partials()) *output << prefix << "Second partials: " << std::endl;
-        for (nomad_idx_t i = 0; i < n_second_partials(); ++i)
-          *output << prefix << "  (" << i << ") " << second_partials()[i] << std::endl;
-        
-        if (n_third_partials()) *output << prefix << "Third partials: " << std::endl;
-        for (nomad_idx_t i = 0; i < n_third_partials(); ++i)
-          *output << prefix << "  (" << i << ") " << third_partials()[i] << std::endl;
-        
-        *output << std::endl;
-      }
-      
     }
     
-    virtual void first_order_forward_adj()  {}
-    virtual void first_order_reverse_adj()  {}
-    virtual void second_order_forward_val() {}
-    virtual void second_order_reverse_adj() {}
-    virtual void third_order_forward_val()  {}
-    virtual void third_order_reverse_adj()  {}
+    // Calls f(k, d node / d input k) for every input, and f(j, k, d^2 node /
+    // d input j d input k) with j <= k for every second partial that is not
+    // identically zero, so that drivers can read the local derivatives of
+    // any node without knowing how it stores them
+    template<class F> inline void local_partials(F& f) { (void)f; }
+    template<class F> inline void local_second_partials(F& f) { (void)f; }
+    
+    // Derived nodes hide the sweeps they implement
+    inline void first_order_forward_adj()  {}
+    inline void first_order_reverse_adj()  {}
+    template<class D> inline void second_order_forward_val() {}
+    template<class D> inline void second_order_reverse_adj() {}
+    template<class D> inline void third_order_forward_val()  {}
+    template<class D> inline void third_order_reverse_adj()  {}
     
   };
   
-  // Out-of-line virtual defintion to prevent weak vtable
-  var_node_base::~var_node_base() {}
-  
-  template<short AutodiffOrder>
   void expand_var_nodes() {
     
-    if (!max_node_idx) {
-      max_node_idx = base_node_size_;
-      var_nodes_ = new var_node_base[max_node_idx];
-      next_node_idx_ -= max_node_idx;
-    } else {
-      max_node_idx *= 2;
-      
-      var_node_base* new_stack = new var_node_base[max_node_idx];
-      for (nomad_idx_t i = 0; i < next_node_idx_; ++i)
-        new_stack[i] = var_nodes_[i];
-      delete[] var_nodes_;
-      
-      var_nodes_ = new_stack;
-    }
+    thread_stacks_guard_.touch();
+    
+    std::size_t min_idx = std::size_t(next_node_idx_) + 1;
+    std::size_t target_idx = stack_growth_target(max_node_idx, base_node_size_,
+                                                 high_water_node_idx_);
     
-    expand_dual_numbers<AutodiffOrder>();
+    // Never commit more nodes than the dual numbers can hold
+    target_idx = expand_dual_numbers(min_idx, target_idx);
+    commit_stack(var_nodes_, max_node_idx, reserved_node_idx, min_idx, target_idx);
     
   }
   
+  void release_stacks() {
+    release_stack(var_nodes_, max_node_idx, reserved_node_idx);
+    next_node_idx_ = 1;
+    
+    dual_number_layout::release();
+    next_dual_number_idx_ = 1;
+    
+    release_stack(partials_, max_partials_idx, reserved_partials_idx);
+    next_partials_idx_ = 1;
+    
+    release_stack(inputs_, max_inputs_idx, reserved_inputs_idx);
+    next_inputs_idx_ = 1;
+    
+    release_stack(direction_numbers_, max_direction_number_idx, reserved_direction_number_idx);
+  }
+  
   template<short AutodiffOrder, short PartialsOrder>
   class var_node: public var_node_base {
   public:
     
     static inline void* operator new(size_t /* ignore */) {
-      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes<AutodiffOrder>();
+      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes();
       if (unlikely(next_partials_idx_ + next_partials_delta > max_partials_idx)) expand_partials();
       if (unlikely(next_inputs_idx_ + next_inputs_delta > max_inputs_idx)) expand_inputs();
       return var_nodes_ + next_node_idx_;
@@ -198,7 +240,8 @@ namespace nomad {
     
     static inline void operator delete(void* /* ignore */) {}
     
-    var_node(nomad_idx_t n_inputs): var_node_base(n_inputs) {}
+    var_node(nomad_idx_t n_inputs):
+    var_node_base(n_inputs, var_node_opcode(generic_var_node_kind, PartialsOrder)) {}
 
     inline nomad_idx_t n_first_partials() {
       return AutodiffOrder >= 1 && PartialsOrder >= 1 ?
@@ -215,21 +258,43 @@ namespace nomad {
              n_inputs_ * (n_inputs_ + 1) * (n_inputs_ + 2) / 6 : 0;
     }
     
+    inline double* second_partials() { return first_partials() + n_first_partials(); }
+    inline double* third_partials()  { return second_partials() + n_second_partials(); }
+    
     inline static nomad_idx_t n_partials(unsigned int n_inputs) {
-      if (AutodiffOrder >= 1 && PartialsOrder >= 1)
-        return n_inputs;
+      // n + n * (n + 1) / 2 + n * (n + 1) * (n + 2) / 6
+      if (AutodiffOrder >= 3 && PartialsOrder >= 3)
+        return n_inputs * (11 + 6 * n_inputs + n_inputs * n_inputs) / 6;
       
       // n + n * (n + 1) / 2
       if (AutodiffOrder >= 2 && PartialsOrder >= 2)
         return n_inputs * (n_inputs + 3) / 2;
       
-      // n + n * (n + 1) / 2 + n * (n + 1) * (n + 2) / 6
-      if (AutodiffOrder >= 3 && PartialsOrder >= 3)
-        return n_inputs * (11 + 6 * n_inputs + n_inputs * n_inputs) / 6;
+      if (AutodiffOrder >= 1 && PartialsOrder >= 1)
+        return n_inputs;
       
       return 0;
     }
     
+    template<class F>
+    inline void local_partials(F& f) {
+      if (PartialsOrder >= 1) {
+        double* first_partial = first_partials();
+        for (nomad_idx_t i = 0; i < n_inputs_; ++i, ++first_partial)
+          f(i, *first_partial);
+      }
+    }
+    
+    template<class F>
+    inline void local_second_partials(F& f) {
+      if (AutodiffOrder >= 2 && PartialsOrder >= 2) {
+        double* second_partial = second_partials();
+        for (nomad_idx_t k = 0; k < n_inputs_; ++k)
+          for (nomad_idx_t j = 0; j <= k; ++j, ++second_partial)
+            f(j, k, *second_partial);
+      }
+    }
+    
     inline void first_order_forward_adj() {
       
       if (n_inputs_) first_grad() = 0;
@@ -258,21 +323,22 @@ namespace nomad {
       
     }
     
+    template<class D>
     void second_order_forward_val() {
       
       if (AutodiffOrder >= 2) {
         
-        if (n_inputs_) second_val() = 0;
-        second_grad() = 0;
+        if (n_inputs_) second_val<D>() = 0;
+        second_grad<D>() = 0;
         
         if (PartialsOrder >= 1) {
           
           double* first_partial = first_partials();
-          double v2 = 0;
+          typename D::second_type v2 = 0;
           
           for (nomad_idx_t i = 0; i < n_inputs_; ++i, ++first_partial)
-            v2 += second_val(input(i)) * *first_partial;
-          second_val() += v2;
+            v2 += second_val<D>(input(i)) * *first_partial;
+          second_val<D>() += v2;
           
         }
         
@@ -280,6 +346,7 @@ namespace nomad {
       
     }
     
+    template<class D>
     void second_order_reverse_adj() {
       
       if (AutodiffOrder >= 2) {
@@ -287,10 +354,10 @@ namespace nomad {
         if (PartialsOrder >= 1) {
           
           double* first_partial = first_partials();
-          const double g = second_grad();
+          const typename D::second_type g = second_grad<D>();
           
           for (nomad_idx_t i = 0; i < n_inputs_; ++i, ++first_partial)
-            second_grad(input(i)) += g * *first_partial;
+            second_grad<D>(input(i)) += g * *first_partial;
           
         }
         
@@ -300,19 +367,19 @@ namespace nomad {
           
           for (nomad_idx_t i = 0; i < n_inputs_; ++i) {
             
-            double g2 = 0;
+            typename D::second_type g2 = 0;
             
             double* second_partial = second_partials() + i * (i + 1) / 2;
             for (nomad_idx_t j = 0; j < n_inputs_; ++j) {
               
-              g2 += g1 * second_val(input(j)) * *second_partial;
+              g2 += g1 * second_val<D>(input(j)) * *second_partial;
               
               if (j < i) ++second_partial;
               else       second_partial += j + 1;
               
             }
             
-            second_grad(input(i)) += g2;
+            second_grad<D>(input(i)) += g2;
             
           }
           
@@ -322,40 +389,41 @@ namespace nomad {
       
     }
     
+    template<class D>
     void third_order_forward_val() {
       
       if (AutodiffOrder >= 3) {
         
         if (n_inputs_) {
-          third_val() = 0;
-          fourth_val() = 0;
+          third_val<D>() = 0;
+          fourth_val<D>() = 0;
         }
         
-        third_grad() = 0;
-        fourth_grad() = 0;
+        third_grad<D>() = 0;
+        fourth_grad<D>() = 0;
         
         if (PartialsOrder >= 1) {
           
           double* first_partial = first_partials();
-          double v3 = 0;
-          double v4 = 0;
+          typename D::third_type v3 = 0;
+          typename D::third_type v4 = 0;
           
           for (nomad_idx_t i = 0; i < n_inputs_; ++i, ++first_partial) {
-            v3 += third_val(input(i)) * *first_partial;
-            v4 += fourth_val(input(i)) * *first_partial;
+            v3 += third_val<D>(input(i)) * *first_partial;
+            v4 += fourth_val<D>(input(i)) * *first_partial;
           }
-          third_val() += v3;
-          fourth_val() += v4;
+          third_val<D>() += v3;
+          fourth_val<D>() += v4;
           
         }
         
         if (PartialsOrder >= 2) {
           
-          double v4 = 0;
+          typename D::third_type v4 = 0;
           
           for (nomad_idx_t i = 0; i < n_inputs_; ++i) {
             
-            const double s2 = second_val(input(i));
+            const typename D::second_type s2 = second_val<D>(input(i));
             
             // Benchmark in future
             //if(s2 == 0) continue;
@@ -363,7 +431,7 @@ namespace nomad {
             double* second_partial = second_partials() + i * (i + 1) / 2;
             for (nomad_idx_t j = 0; j < n_inputs_; ++j) {
               
-              v4 += s2 * third_val(input(j)) * *second_partial;
+              v4 += s2 * third_val<D>(input(j)) * *second_partial;
               
               if (j < i) ++second_partial;
               else       second_partial += j + 1;
@@ -371,7 +439,7 @@ namespace nomad {
             }
           }
 
-          fourth_val() += v4;
+          fourth_val<D>() += v4;
           
         }
         
@@ -379,22 +447,23 @@ namespace nomad {
       
     } // third_order_forward_val
     
+    template<class D>
     void third_order_reverse_adj() {
       
       if (AutodiffOrder >= 3) {
 
         const double g1 = first_grad();
-        const double g2 = second_grad();
-        const double g3 = third_grad();
-        const double g4 = fourth_grad();
+        const typename D::second_type g2 = second_grad<D>();
+        const typename D::third_type g3 = third_grad<D>();
+        const typename D::third_type g4 = fourth_grad<D>();
         
         if (PartialsOrder >= 1) {
           
           double* first_partial = first_partials();
           
           for (nomad_idx_t i = 0; i < n_inputs_; ++i, ++first_partial) {
-            third_grad(input(i))  += g3 * *first_partial;
-            fourth_grad(input(i)) += g4 * *first_partial;
+            third_grad<D>(input(i))  += g3 * *first_partial;
+            fourth_grad<D>(input(i)) += g4 * *first_partial;
           }
         }
         
@@ -402,8 +471,8 @@ namespace nomad {
           
           for (nomad_idx_t i = 0; i < n_inputs_; ++i) {
             
-            double in_g3 = 0;
-            double in_g4 = 0;
+            typename D::third_type in_g3 = 0;
+            typename D::third_type in_g4 = 0;
             
             double* second_partial = second_partials() + i * (i + 1) / 2;
             for (nomad_idx_t j = 0; j < n_inputs_; ++j) {
@@ -417,11 +486,11 @@ namespace nomad {
               }
               */
               
-              in_g3 += g1 * third_val(input(j)) * *second_partial;
+              in_g3 += g1 * third_val<D>(input(j)) * *second_partial;
               
-              double alpha =   g1 * fourth_val(input(j))
-                             + g2 * third_val(input(j))
-                             + g3 * second_val(input(j));
+              typename D::third_type alpha =   g1 * fourth_val<D>(input(j))
+                                             + g2 * third_val<D>(input(j))
+                                             + g3 * second_val<D>(input(j));
               
               in_g4 += alpha * *second_partial;
               
@@ -430,8 +499,8 @@ namespace nomad {
 
             }
 
-            third_grad(input(i)) += in_g3;
-            fourth_grad(input(i)) += in_g4;
+            third_grad<D>(input(i)) += in_g3;
+            fourth_grad<D>(input(i)) += in_g4;
             
           }
           
@@ -441,11 +510,11 @@ namespace nomad {
 
           for (nomad_idx_t i = 0; i < n_inputs_; ++i) {
             
-            double in_g4 = 0;
+            typename D::third_type in_g4 = 0;
             
             for (nomad_idx_t j = 0; j < n_inputs_; ++j) {
               
-              const double in_v2 = second_val(input(j));
+              const typename D::second_type in_v2 = second_val<D>(input(j));
               
               double* third_partial = third_partials();
               
@@ -458,7 +527,7 @@ namespace nomad {
 
                 in_g4 +=   g1
                          * in_v2
-                         * third_val(input(k))
+                         * third_val<D>(input(k))
                          * *third_partial;
  
                 if (k < i) {
@@ -474,7 +543,7 @@ namespace nomad {
               
             }
             
-            fourth_grad(input(i)) += in_g4;
+            fourth_grad<D>(input(i)) += in_g4;
             
           }
           
@@ -492,7 +561,7 @@ namespace nomad {
   public:
     
     static inline void* operator new(size_t /* ignore */) {
-      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes<AutodiffOrder>();
+      if (unlikely(next_node_idx_ + 1 > max_node_idx)) expand_var_nodes();
       // no partials
       // no inputs
       return var_nodes_ + next_node_idx_;
@@ -500,18 +569,20 @@ namespace nomad {
     
     static inline void operator delete(void* /* ignore */) {}
     
-    var_node(): var_node_base() {}
+    var_node(): var_node_base(var_node_opcode(generic_var_node_kind)) {}
     
     constexpr static bool dynamic_inputs() { return false; }
     inline static nomad_idx_t n_partials() { return 0; }
     
+    template<class D>
     void second_order_forward_val() {
-      second_grad() = 0;
+      second_grad<D>() = 0;
     }
     
+    template<class D>
     void third_order_forward_val() {
-      third_grad() = 0;
-      fourth_grad() = 0;
+      third_grad<D>() = 0;
+      fourth_grad<D>() = 0;
     }
     
   };
@@ -0,0 +1,130 @@
+#ifndef nomad__src__var__var_node_dispatch_hpp
+#define nomad__src__var__var_node_dispatch_hpp
+
+#include <string>
+
+#include <src/autodiff/exceptions.hpp>
+#include <src/var/var_node.hpp>
+#include <src/var/derived/binary_minus_var_node.hpp>
+#include <src/var/derived/binary_sum_var_node.hpp>
+#include <src/var/derived/binary_var_node.hpp>
+#include <src/var/derived/dot_var_node.hpp>
+#include <src/var/derived/multi_sum_var_node.hpp>
+#include <src/var/derived/multiply_var_node.hpp>
+#include <src/var/derived/square_var_node.hpp>
+#include <src/var/derived/unary_minus_var_node.hpp>
+#include <src/var/derived/unary_plus_var_node.hpp>
+#include <src/var/derived/unary_var_node.hpp>
+
+namespace nomad {
+
+  // The sweeps that can be applied to a node, with the higher-order sweeps
+  // carrying the directions of a policy from direction_numbers.hpp
+
+  struct first_order_forward_sweep {
+    template<class Node> inline void operator()(Node& node) const { node.first_order_forward_adj(); }
+  };
+
+  struct first_order_reverse_sweep {
+    template<class Node> inline void operator()(Node& node) const { node.first_order_reverse_adj(); }
+  };
+
+  template<class Directions>
+  struct second_order_forward_sweep {
+    template<class Node>
+    inline void operator()(Node& node) const { node.template second_order_forward_val<Directions>(); }
+  };
+
+  template<class Directions>
+  struct second_order_reverse_sweep {
+    template<class Node>
+    inline void operator()(Node& node) const { node.template second_order_reverse_adj<Directions>(); }
+  };
+
+  template<class Directions>
+  struct third_order_forward_sweep {
+    template<class Node>
+    inline void operator()(Node& node) const { node.template third_order_forward_val<Directions>(); }
+  };
+
+  template<class Directions>
+  struct third_order_reverse_sweep {
+    template<class Node>
+    inline void operator()(Node& node) const { node.template third_order_reverse_adj<Directions>(); }
+  };
+
+  // Calls the visitor with the node cast to its concrete class.  Every node
+  // of a graph shares the order of the graph, so only the kind and the
+  // partials order recorded in the opcode select the class.
+  template<short AutodiffOrder, class Visitor>
+  inline void visit_node(var_node_base& node, Visitor& visitor) {
+
+    switch (node.opcode()) {
+
+      case var_node_opcode(generic_var_node_kind, 0):
+        visitor(static_cast<var_node<AutodiffOrder, 0>&>(node)); break;
+      case var_node_opcode(generic_var_node_kind, 1):
+        visitor(static_cast<var_node<AutodiffOrder, 1>&>(node)); break;
+      case var_node_opcode(generic_var_node_kind, 2):
+        visitor(static_cast<var_node<AutodiffOrder, 2>&>(node)); break;
+      case var_node_opcode(generic_var_node_kind, 3):
+        visitor(static_cast<var_node<AutodiffOrder, 3>&>(node)); break;
+
+      case var_node_opcode(unary_var_node_kind, 0):
+        visitor(static_cast<unary_var_node<AutodiffOrder, 0>&>(node)); break;
+      case var_node_opcode(unary_var_node_kind, 1):
+        visitor(static_cast<unary_var_node<AutodiffOrder, 1>&>(node)); break;
+      case var_node_opcode(unary_var_node_kind, 2):
+        visitor(static_cast<unary_var_node<AutodiffOrder, 2>&>(node)); break;
+      case var_node_opcode(unary_var_node_kind, 3):
+        visitor(static_cast<unary_var_node<AutodiffOrder, 3>&>(node)); break;
+
+      case var_node_opcode(binary_var_node_kind, 0):
+        visitor(static_cast<binary_var_node<AutodiffOrder, 0>&>(node)); break;
+      case var_node_opcode(binary_var_node_kind, 1):
+        visitor(static_cast<binary_var_node<AutodiffOrder, 1>&>(node)); break;
+      case var_node_opcode(binary_var_node_kind, 2):
+        visitor(static_cast<binary_var_node<AutodiffOrder, 2>&>(node)); break;
+      case var_node_opcode(binary_var_node_kind, 3):
+        visitor(static_cast<binary_var_node<AutodiffOrder, 3>&>(node)); break;
+
+      case var_node_opcode(binary_sum_var_node_kind):
+        visitor(static_cast<binary_sum_var_node<AutodiffOrder>&>(node)); break;
+      case var_node_opcode(binary_minus_var_node_kind):
+        visitor(static_cast<binary_minus_var_node<AutodiffOrder>&>(node)); break;
+      case var_node_opcode(dot_var_node_kind):
+        visitor(static_cast<dot_var_node<AutodiffOrder>&>(node)); break;
+      case var_node_opcode(multi_sum_var_node_kind):
+        visitor(static_cast<multi_sum_var_node<AutodiffOrder>&>(node)); break;
+      case var_node_opcode(multiply_var_node_kind):
+        visitor(static_cast<multiply_var_node<AutodiffOrder>&>(node)); break;
+      case var_node_opcode(square_var_node_kind):
+        visitor(static_cast<square_var_node<AutodiffOrder>&>(node)); break;
+      case var_node_opcode(unary_minus_var_node_kind):
+        visitor(static_cast<unary_minus_var_node<AutodiffOrder>&>(node)); break;
+      case var_node_opcode(unary_plus_var_node_kind):
+        visitor(static_cast<unary_plus_var_node<AutodiffOrder>&>(node)); break;
+
+      default:
+        throw nomad_error("Nomad sweep encountered a node with the unknown opcode "
+                          + std::to_string(static_cast<int>(node.opcode())));
+
+    }
+
+  }
+
+  // Applies a sweep to the nodes 1 through last_idx on the node stack, in
+  // reverse order if requested
+  template<short AutodiffOrder, class Sweep, bool Reverse>
+  void sweep_nodes(nomad_idx_t last_idx) {
+
+    Sweep sweep;
+
+    for (nomad_idx_t n = 1; n <= last_idx; ++n)
+      visit_node<AutodiffOrder>(var_nodes_[Reverse ? last_idx + 1 - n : n], sweep);
+
+  }
+
+}
+
+#endif